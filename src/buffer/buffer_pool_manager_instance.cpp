@@ -12,102 +12,304 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <algorithm>
+#include <cstring>
+#include <future>  // NOLINT
+#include <new>
+
 #include "common/macros.h"
 
 namespace bustub {
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
-                                                     LogManager *log_manager)
-    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager) {}
+                                                     LogManager *log_manager, ReplacerType replacer_type)
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager, replacer_type) {}
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                                                     DiskManager *disk_manager, LogManager *log_manager)
+                                                     DiskManager *disk_manager, LogManager *log_manager,
+                                                     ReplacerType replacer_type)
     : pool_size_(pool_size),
+      max_pool_size_(pool_size * BUFFER_POOL_MAX_GROWTH),
       num_instances_(num_instances),
       instance_index_(instance_index),
-      next_page_id_(instance_index),
+      frame_arena_(max_pool_size_, enable_huge_page_frames),
       disk_manager_(disk_manager),
-      log_manager_(log_manager) {
+      log_manager_(log_manager),
+      page_table_(max_pool_size_),
+      frame_io_state_(max_pool_size_),
+      frame_owner_(max_pool_size_) {
   BUSTUB_ASSERT(num_instances > 0, "If BPI is not part of a pool, then the pool size should just be 1");
   BUSTUB_ASSERT(
       instance_index < num_instances,
       "BPI index cannot be greater than the number of BPIs in the pool. In non-parallel case, index should just be 1.");
-  // We allocate a consecutive memory space for the buffer pool.
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size);
+  // We allocate a consecutive memory space for the buffer pool. Frame data lives in the arena, which keeps it aligned
+  // for O_DIRECT and out of the metadata's cache lines. Everything is set up for the largest size the pool may grow
+  // to; the arena only takes memory for frames in use.
+  pages_ = static_cast<Page *>(::operator new[](max_pool_size_ * sizeof(Page)));
+  for (size_t i = 0; i < max_pool_size_; ++i) {
+    new (&pages_[i]) Page(frame_arena_.GetFrame(static_cast<frame_id_t>(i)));
+  }
+  switch (replacer_type) {
+    case ReplacerType::CLOCK:
+      replacer_ = new ClockReplacer(max_pool_size_);
+      break;
+    case ReplacerType::LRU:
+      replacer_ = new LRUReplacer(max_pool_size_);
+      break;
+    case ReplacerType::LRU_K:
+      replacer_ = new LRUKReplacer(max_pool_size_, LRUK_REPLACER_K, CORRELATED_REFERENCE_PERIOD);
+      break;
+    case ReplacerType::TWO_Q:
+      replacer_ = new TwoQReplacer(max_pool_size_, TWO_Q_A1_PERCENT, CORRELATED_REFERENCE_PERIOD);
+      break;
+  }
+  replacer_->SetPoolSize(pool_size);
 
-  // Initially, every page is in the free list.
-  for (size_t i = 0; i < pool_size_; ++i) {
-    free_list_.emplace_back(static_cast<int>(i));
+  // Initially, every page is in the free list. Free frames stay locked so the lock-free hit path cannot pin them.
+  for (size_t i = 0; i < max_pool_size_; ++i) {
+    if (i < pool_size) {
+      free_list_.emplace_back(static_cast<int>(i));
+    }
+    frame_io_state_[i] = FrameIOState::IDLE;
     pages_[i].page_id_ = INVALID_PAGE_ID;
     pages_[i].is_dirty_ = false;
-    pages_[i].pin_count_ = 0;
+    pages_[i].pin_count_ = FRAME_LOCKED;
+  }
+  // frames for growing, the lowest ones are used first
+  for (size_t i = max_pool_size_; i > pool_size; --i) {
+    retired_frames_.push_back(static_cast<frame_id_t>(i - 1));
+  }
+
+  if (enable_background_flush) {
+    flush_thread_ = std::thread(&BufferPoolManagerInstance::FlushWorker, this);
   }
 }
 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
-  delete[] pages_;
+  {
+    std::lock_guard<std::mutex> lock(prefetch_latch_);
+    stop_prefetch_ = true;
+  }
+  prefetch_cv_.notify_all();
+  for (auto &thread : prefetch_threads_) {
+    thread.join();
+  }
+  if (flush_thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(flush_latch_);
+      stop_flush_ = true;
+    }
+    flush_cv_.notify_all();
+    flush_thread_.join();
+  }
+  for (size_t i = 0; i < max_pool_size_; ++i) {
+    pages_[i].~Page();
+  }
+  ::operator delete[](pages_);
   delete replacer_;
 }
 
-
 bool BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) {
   // Make sure you call DiskManager::WritePage!
-  assert(page_id!=INVALID_PAGE_ID);
-  std::lock_guard<std::mutex> lock(latch_);
-
-  Page* page; 
+  assert(page_id != INVALID_PAGE_ID);
+  std::unique_lock<std::mutex> lock = LockLatch();
   frame_id_t frame_id;
-  if(!FindPagetoFrame(page_id, &frame_id)){
-    return false;
+  while (true) {
+    if (!FindPagetoFrame(page_id, &frame_id)) {
+      return false;
+    }
+    // a write-back already in flight must land before we can report the page as flushed
+    if (frame_io_state_[frame_id] == FrameIOState::IDLE) {
+      break;
+    }
+    WaitForIO(&lock, frame_id);
   }
-  page = &pages_[frame_id];
-  if(page->IsDirty()){
-    disk_manager_->WritePage(page->page_id_,page->GetData());
-    page->is_dirty_ = false;
+
+  Page *page = &pages_[frame_id];
+  if (!page->IsDirty()) {
+    return true;
   }
+  // The pin keeps the frame from being evicted or deleted while the write runs without the latch. Clearing the dirty
+  // flag first means a concurrent modification re-dirties the page instead of being lost.
+  PinFrame(frame_id);
+  page->is_dirty_ = false;
+  lock.unlock();
+  disk_manager_->WritePage(page_id, page->GetData());
+  disk_manager_->SyncDB();
+  RelockLatch(&lock);
+  UnpinFrame(frame_id);
   return true;
 }
 
 void BufferPoolManagerInstance::FlushAllPgsImp() {
-  // You can do it!
-  std::lock_guard<std::mutex> lock(latch_);
-  Page* page;
-  for(size_t i =0; i< pool_size_; i++){
-    page = &pages_[i];
-    if(page->page_id_!=INVALID_PAGE_ID && page->IsDirty()){
-      disk_manager_->WritePage(page->page_id_,page->data_);
+  std::vector<Page *> dirty_pages;
+  PinDirtyPages(&dirty_pages);
+  std::vector<std::pair<page_id_t, const char *>> writes;
+  writes.reserve(dirty_pages.size());
+  for (auto *page : dirty_pages) {
+    writes.emplace_back(page->GetPageId(), page->GetData());
+  }
+  disk_manager_->WritePages(std::move(writes));
+  // one sync for the whole batch, eviction and background writes are left to the OS
+  if (!dirty_pages.empty()) {
+    disk_manager_->SyncDB();
+  }
+  UnpinFlushedPages(dirty_pages);
+}
+
+void BufferPoolManagerInstance::PinDirtyPages(std::vector<Page *> *dirty_pages) {
+  std::unique_lock<std::mutex> lock = LockLatch();
+  for (size_t i = 0; i < max_pool_size_; i++) {
+    auto frame_id = static_cast<frame_id_t>(i);
+    WaitForIO(&lock, frame_id);
+    Page *page = &pages_[frame_id];
+    if (page->page_id_ != INVALID_PAGE_ID && page->IsDirty()) {
+      PinFrame(frame_id);
       page->is_dirty_ = false;
+      dirty_pages->push_back(page);
     }
   }
 }
 
+void BufferPoolManagerInstance::UnpinFlushedPages(const std::vector<Page *> &dirty_pages) {
+  std::unique_lock<std::mutex> lock = LockLatch();
+  for (auto *page : dirty_pages) {
+    UnpinFrame(static_cast<frame_id_t>(page - pages_));
+  }
+}
+
+std::vector<page_id_t> BufferPoolManagerInstance::GetResidentPgsImp() {
+  std::unique_lock<std::mutex> lock = LockLatch();
+  std::vector<page_id_t> page_ids;
+  // pinned pages are in use right now, frames of bulk reads are left out
+  for (size_t i = 0; i < max_pool_size_; i++) {
+    Page &page = pages_[i];
+    if (page.page_id_ != INVALID_PAGE_ID && page.GetPinCount() > 0 && frame_owner_[i] != FrameOwner::RING) {
+      page_ids.push_back(page.page_id_);
+    }
+  }
+  std::vector<frame_id_t> frame_ids;
+  replacer_->GetRetentionOrder(&frame_ids);
+  for (auto frame_id : frame_ids) {
+    if (pages_[frame_id].page_id_ != INVALID_PAGE_ID) {
+      page_ids.push_back(pages_[frame_id].page_id_);
+    }
+  }
+  return page_ids;
+}
+
+size_t BufferPoolManagerInstance::WarmUpImp(const std::vector<page_id_t> &page_ids) {
+  std::vector<Page *> loading_pages;
+  StartWarmUp(page_ids, &loading_pages);
+  std::vector<std::pair<page_id_t, char *>> reads;
+  reads.reserve(loading_pages.size());
+  for (auto *page : loading_pages) {
+    reads.emplace_back(page->GetPageId(), page->GetData());
+  }
+  disk_manager_->ReadPages(std::move(reads));
+  FinishWarmUp(loading_pages);
+  return loading_pages.size();
+}
+
+void BufferPoolManagerInstance::StartWarmUp(const std::vector<page_id_t> &page_ids,
+                                            std::vector<Page *> *loading_pages) {
+  std::unique_lock<std::mutex> lock = LockLatch();
+  for (auto page_id : page_ids) {
+    if (free_list_.empty()) {
+      break;
+    }
+    frame_id_t frame_id;
+    if (static_cast<uint32_t>(page_id) % num_instances_ != instance_index_ || FindPagetoFrame(page_id, &frame_id)) {
+      continue;
+    }
+    frame_id = free_list_.front();
+    free_list_.pop_front();
+    frame_owner_[frame_id] = FrameOwner::POOL;
+    StartLoad(page_id, frame_id);
+    loading_pages->push_back(&pages_[frame_id]);
+  }
+}
+
+void BufferPoolManagerInstance::FinishWarmUp(const std::vector<Page *> &loading_pages) {
+  std::unique_lock<std::mutex> lock = LockLatch();
+  // the replacer sees the hottest page as the most recently used one
+  for (auto it = loading_pages.rbegin(); it != loading_pages.rend(); it++) {
+    auto frame_id = static_cast<frame_id_t>(*it - pages_);
+    frame_io_state_[frame_id] = FrameIOState::IDLE;
+    UnpinFrame(frame_id);
+  }
+  io_cv_.notify_all();
+}
+
+bool BufferPoolManagerInstance::ResizeImp(size_t pool_size) {
+  if (pool_size == 0 || pool_size > max_pool_size_) {
+    return false;
+  }
+  std::unique_lock<std::mutex> lock = LockLatch();
+  while (pool_size_ < pool_size) {
+    free_list_.push_back(retired_frames_.back());
+    retired_frames_.pop_back();
+    pool_size_++;
+  }
+  // shrink by free frames first, then by victims; a dirty victim is written back with latch_ released
+  bool resized = true;
+  while (pool_size_ > pool_size) {
+    frame_id_t frame_id;
+    if (!free_list_.empty()) {
+      frame_id = free_list_.back();
+      free_list_.pop_back();
+    } else if (!replacer_->Victim(&frame_id)) {
+      resized = false;
+      break;
+    } else if (!EvictFrame(&lock, frame_id)) {
+      continue;
+    }
+    RetireFrame(frame_id);
+  }
+  // a partial shrink still changed the size
+  replacer_->SetPoolSize(pool_size_);
+  return resized;
+}
+
 Page *BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) {
   // 0.   Make sure you call AllocatePage!
   // 1.   If all the pages in the buffer pool are pinned, return nullptr.
   // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
   // 3.   Update P's metadata, zero out memory and add P to the page table.
   // 4.   Set the page ID output parameter. Return a pointer to P.
-  std::lock_guard<std::mutex> lock(latch_);
-  *page_id = disk_manager_->AllocatePage();
-
-  Page* page;
+  std::unique_lock<std::mutex> lock = LockLatch();
   frame_id_t frame_id;
-  //find free_list
-  if(!FindFreePage(&frame_id)){
+  if (!FindFreePage(&lock, &frame_id)) {
     return nullptr;
   }
-  page = &pages_[frame_id];
-  page_table_.emplace(*page_id,frame_id);
-  //update matadata
-  page->page_id_ = *page_id;
-  page->pin_count_ = 1;
-  page->is_dirty_ = false;
-  page->ResetMemory();
+  *page_id = AllocatePage();
+  DropStaleCopy(&lock, *page_id);
+  return InitNewPage(*page_id, frame_id);
+}
+
+Page *BufferPoolManagerInstance::NewPgInSegmentImp(page_id_t *page_id, PageSegment *segment) {
+  *page_id = segment->AllocatePage(disk_manager_);
+  ValidatePageId(*page_id);
+  Page *page = NewPageWithId(*page_id);
+  if (page == nullptr) {
+    DeallocatePage(*page_id);
+  }
   return page;
 }
 
-Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) {
+Page *BufferPoolManagerInstance::NewPageWithId(page_id_t page_id) {
+  std::unique_lock<std::mutex> lock = LockLatch();
+  frame_id_t frame_id;
+  if (!FindFreePage(&lock, &frame_id)) {
+    return nullptr;
+  }
+  DropStaleCopy(&lock, page_id);
+  return InitNewPage(page_id, frame_id);
+}
+
+Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) { return FetchPgInRingImp(page_id, nullptr); }
+
+Page *BufferPoolManagerInstance::FetchPgInRingImp(page_id_t page_id, BufferRing *ring) {
   // 1.     Search the page table for the requested page (P).
   // 1.1    If P exists, pin it and return it immediately.
   // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
@@ -115,29 +317,51 @@ Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) {
   // 2.     If R is dirty, write it back to the disk.
   // 3.     Delete R from the page table and insert P.
   // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-  std::lock_guard<std::mutex> lock(latch_);
-  Page* page;
   frame_id_t frame_id;
-  //1.1 exists
-  if(FindPagetoFrame(page_id, &frame_id)){
-    page = &pages_[frame_id];
-    page->pin_count_++;
-    replacer_->Pin(frame_id);
-    return page;
+  if (page_table_.Find(page_id, &frame_id) && TryPinResident(page_id, frame_id)) {
+    counters_.Add(BufferPoolCounters::FETCH_HITS);
+    if (frame_owner_[frame_id] == FrameOwner::PREFETCH) {
+      std::unique_lock<std::mutex> lock = LockLatch();
+      ClaimPrefetchedFrame(ring, page_id, frame_id);
+    }
+    return &pages_[frame_id];
   }
-  //1.2 not exist
-  if(!FindFreePage(&frame_id)){
-    return nullptr;
+
+  std::unique_lock<std::mutex> lock = LockLatch();
+  while (true) {
+    // 1.1 exists
+    if (FindPagetoFrame(page_id, &frame_id)) {
+      if (frame_io_state_[frame_id] == FrameIOState::LOADING) {
+        // another thread is reading this page in, wait for it and look again (the read may have been abandoned)
+        WaitForIO(&lock, frame_id);
+        continue;
+      }
+      PinFrame(frame_id);
+      ClaimPrefetchedFrame(ring, page_id, frame_id);
+      counters_.Add(BufferPoolCounters::FETCH_HITS);
+      return &pages_[frame_id];
+    }
+    // 1.2 not exist
+    if (!(ring == nullptr ? FindFreePage(&lock, &frame_id) : FindRingFrame(&lock, ring, &frame_id))) {
+      return nullptr;
+    }
+    // the latch may have been dropped to write back a victim, so someone else may have brought the page in
+    frame_id_t loaded_frame_id;
+    if (!FindPagetoFrame(page_id, &loaded_frame_id)) {
+      break;
+    }
+    free_list_.push_front(frame_id);
   }
-  //Delete R from the page table and insert P.
-  page = &pages_[frame_id];
-  page_table_.emplace(page_id,frame_id);
-  //update metadtata
-  page->page_id_ = page_id;
-  page->pin_count_++;
-  page->is_dirty_ = false;
-  disk_manager_->ReadPage(page->GetPageId(),page->GetData());
-  return page;
+
+  if (ring == nullptr) {
+    frame_owner_[frame_id] = FrameOwner::POOL;
+  } else {
+    frame_owner_[frame_id] = FrameOwner::RING;
+    AddRingSlot(ring, frame_id, page_id);
+  }
+  counters_.Add(BufferPoolCounters::FETCH_MISSES);
+  LoadPage(&lock, page_id, frame_id);
+  return &pages_[frame_id];
 }
 
 bool BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) {
@@ -146,92 +370,522 @@ bool BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) {
   // 1.   If P does not exist, return true.
   // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
   // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
-  std::lock_guard<std::mutex> lock(latch_);
-  Page* page;
+  {
+    // a prefetch already being read is dropped by the worker once the page is deallocated
+    std::lock_guard<std::mutex> prefetch_lock(prefetch_latch_);
+    if (prefetch_pending_.erase(page_id) != 0) {
+      prefetch_queue_.erase(std::remove(prefetch_queue_.begin(), prefetch_queue_.end(), page_id),
+                            prefetch_queue_.end());
+    }
+  }
+  std::unique_lock<std::mutex> lock = LockLatch();
   frame_id_t frame_id;
-  // 1.   If P does not exist, return true.
-  if(!FindPagetoFrame(page_id, &frame_id)){
-    return true;
+  while (true) {
+    // 1.   If P does not exist, return true.
+    if (!FindPagetoFrame(page_id, &frame_id)) {
+      DeallocatePage(page_id);
+      return true;
+    }
+    if (frame_io_state_[frame_id] == FrameIOState::IDLE) {
+      break;
+    }
+    WaitForIO(&lock, frame_id);
   }
   // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
-  page = &pages_[frame_id];
-  if(page->GetPinCount()!=0){
+  if (!TryLockFrame(frame_id)) {
+    return false;
+  }
+  // P can be deleted. Its content is dropped, so there is nothing to write back.
+  FreeFrame(frame_id);
+  DeallocatePage(page_id);
+  return true;
+}
+
+bool BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) {
+  frame_id_t frame_id;
+  // The caller's pin keeps the frame from being reassigned, so a frame that holds page_id is the right one. The
+  // latch is only needed to get an authoritative answer when the lock-free lookup misses.
+  if (!page_table_.Find(page_id, &frame_id) || pages_[frame_id].page_id_ != page_id) {
+    std::unique_lock<std::mutex> lock = LockLatch();
+    if (!FindPagetoFrame(page_id, &frame_id)) {
+      return true;
+    }
+  }
+  Page *page = &pages_[frame_id];
+  if (is_dirty) {
+    page->is_dirty_ = true;
+  }
+  int pin_count = page->pin_count_.load();
+  do {
+    if (pin_count <= 0) {
+      return false;
+    }
+  } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count - 1));
+  if (pin_count == 1) {
+    MakeEvictable(frame_id);
+  }
+  return true;
+}
+
+void BufferPoolManagerInstance::ReleasePgImp(Page *page, bool is_dirty) {
+  if (is_dirty) {
+    page->is_dirty_ = true;
+  }
+  if (--page->pin_count_ == 0) {
+    MakeEvictable(static_cast<frame_id_t>(page - pages_));
+  }
+}
+
+bool BufferPoolManagerInstance::PrefetchPgImp(page_id_t page_id) {
+  frame_id_t frame_id;
+  if (page_table_.Find(page_id, &frame_id)) {
+    return pages_[frame_id].page_id_ == page_id && frame_io_state_[frame_id] != FrameIOState::LOADING;
+  }
+  std::lock_guard<std::mutex> lock(prefetch_latch_);
+  if (prefetch_queue_.size() >= static_cast<size_t>(PREFETCH_QUEUE_SIZE) ||
+      !prefetch_pending_.insert(page_id).second) {
+    return false;
+  }
+  if (prefetch_threads_.empty()) {
+    for (int i = 0; i < PREFETCH_THREADS; i++) {
+      prefetch_threads_.emplace_back(&BufferPoolManagerInstance::PrefetchWorker, this);
+    }
+  }
+  prefetch_queue_.push_back(page_id);
+  prefetch_cv_.notify_one();
+  return false;
+}
+
+page_id_t BufferPoolManagerInstance::AllocatePage() {
+  const page_id_t page_id = disk_manager_->AllocatePage(num_instances_, instance_index_);
+  ValidatePageId(page_id);
+  return page_id;
+}
+
+void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
+  assert(page_id % num_instances_ == instance_index_);  // allocated pages mod back to this BPI
+}
+
+bool BufferPoolManagerInstance::FindFreePage(std::unique_lock<std::mutex> *lock, frame_id_t *frame_id) {
+  if (free_list_.empty()) {
+    counters_.Add(BufferPoolCounters::FREE_LIST_EMPTY);
+  }
+  while (true) {
+    if (!free_list_.empty()) {
+      *frame_id = free_list_.front();
+      free_list_.pop_front();
+      return true;
+    }
+    if (!replacer_->Victim(frame_id)) {
+      return false;
+    }
+    if (EvictFrame(lock, *frame_id)) {
+      return true;
+    }
+  }
+}
+
+bool BufferPoolManagerInstance::EvictFrame(std::unique_lock<std::mutex> *lock, frame_id_t frame_id) {
+  Page *page = &pages_[frame_id];
+  // the background writer is cleaning this victim already, waiting for it is cheaper than writing it ourselves
+  if (frame_io_state_[frame_id] == FrameIOState::FLUSHING) {
+    WaitForIO(lock, frame_id);
+  }
+  if (page->GetPinCount() != 0 || frame_io_state_[frame_id] != FrameIOState::IDLE) {
     return false;
   }
-  if(page->IsDirty()){
-    disk_manager_->WritePage(page->GetPageId(),page->GetData());
+  if (page->IsDirty()) {
+    // Write the victim back without the latch. It stays in the page table meanwhile, so a concurrent fetch of it
+    // simply pins the (still valid) frame and the eviction is abandoned below.
+    frame_io_state_[frame_id] = FrameIOState::EVICTING;
     page->is_dirty_ = false;
+    lock->unlock();
+    disk_manager_->WritePage(page->GetPageId(), page->GetData());
+    counters_.Add(BufferPoolCounters::FOREGROUND_WRITES);
+    flush_cv_.notify_one();
+    RelockLatch(lock);
+    frame_io_state_[frame_id] = FrameIOState::IDLE;
+    io_cv_.notify_all();
+  }
+  // A lock-free hit may pin the frame at any point up to here; once it is locked, nobody else can touch it.
+  if (!TryLockFrame(frame_id)) {
+    return false;
+  }
+  if (page->IsDirty()) {
+    // pinned, modified and unpinned again after we looked at it; its unpin already made it evictable again
+    page->pin_count_ = 0;
+    MakeEvictable(frame_id);
+    return false;
   }
-  // P can be deleted.
+  // it may have been pinned and unpinned since it was picked, which put it back in the replacer
   replacer_->Pin(frame_id);
-  page_table_.erase(page_id);
-  disk_manager_->DeallocatePage(page_id);
-  //reaet metdata
+  page_table_.Erase(page->GetPageId());
+  page->page_id_ = INVALID_PAGE_ID;
+  counters_.Add(BufferPoolCounters::EVICTIONS);
+  return true;
+}
+
+bool BufferPoolManagerInstance::FindRingFrame(std::unique_lock<std::mutex> *lock, BufferRing *ring,
+                                              frame_id_t *frame_id) {
+  BufferRing::InstanceRing *instance_ring = GetInstanceRing(ring);
+  if (instance_ring->slots_.size() == instance_ring->capacity_) {
+    BufferRing::Slot slot = instance_ring->slots_[instance_ring->next_];
+    if (pages_[slot.frame_id_].page_id_ == slot.page_id_ && frame_owner_[slot.frame_id_] == FrameOwner::RING &&
+        EvictFrame(lock, slot.frame_id_)) {
+      *frame_id = slot.frame_id_;
+      return true;
+    }
+    // still in use by someone else, leave it to the pool and grow the ring from there
+    ReleaseRingSlot(slot);
+  }
+  return FindFreePage(lock, frame_id);
+}
+
+BufferRing::InstanceRing *BufferPoolManagerInstance::GetInstanceRing(BufferRing *ring) {
+  BufferRing::InstanceRing *instance_ring = ring->GetInstanceRing(instance_index_, num_instances_);
+  if (instance_ring->bpm_ == nullptr) {
+    instance_ring->bpm_ = this;
+    // a ring takes at most a quarter of the pool, so a tiny pool still has room for everyone else
+    instance_ring->capacity_ = std::max<size_t>(1, std::min(ring->size_ / num_instances_, pool_size_ / 4));
+  }
+  return instance_ring;
+}
+
+void BufferPoolManagerInstance::AddRingSlot(BufferRing *ring, frame_id_t frame_id, page_id_t page_id) {
+  BufferRing::InstanceRing *instance_ring = GetInstanceRing(ring);
+  if (instance_ring->slots_.size() < instance_ring->capacity_) {
+    instance_ring->slots_.push_back({frame_id, page_id});
+    return;
+  }
+  ReleaseRingSlot(instance_ring->slots_[instance_ring->next_]);
+  instance_ring->slots_[instance_ring->next_] = {frame_id, page_id};
+  instance_ring->next_ = (instance_ring->next_ + 1) % instance_ring->capacity_;
+}
+
+void BufferPoolManagerInstance::ReleaseRingSlot(const BufferRing::Slot &slot) {
+  frame_id_t frame_id = slot.frame_id_;
+  Page *page = &pages_[frame_id];
+  if (page->page_id_ != slot.page_id_ || frame_owner_[frame_id] != FrameOwner::RING) {
+    return;
+  }
+  frame_owner_[frame_id] = FrameOwner::POOL;
+  // A pinned frame becomes evictable when its last pin goes. An unpin racing with the owner change may find it
+  // still owned by the ring, which is why the pin count is only read after the change.
+  if (page->GetPinCount() != 0) {
+    return;
+  }
+  if (!page->IsDirty() && frame_io_state_[frame_id] == FrameIOState::IDLE && TryLockFrame(frame_id)) {
+    replacer_->Pin(frame_id);
+    page_table_.Erase(page->GetPageId());
+    page->page_id_ = INVALID_PAGE_ID;
+    free_list_.push_back(frame_id);
+    return;
+  }
+  replacer_->Unpin(frame_id);
+}
+
+void BufferPoolManagerInstance::ReleaseRing(BufferRing::InstanceRing *instance_ring) {
+  std::unique_lock<std::mutex> lock = LockLatch();
+  for (const auto &slot : instance_ring->slots_) {
+    ReleaseRingSlot(slot);
+  }
+  instance_ring->slots_.clear();
+}
+
+void BufferPoolManagerInstance::ClaimPrefetchedFrame(BufferRing *ring, page_id_t page_id, frame_id_t frame_id) {
+  if (frame_owner_[frame_id] != FrameOwner::PREFETCH) {
+    return;
+  }
+  if (ring == nullptr) {
+    frame_owner_[frame_id] = FrameOwner::POOL;
+    return;
+  }
+  frame_owner_[frame_id] = FrameOwner::RING;
+  AddRingSlot(ring, frame_id, page_id);
+}
+
+void BufferPoolManagerInstance::RetireFrame(frame_id_t frame_id) {
+  frame_owner_[frame_id] = FrameOwner::POOL;
+  pages_[frame_id].is_dirty_ = false;
+  frame_arena_.Release(frame_id, 1);
+  retired_frames_.push_back(frame_id);
+  pool_size_--;
+}
+
+void BufferPoolManagerInstance::MakeEvictable(frame_id_t frame_id) {
+  if (frame_owner_[frame_id] != FrameOwner::RING) {
+    replacer_->Unpin(frame_id);
+  }
+}
+
+bool BufferPoolManagerInstance::FindPagetoFrame(page_id_t page_id, frame_id_t *frame_id) {
+  // Under latch_ no mapping can move, so the lock-free lookup is authoritative here.
+  return page_table_.Find(page_id, frame_id);
+}
+
+void BufferPoolManagerInstance::LoadPage(std::unique_lock<std::mutex> *lock, page_id_t page_id, frame_id_t frame_id) {
+  StartLoad(page_id, frame_id);
+  lock->unlock();
+
+  disk_manager_->ReadPage(page_id, pages_[frame_id].GetData());
+
+  RelockLatch(lock);
+  frame_io_state_[frame_id] = FrameIOState::IDLE;
+  io_cv_.notify_all();
+}
+
+Page *BufferPoolManagerInstance::InitNewPage(page_id_t page_id, frame_id_t frame_id) {
+  Page *page = &pages_[frame_id];
+  page->page_id_ = page_id;
+  // the page id may have been used before, so the zeroed page has to reach disk even if it is never modified
+  page->is_dirty_ = true;
+  page->ResetMemory();
+  frame_owner_[frame_id] = FrameOwner::POOL;
+  page_table_.Insert(page_id, frame_id);
+  page->pin_count_ = 1;
+  replacer_->Pin(frame_id);
+  counters_.Add(BufferPoolCounters::NEW_PAGES);
+  return page;
+}
+
+void BufferPoolManagerInstance::DropStaleCopy(std::unique_lock<std::mutex> *lock, page_id_t page_id) {
+  frame_id_t frame_id;
+  while (FindPagetoFrame(page_id, &frame_id)) {
+    if (frame_io_state_[frame_id] != FrameIOState::IDLE) {
+      WaitForIO(lock, frame_id);
+      continue;
+    }
+    if (TryLockFrame(frame_id)) {
+      FreeFrame(frame_id);
+      continue;
+    }
+    // someone pinned the stale copy before the page was reused; it goes away with the last pin
+    lock->unlock();
+    std::this_thread::yield();
+    RelockLatch(lock);
+  }
+}
+
+void BufferPoolManagerInstance::FreeFrame(frame_id_t frame_id) {
+  Page *page = &pages_[frame_id];
+  replacer_->Pin(frame_id);
+  page_table_.Erase(page->page_id_);
   page->page_id_ = INVALID_PAGE_ID;
-  page->pin_count_ = 0;
   page->is_dirty_ = false;
   page->ResetMemory();
   free_list_.push_front(frame_id);
-  return true;
 }
 
-bool BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) { 
-  std::lock_guard<std::mutex> lock(latch_);
-  Page* page;
-  frame_id_t frame_id;
+void BufferPoolManagerInstance::StartLoad(page_id_t page_id, frame_id_t frame_id) {
+  Page *page = &pages_[frame_id];
+  page->page_id_ = page_id;
+  page->is_dirty_ = false;
+  frame_io_state_[frame_id] = FrameIOState::LOADING;
+  page_table_.Insert(page_id, frame_id);
+  page->pin_count_ = 1;
+  replacer_->Pin(frame_id);
+}
 
-  if(!FindPagetoFrame(page_id, &frame_id)){
-    return true;
+void BufferPoolManagerInstance::PrefetchWorker() {
+  while (true) {
+    std::deque<page_id_t> page_ids;
+    {
+      std::unique_lock<std::mutex> prefetch_lock(prefetch_latch_);
+      prefetch_cv_.wait(prefetch_lock, [&] { return stop_prefetch_ || !prefetch_queue_.empty(); });
+      if (stop_prefetch_) {
+        return;
+      }
+      page_ids.swap(prefetch_queue_);
+    }
+
+    std::unique_lock<std::mutex> lock = LockLatch();
+    std::vector<frame_id_t> loading_frames;
+    for (auto page_id : page_ids) {
+      frame_id_t frame_id;
+      // resident or being read already, or every frame is pinned: nothing to do
+      if (FindPagetoFrame(page_id, &frame_id) || !FindFreePage(&lock, &frame_id)) {
+        continue;
+      }
+      // The latch may have been dropped to write back a victim. Deallocation happens under the latch, so a page that
+      // is still allocated now cannot go away before it is in the page table.
+      frame_id_t loaded_frame_id;
+      if (FindPagetoFrame(page_id, &loaded_frame_id) || !disk_manager_->IsPageAllocated(page_id)) {
+        free_list_.push_front(frame_id);
+        continue;
+      }
+      frame_owner_[frame_id] = FrameOwner::PREFETCH;
+      StartLoad(page_id, frame_id);
+      loading_frames.push_back(frame_id);
+    }
+    lock.unlock();
+
+    if (!loading_frames.empty()) {
+      std::vector<std::future<void>> reads;
+      reads.reserve(loading_frames.size());
+      for (auto frame_id : loading_frames) {
+        reads.push_back(disk_manager_->ReadPageAsync(pages_[frame_id].GetPageId(), pages_[frame_id].GetData()));
+      }
+      for (auto &read : reads) {
+        read.wait();
+      }
+
+      RelockLatch(&lock);
+      for (auto frame_id : loading_frames) {
+        frame_io_state_[frame_id] = FrameIOState::IDLE;
+        UnpinFrame(frame_id);
+      }
+      io_cv_.notify_all();
+      lock.unlock();
+    }
+
+    std::lock_guard<std::mutex> prefetch_lock(prefetch_latch_);
+    for (auto page_id : page_ids) {
+      prefetch_pending_.erase(page_id);
+    }
   }
-  page = &pages_[frame_id];
-  if(is_dirty){
-    page->is_dirty_ = true;
+}
+
+void BufferPoolManagerInstance::FlushWorker() {
+  std::unique_lock<std::mutex> flush_lock(flush_latch_);
+  while (!stop_flush_) {
+    flush_lock.unlock();
+    FlushDirtyFrames();
+    flush_lock.lock();
+    flush_cv_.wait_for(flush_lock, background_flush_interval);
   }
-  if(page->GetPinCount()<=0){
-    return false;
+}
+
+void BufferPoolManagerInstance::FlushDirtyFrames() {
+  std::unique_lock<std::mutex> lock = LockLatch();
+  const size_t low_watermark = std::max<size_t>(1, pool_size_ * BACKGROUND_FLUSH_CLEAN_PERCENT / 100);
+  size_t num_clean = free_list_.size();
+  std::vector<frame_id_t> dirty_frames;
+  for (size_t i = 0; i < max_pool_size_; i++) {
+    auto frame_id = static_cast<frame_id_t>((flush_hand_ + i) % max_pool_size_);
+    Page *page = &pages_[frame_id];
+    // free frames are locked, so this also skips them
+    if (page->GetPinCount() != 0 || frame_io_state_[frame_id] != FrameIOState::IDLE) {
+      continue;
+    }
+    if (!page->IsDirty()) {
+      num_clean++;
+    } else if (dirty_frames.size() < static_cast<size_t>(BACKGROUND_FLUSH_MAX_PAGES) &&
+               (log_manager_ == nullptr || !enable_logging || page->GetLSN() <= log_manager_->GetPersistentLSN())) {
+      // with logging on, a page may only reach disk after the log records that modified it (WAL)
+      dirty_frames.push_back(frame_id);
+    }
   }
-  page->pin_count_--;
-  if(page->GetPinCount()==0){
-    replacer_->Unpin(frame_id);
+  if (num_clean >= low_watermark || dirty_frames.empty()) {
+    return;
   }
-  return true;
+  dirty_frames.resize(std::min(dirty_frames.size(), low_watermark - num_clean));
+  for (auto frame_id : dirty_frames) {
+    frame_io_state_[frame_id] = FrameIOState::FLUSHING;
+    pages_[frame_id].is_dirty_ = false;
+  }
+  flush_hand_ = (dirty_frames.back() + 1) % max_pool_size_;
+  lock.unlock();
+
+  // The FLUSHING state keeps the frames from being reassigned. They may still be pinned and modified meanwhile, so
+  // each page is copied under its read latch, which keeps such a modification from tearing the write and re-dirties
+  // the page. Writing the copies lets the whole batch be in flight at once without holding several page latches.
+  std::vector<char> copies(dirty_frames.size() * PAGE_SIZE);
+  std::vector<std::pair<page_id_t, const char *>> writes;
+  writes.reserve(dirty_frames.size());
+  for (size_t i = 0; i < dirty_frames.size(); i++) {
+    Page *page = &pages_[dirty_frames[i]];
+    char *copy = &copies[i * PAGE_SIZE];
+    page->RLatch();
+    memcpy(copy, page->GetData(), PAGE_SIZE);
+    page->RUnlatch();
+    writes.emplace_back(page->GetPageId(), copy);
+  }
+  disk_manager_->WritePages(std::move(writes));
+  counters_.Add(BufferPoolCounters::BACKGROUND_WRITES, dirty_frames.size());
+
+  RelockLatch(&lock);
+  for (auto frame_id : dirty_frames) {
+    frame_io_state_[frame_id] = FrameIOState::IDLE;
+  }
+  io_cv_.notify_all();
 }
 
-page_id_t BufferPoolManagerInstance::AllocatePage() {
-  const page_id_t next_page_id = next_page_id_;
-  next_page_id_ += num_instances_;
-  ValidatePageId(next_page_id);
-  return next_page_id;
+BufferPoolStats BufferPoolManagerInstance::GetStats() const {
+  BufferPoolStats stats;
+  counters_.Snapshot(&stats);
+  // a racy scan, but every frame is read consistently enough for a histogram
+  for (size_t i = 0; i < max_pool_size_; i++) {
+    int pin_count = pages_[i].GetPinCount();
+    if (pin_count >= 0 && pages_[i].GetPageId() != INVALID_PAGE_ID) {
+      stats.pin_count_histogram_[BufferPoolStats::PinCountBucket(pin_count)]++;
+    }
+  }
+  return stats;
 }
 
-void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
-  assert(page_id % num_instances_ == instance_index_);  // allocated pages mod back to this BPI
+std::unique_lock<std::mutex> BufferPoolManagerInstance::LockLatch() {
+  std::unique_lock<std::mutex> lock(latch_, std::defer_lock);
+  RelockLatch(&lock);
+  return lock;
 }
 
-bool BufferPoolManagerInstance::FindFreePage(frame_id_t *frame_id){
-  if(!free_list_.empty()){
-    *frame_id = free_list_.front();
-    free_list_.pop_front();
-    return true;
+void BufferPoolManagerInstance::RelockLatch(std::unique_lock<std::mutex> *lock) {
+  if (lock->try_lock()) {
+    return;
   }
-  if(replacer_->Victim(frame_id)){
-    auto page = &pages_[*frame_id];
-    if(page->IsDirty()){
-      disk_manager_->WritePage(page->GetPageId(),page->GetData());
-      page->is_dirty_ = false;
+  auto start = std::chrono::steady_clock::now();
+  lock->lock();
+  auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  counters_.Add(BufferPoolCounters::LATCH_WAITS);
+  counters_.Add(BufferPoolCounters::LATCH_WAIT_NS, waited.count());
+}
+
+void BufferPoolManagerInstance::WaitForIO(std::unique_lock<std::mutex> *lock, frame_id_t frame_id) {
+  io_cv_.wait(*lock, [&] { return frame_io_state_[frame_id] == FrameIOState::IDLE; });
+}
+
+void BufferPoolManagerInstance::PinFrame(frame_id_t frame_id) {
+  pages_[frame_id].pin_count_++;
+  replacer_->Pin(frame_id);
+}
+
+bool BufferPoolManagerInstance::TryPinResident(page_id_t page_id, frame_id_t frame_id) {
+  Page *page = &pages_[frame_id];
+  int pin_count = page->pin_count_.load();
+  do {
+    if (pin_count < 0) {
+      return false;
+    }
+  } while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count + 1));
+
+  if (page->page_id_ == page_id && frame_io_state_[frame_id] != FrameIOState::LOADING) {
+    if (pin_count == 0) {
+      replacer_->Pin(frame_id);
     }
-    page_table_.erase(page->GetPageId());
     return true;
   }
+
+  // The frame was reassigned or is still being read in. Back the pin out; if it was the only one, an evictor may have
+  // skipped the frame because of it, so make sure a resident unpinned frame is evictable again.
+  if (--page->pin_count_ == 0) {
+    std::unique_lock<std::mutex> lock = LockLatch();
+    if (page->pin_count_ == 0 && page->page_id_ != INVALID_PAGE_ID &&
+        frame_io_state_[frame_id] == FrameIOState::IDLE) {
+      MakeEvictable(frame_id);
+    }
+  }
   return false;
 }
-bool BufferPoolManagerInstance::FindPagetoFrame(page_id_t page_id, frame_id_t *frame_id){
-  auto iterator = page_table_.find(page_id);
-  if(iterator==page_table_.cend()){
-    return false;
+
+bool BufferPoolManagerInstance::TryLockFrame(frame_id_t frame_id) {
+  int expected = 0;
+  return pages_[frame_id].pin_count_.compare_exchange_strong(expected, FRAME_LOCKED);
+}
+
+void BufferPoolManagerInstance::UnpinFrame(frame_id_t frame_id) {
+  if (--pages_[frame_id].pin_count_ == 0) {
+    MakeEvictable(frame_id);
   }
-  *frame_id = iterator->second;
-  return true;
-} 
+}
 
 }  // namespace bustub
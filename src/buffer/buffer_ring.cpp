@@ -0,0 +1,36 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_ring.cpp
+//
+// Identification: src/buffer/buffer_ring.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_ring.h"
+
+#include "buffer/buffer_pool_manager_instance.h"
+
+namespace bustub {
+
+BufferRing::~BufferRing() {
+  for (auto &instance_ring : instance_rings_) {
+    if (instance_ring.bpm_ != nullptr) {
+      instance_ring.bpm_->ReleaseRing(&instance_ring);
+    }
+  }
+}
+
+BufferRing::InstanceRing *BufferRing::GetInstanceRing(uint32_t instance_index, uint32_t num_instances) {
+  std::lock_guard<std::mutex> lock(latch_);
+  // sized once, so the returned pointers stay valid
+  if (instance_rings_.empty()) {
+    instance_rings_.resize(num_instances);
+  }
+  return &instance_rings_[instance_index];
+}
+
+}  // namespace bustub
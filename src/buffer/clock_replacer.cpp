@@ -14,16 +14,67 @@
 
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages) : frames_(num_pages) {}
 
 ClockReplacer::~ClockReplacer() = default;
 
-bool ClockReplacer::Victim(frame_id_t *frame_id) { return false; }
+bool ClockReplacer::Victim(frame_id_t *frame_id) {
+  const size_t num_frames = frames_.size();
+  // Keep sweeping as long as the last full turn of the hand saw an evictable frame. Each turn clears the reference
+  // bits it passes, so a frame that is not unpinned again in the meantime is taken on the next one.
+  bool saw_evictable = true;
+  while (saw_evictable) {
+    saw_evictable = false;
+    for (size_t i = 0; i < num_frames; i++) {
+      size_t slot = hand_.fetch_add(1, std::memory_order_relaxed) % num_frames;
+      uint8_t state = frames_[slot].load();
+      if ((state & EVICTABLE) == 0) {
+        continue;
+      }
+      saw_evictable = true;
+      if ((state & REFERENCED) != 0) {
+        frames_[slot].compare_exchange_strong(state, static_cast<uint8_t>(state & ~REFERENCED));
+        continue;
+      }
+      // Fails if the frame was pinned or unpinned again since the load, the hand moves on either way.
+      if (frames_[slot].compare_exchange_strong(state, 0)) {
+        *frame_id = static_cast<frame_id_t>(slot);
+        return true;
+      }
+    }
+  }
+  *frame_id = INVALID_PAGE_ID;
+  return false;
+}
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+void ClockReplacer::Pin(frame_id_t frame_id) { frames_[frame_id].fetch_and(static_cast<uint8_t>(~EVICTABLE)); }
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+void ClockReplacer::Unpin(frame_id_t frame_id) { frames_[frame_id].fetch_or(EVICTABLE | REFERENCED); }
 
-size_t ClockReplacer::Size() { return 0; }
+size_t ClockReplacer::Size() {
+  size_t size = 0;
+  for (const auto &frame : frames_) {
+    size += frame.load() & EVICTABLE;
+  }
+  return size;
+}
+
+/**
+ * Frames the hand would pass over once (referenced) before the others, each group in the order the hand meets them
+ * last
+ */
+void ClockReplacer::GetRetentionOrder(std::vector<frame_id_t> *frame_ids) {
+  const size_t num_frames = frames_.size();
+  size_t hand = hand_.load(std::memory_order_relaxed);
+  frame_ids->clear();
+  for (uint8_t group : {static_cast<uint8_t>(EVICTABLE | REFERENCED), EVICTABLE}) {
+    for (size_t i = num_frames; i > 0; i--) {
+      size_t slot = (hand + i - 1) % num_frames;
+      if (frames_[slot].load() == group) {
+        frame_ids->push_back(static_cast<frame_id_t>(slot));
+      }
+    }
+  }
+}
 
 }  // namespace bustub
@@ -0,0 +1,141 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.cpp
+//
+// Identification: src/buffer/lru_k_replacer.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+#include <algorithm>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k, size_t correlated_reference_period)
+    : k_(k), correlated_reference_period_(correlated_reference_period), frames_(num_pages) {
+  BUSTUB_ASSERT(k > 0, "LRU-K needs to look back at least one reference");
+}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (num_evictable_ == 0) {
+    *frame_id = INVALID_PAGE_ID;
+    return false;
+  }
+
+  // Frames still inside their correlated reference period are only considered when nothing else is evictable.
+  for (bool respect_correlation : {true, false}) {
+    frame_id_t victim = INVALID_PAGE_ID;
+    bool victim_infinite = false;
+    uint64_t victim_timestamp = 0;
+    for (size_t i = 0; i < frames_.size(); i++) {
+      const FrameHistory &frame = frames_[i];
+      if (!frame.evictable_) {
+        continue;
+      }
+      if (respect_correlation && current_timestamp_ - frame.last_ < correlated_reference_period_) {
+        continue;
+      }
+      // +inf backward K-distance beats any finite one; ties are broken by the oldest reference on record
+      bool infinite = frame.history_.size() < k_;
+      uint64_t timestamp = frame.history_.back();
+      if (victim == INVALID_PAGE_ID || (infinite && !victim_infinite) ||
+          (infinite == victim_infinite && timestamp < victim_timestamp)) {
+        victim = static_cast<frame_id_t>(i);
+        victim_infinite = infinite;
+        victim_timestamp = timestamp;
+      }
+    }
+    if (victim != INVALID_PAGE_ID) {
+      frames_[victim] = FrameHistory();
+      num_evictable_--;
+      *frame_id = victim;
+      return true;
+    }
+  }
+  UNREACHABLE("an evictable frame must have been found");
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  FrameHistory *frame = &frames_[frame_id];
+  RecordAccess(frame);
+  if (frame->evictable_) {
+    frame->evictable_ = false;
+    num_evictable_--;
+  }
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  FrameHistory *frame = &frames_[frame_id];
+  if (frame->history_.empty()) {
+    // never pinned through the replacer, treat the unpin as its first reference
+    RecordAccess(frame);
+  }
+  if (!frame->evictable_) {
+    frame->evictable_ = true;
+    num_evictable_++;
+  }
+}
+
+size_t LRUKReplacer::Size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_evictable_;
+}
+
+void LRUKReplacer::RecordAccess(FrameHistory *frame) {
+  uint64_t now = ++current_timestamp_;
+  if (!frame->history_.empty() && now - frame->last_ < correlated_reference_period_) {
+    frame->last_ = now;
+    return;
+  }
+  // An uncorrelated reference closes the previous correlated period. As in the original algorithm, the older
+  // references are shifted by the length of that period so it counts as a single point in time.
+  if (!frame->history_.empty()) {
+    uint64_t correlated_period = frame->last_ - frame->history_.front();
+    for (auto &timestamp : frame->history_) {
+      timestamp += correlated_period;
+    }
+  }
+  frame->history_.insert(frame->history_.begin(), now);
+  if (frame->history_.size() > k_) {
+    frame->history_.pop_back();
+  }
+  frame->last_ = now;
+}
+
+/**
+ * The reverse of the victim order, ignoring correlated reference periods: finite backward K-distances before infinite
+ * ones, the most recent oldest reference first
+ */
+void LRUKReplacer::GetRetentionOrder(std::vector<frame_id_t> *frame_ids) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  frame_ids->clear();
+  for (size_t i = 0; i < frames_.size(); i++) {
+    if (frames_[i].evictable_) {
+      frame_ids->push_back(static_cast<frame_id_t>(i));
+    }
+  }
+  std::sort(frame_ids->begin(), frame_ids->end(), [&](frame_id_t a, frame_id_t b) {
+    const FrameHistory &frame_a = frames_[a];
+    const FrameHistory &frame_b = frames_[b];
+    bool infinite_a = frame_a.history_.size() < k_;
+    bool infinite_b = frame_b.history_.size() < k_;
+    if (infinite_a != infinite_b) {
+      return infinite_b;
+    }
+    return frame_a.history_.back() > frame_b.history_.back();
+  });
+}
+
+}  // namespace bustub
@@ -53,4 +53,9 @@ size_t LRUReplacer::Size() {
   return lru_list_.size();
 }
 
+void LRUReplacer::GetRetentionOrder(std::vector<frame_id_t> *frame_ids) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  frame_ids->assign(lru_list_.begin(), lru_list_.end());
+}
+
 }  // namespace bustub
@@ -0,0 +1,89 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.cpp
+//
+// Identification: src/buffer/page_table.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_table.h"
+
+namespace bustub {
+
+PageTable::PageTable(size_t num_frames) : shift_bits_(1) {
+  while ((static_cast<size_t>(1) << shift_bits_) < 2 * num_frames) {
+    shift_bits_++;
+  }
+  mask_ = (static_cast<size_t>(1) << shift_bits_) - 1;
+  slots_ = std::make_unique<std::atomic<uint64_t>[]>(Capacity());
+  for (size_t i = 0; i < Capacity(); i++) {
+    slots_[i].store(EMPTY_SLOT, std::memory_order_relaxed);
+  }
+}
+
+bool PageTable::Find(page_id_t page_id, frame_id_t *frame_id) const {
+  size_t idx = HomeSlot(page_id);
+  // bounded by the capacity: a reader racing with writers must never spin forever
+  for (size_t probes = 0; probes < Capacity(); probes++) {
+    uint64_t slot = slots_[idx].load(std::memory_order_acquire);
+    if (slot == EMPTY_SLOT) {
+      return false;
+    }
+    if (KeyOf(slot) == page_id) {
+      *frame_id = ValueOf(slot);
+      return true;
+    }
+    idx = (idx + 1) & mask_;
+  }
+  return false;
+}
+
+void PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  BUSTUB_ASSERT(page_id != INVALID_PAGE_ID, "cannot map the invalid page id");
+  size_t idx = HomeSlot(page_id);
+  while (slots_[idx].load(std::memory_order_relaxed) != EMPTY_SLOT) {
+    BUSTUB_ASSERT(KeyOf(slots_[idx].load(std::memory_order_relaxed)) != page_id, "page is already mapped");
+    idx = (idx + 1) & mask_;
+  }
+  slots_[idx].store(Pack(page_id, frame_id), std::memory_order_release);
+}
+
+bool PageTable::Erase(page_id_t page_id) {
+  size_t hole = HomeSlot(page_id);
+  while (true) {
+    uint64_t slot = slots_[hole].load(std::memory_order_relaxed);
+    if (slot == EMPTY_SLOT) {
+      return false;
+    }
+    if (KeyOf(slot) == page_id) {
+      break;
+    }
+    hole = (hole + 1) & mask_;
+  }
+
+  // Backward-shift deletion: pull later entries of the probe run into the hole unless their home slot lies
+  // cyclically in (hole, idx], in which case moving them would put them before their home.
+  size_t idx = hole;
+  while (true) {
+    idx = (idx + 1) & mask_;
+    uint64_t slot = slots_[idx].load(std::memory_order_relaxed);
+    if (slot == EMPTY_SLOT) {
+      break;
+    }
+    size_t home = HomeSlot(KeyOf(slot));
+    bool stays = hole <= idx ? (hole < home && home <= idx) : (hole < home || home <= idx);
+    if (stays) {
+      continue;
+    }
+    slots_[hole].store(slot, std::memory_order_release);
+    hole = idx;
+  }
+  slots_[hole].store(EMPTY_SLOT, std::memory_order_release);
+  return true;
+}
+
+}  // namespace bustub
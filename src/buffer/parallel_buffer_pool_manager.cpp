@@ -12,15 +12,22 @@
 
 #include "buffer/parallel_buffer_pool_manager.h"
 
+#include <utility>
+#include <vector>
+
 namespace bustub {
 
 ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
-                                                     LogManager *log_manager): num_instances_(num_instances), pool_size_(pool_size),
-                                                     start_index_(0), disk_manager_(disk_manager), log_manager_(log_manager) {
+                                                     LogManager *log_manager, ReplacerType replacer_type)
+    : num_instances_(num_instances),
+      pool_size_(pool_size),
+      start_index_(0),
+      disk_manager_(disk_manager),
+      log_manager_(log_manager) {
   // Allocate and create individual BufferPoolManagerInstances
   bpms_ = (BufferPoolManager**)operator new(sizeof(BufferPoolManager*)*num_instances_);
-  for(size_t i =0; i<num_instances_; i++){
-    bpms_[i] = (BufferPoolManager*)new BufferPoolManagerInstance(pool_size_, num_instances_, i, disk_manager_, log_manager_);
+  for (size_t i = 0; i < num_instances_; i++) {
+    bpms_[i] = new BufferPoolManagerInstance(pool_size_, num_instances_, i, disk_manager_, log_manager_, replacer_type);
   }
 }
 
@@ -34,7 +41,35 @@ ParallelBufferPoolManager::~ParallelBufferPoolManager(){
 
 size_t ParallelBufferPoolManager::GetPoolSize() {
   // Get size of all BufferPoolManagerInstances
-  return pool_size_*num_instances_;
+  size_t pool_size = 0;
+  for (size_t i = 0; i < num_instances_; i++) {
+    pool_size += bpms_[i]->GetPoolSize();
+  }
+  return pool_size;
+}
+
+uint64_t ParallelBufferPoolManager::GetForegroundWrites() const {
+  uint64_t writes = 0;
+  for (size_t i = 0; i < num_instances_; i++) {
+    writes += static_cast<BufferPoolManagerInstance *>(bpms_[i])->GetForegroundWrites();
+  }
+  return writes;
+}
+
+uint64_t ParallelBufferPoolManager::GetBackgroundWrites() const {
+  uint64_t writes = 0;
+  for (size_t i = 0; i < num_instances_; i++) {
+    writes += static_cast<BufferPoolManagerInstance *>(bpms_[i])->GetBackgroundWrites();
+  }
+  return writes;
+}
+
+BufferPoolStats ParallelBufferPoolManager::GetStats() const {
+  BufferPoolStats stats;
+  for (size_t i = 0; i < num_instances_; i++) {
+    stats += static_cast<BufferPoolManagerInstance *>(bpms_[i])->GetStats();
+  }
+  return stats;
 }
 
 BufferPoolManager *ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) {
@@ -48,12 +83,22 @@ Page *ParallelBufferPoolManager::FetchPgImp(page_id_t page_id) {
   return bpm->FetchPage(page_id);
 }
 
+Page *ParallelBufferPoolManager::FetchPgInRingImp(page_id_t page_id, BufferRing *ring) {
+  // Fetch page_id from responsible BufferPoolManagerInstance, which uses its own part of the ring
+  BufferPoolManager *bpm = GetBufferPoolManager(page_id);
+  return bpm->FetchPageInRing(page_id, ring);
+}
+
 bool ParallelBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) {
   // Unpin page_id from responsible BufferPoolManagerInstance
   BufferPoolManager* bpm = GetBufferPoolManager(page_id);
   return bpm->UnpinPage(page_id,is_dirty);
 }
 
+void ParallelBufferPoolManager::ReleasePgImp(Page *page, bool is_dirty) {
+  GetBufferPoolManager(page->GetPageId())->ReleasePage(page, is_dirty);
+}
+
 bool ParallelBufferPoolManager::FlushPgImp(page_id_t page_id) {
   // Flush page_id from responsible BufferPoolManagerInstance
   BufferPoolManager* bpm = GetBufferPoolManager(page_id);
@@ -78,6 +123,17 @@ Page *ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) {
   return nullptr;
 }
 
+Page *ParallelBufferPoolManager::NewPgInSegmentImp(page_id_t *page_id, PageSegment *segment) {
+  // The segment picks the page id, which in turn picks the instance
+  *page_id = segment->AllocatePage(disk_manager_);
+  auto *bpm = static_cast<BufferPoolManagerInstance *>(GetBufferPoolManager(*page_id));
+  Page *page = bpm->NewPageWithId(*page_id);
+  if (page == nullptr) {
+    disk_manager_->DeallocatePage(*page_id);
+  }
+  return page;
+}
+
 bool ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) {
   // Delete page_id from responsible BufferPoolManagerInstance
   BufferPoolManager* bpm = GetBufferPoolManager(page_id);
@@ -85,10 +141,80 @@ bool ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) {
 }
 
 void ParallelBufferPoolManager::FlushAllPgsImp() {
-  // flush all pages from all BufferPoolManagerInstances
-  for(size_t i=0; i<num_instances_; i++){
-    bpms_[i]->FlushAllPages();
+  // flush all pages from all BufferPoolManagerInstances as one batch: adjacent page ids belong to different instances,
+  // so only the whole pool's dirty pages can be merged into larger writes
+  std::vector<std::vector<Page *>> dirty_pages(num_instances_);
+  std::vector<std::pair<page_id_t, const char *>> writes;
+  for (size_t i = 0; i < num_instances_; i++) {
+    static_cast<BufferPoolManagerInstance *>(bpms_[i])->PinDirtyPages(&dirty_pages[i]);
+    for (auto *page : dirty_pages[i]) {
+      writes.emplace_back(page->GetPageId(), page->GetData());
+    }
   }
+  bool any_dirty = !writes.empty();
+  disk_manager_->WritePages(std::move(writes));
+  if (any_dirty) {
+    disk_manager_->SyncDB();
+  }
+  for (size_t i = 0; i < num_instances_; i++) {
+    static_cast<BufferPoolManagerInstance *>(bpms_[i])->UnpinFlushedPages(dirty_pages[i]);
+  }
+}
+
+std::vector<page_id_t> ParallelBufferPoolManager::GetResidentPgsImp() {
+  // interleave the instances, so that the hottest pages of each stay near the front
+  std::vector<std::vector<page_id_t>> instance_page_ids(num_instances_);
+  size_t num_pages = 0;
+  for (size_t i = 0; i < num_instances_; i++) {
+    instance_page_ids[i] = bpms_[i]->GetResidentPages();
+    num_pages += instance_page_ids[i].size();
+  }
+  std::vector<page_id_t> page_ids;
+  page_ids.reserve(num_pages);
+  for (size_t rank = 0; page_ids.size() < num_pages; rank++) {
+    for (const auto &ids : instance_page_ids) {
+      if (rank < ids.size()) {
+        page_ids.push_back(ids[rank]);
+      }
+    }
+  }
+  return page_ids;
+}
+
+size_t ParallelBufferPoolManager::WarmUpImp(const std::vector<page_id_t> &page_ids) {
+  // read the pages of all instances as one batch, so that adjacent pages are merged into larger reads
+  std::vector<std::vector<Page *>> loading_pages(num_instances_);
+  std::vector<std::pair<page_id_t, char *>> reads;
+  for (size_t i = 0; i < num_instances_; i++) {
+    static_cast<BufferPoolManagerInstance *>(bpms_[i])->StartWarmUp(page_ids, &loading_pages[i]);
+    for (auto *page : loading_pages[i]) {
+      reads.emplace_back(page->GetPageId(), page->GetData());
+    }
+  }
+  size_t num_read = reads.size();
+  disk_manager_->ReadPages(std::move(reads));
+  for (size_t i = 0; i < num_instances_; i++) {
+    static_cast<BufferPoolManagerInstance *>(bpms_[i])->FinishWarmUp(loading_pages[i]);
+  }
+  return num_read;
+}
+
+bool ParallelBufferPoolManager::ResizeImp(size_t pool_size) {
+  if (pool_size < num_instances_) {
+    return false;
+  }
+  // the first instances take the remainder
+  bool resized = true;
+  for (size_t i = 0; i < num_instances_; i++) {
+    resized = bpms_[i]->Resize(pool_size / num_instances_ + (i < pool_size % num_instances_ ? 1 : 0)) && resized;
+  }
+  return resized;
+}
+
+bool ParallelBufferPoolManager::PrefetchPgImp(page_id_t page_id) {
+  // Prefetch page_id through responsible BufferPoolManagerInstance
+  BufferPoolManager *bpm = GetBufferPoolManager(page_id);
+  return bpm->PrefetchPage(page_id);
 }
 
 }  // namespace bustub
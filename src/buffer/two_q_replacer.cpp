@@ -0,0 +1,107 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_q_replacer.cpp
+//
+// Identification: src/buffer/two_q_replacer.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/two_q_replacer.h"
+
+namespace bustub {
+
+TwoQReplacer::TwoQReplacer(size_t num_pages, size_t a1_percent, size_t correlated_reference_period)
+    : a1_percent_(a1_percent),
+      a1_size_(num_pages * a1_percent / 100),
+      correlated_reference_period_(correlated_reference_period),
+      frames_(num_pages) {}
+
+TwoQReplacer::~TwoQReplacer() = default;
+
+bool TwoQReplacer::Victim(frame_id_t *frame_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::list<frame_id_t> *victim_list;
+  if (!a1_list_.empty() && (a1_count_ > a1_size_ || am_list_.empty())) {
+    victim_list = &a1_list_;
+  } else if (!am_list_.empty()) {
+    victim_list = &am_list_;
+  } else {
+    *frame_id = INVALID_PAGE_ID;
+    return false;
+  }
+
+  *frame_id = victim_list->back();
+  victim_list->pop_back();
+  FrameState *frame = &frames_[*frame_id];
+  if (frame->queue_ == Queue::A1) {
+    a1_count_--;
+  }
+  *frame = FrameState();
+  return true;
+}
+
+void TwoQReplacer::Pin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  FrameState *frame = &frames_[frame_id];
+  uint64_t now = ++current_timestamp_;
+  RemoveEvictable(frame);
+  if (frame->queue_ == Queue::NONE) {
+    frame->queue_ = Queue::A1;
+    a1_count_++;
+  } else if (frame->queue_ == Queue::A1 && now - frame->last_ >= correlated_reference_period_) {
+    frame->queue_ = Queue::AM;
+    a1_count_--;
+  }
+  frame->last_ = now;
+}
+
+void TwoQReplacer::Unpin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  FrameState *frame = &frames_[frame_id];
+  if (frame->evictable_) {
+    return;
+  }
+  if (frame->queue_ == Queue::NONE) {
+    // never pinned through the replacer, treat the unpin as its first reference
+    frame->queue_ = Queue::A1;
+    frame->last_ = ++current_timestamp_;
+    a1_count_++;
+  }
+  auto *list = frame->queue_ == Queue::A1 ? &a1_list_ : &am_list_;
+  list->push_front(frame_id);
+  frame->pos_ = list->begin();
+  frame->evictable_ = true;
+}
+
+size_t TwoQReplacer::Size() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return a1_list_.size() + am_list_.size();
+}
+
+void TwoQReplacer::RemoveEvictable(FrameState *frame) {
+  if (!frame->evictable_) {
+    return;
+  }
+  (frame->queue_ == Queue::A1 ? a1_list_ : am_list_).erase(frame->pos_);
+  frame->evictable_ = false;
+}
+
+/**
+ * Am before A1, as A1 is drained first while it is over its share; in either list the newest frames come first
+ */
+void TwoQReplacer::GetRetentionOrder(std::vector<frame_id_t> *frame_ids) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  frame_ids->assign(am_list_.begin(), am_list_.end());
+  frame_ids->insert(frame_ids->end(), a1_list_.begin(), a1_list_.end());
+}
+
+void TwoQReplacer::SetPoolSize(size_t pool_size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  a1_size_ = pool_size * a1_percent_ / 100;
+}
+
+}  // namespace bustub
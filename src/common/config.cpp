@@ -20,4 +20,14 @@ std::chrono::duration<int64_t> log_timeout = std::chrono::seconds(1);
 
 std::chrono::milliseconds cycle_detection_interval = std::chrono::milliseconds(50);
 
+std::atomic<bool> enable_background_flush(false);
+
+std::chrono::milliseconds background_flush_interval = std::chrono::milliseconds(10);
+
+std::atomic<bool> enable_direct_io(false);
+
+std::atomic<bool> enable_huge_page_frames(false);
+
+std::atomic<bool> enable_buffer_pool_warmup(false);
+
 }  // namespace bustub
@@ -0,0 +1,157 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// rwlatch.cpp
+//
+// Identification: src/common/rwlatch.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/rwlatch.h"
+
+#include <thread>  // NOLINT
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bustub {
+
+namespace {
+
+/** Number of times a waiter polls the latch before it goes to sleep. */
+constexpr int SPIN_LIMIT = 100;
+
+/** Sleep until woken up, unless *word no longer holds expected. May return spuriously. */
+void FutexWait(std::atomic<uint32_t> *word, uint32_t expected) {
+#if defined(__linux__)
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+  if (word->load(std::memory_order_relaxed) == expected) {
+    std::this_thread::yield();
+  }
+#endif
+}
+
+/** Wake up at most count threads sleeping on word. @return the number of threads woken up */
+int FutexWake(std::atomic<uint32_t> *word, int count) {
+#if defined(__linux__)
+  return static_cast<int>(
+      syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0));
+#else
+  // waiters poll, there is no one to wake
+  return 0;
+#endif
+}
+
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#endif
+}
+
+}  // namespace
+
+template <typename Pred>
+uint32_t ReaderWriterLatch::SpinUntil(Pred pred) const {
+  uint32_t state = state_.load(std::memory_order_relaxed);
+  for (int spin = 0; spin < SPIN_LIMIT && !pred(state); spin++) {
+    CpuRelax();
+    state = state_.load(std::memory_order_relaxed);
+  }
+  return state;
+}
+
+void ReaderWriterLatch::RLockContended() {
+  uint32_t state = SpinUntil([](uint32_t s) { return (s & MASK) != WRITE_LOCKED || (s & ~MASK) != 0; });
+  while (true) {
+    if (IsReadLockable(state)) {
+      if (state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+        return;
+      }
+      continue;
+    }
+    if ((state & MASK) == MAX_READERS) {
+      // nobody wakes readers when a reader leaves, so wait for one to leave by polling
+      std::this_thread::yield();
+      state = state_.load(std::memory_order_relaxed);
+      continue;
+    }
+    // make sure the unlocking thread knows to wake us before going to sleep
+    if ((state & READERS_WAITING) == 0 &&
+        !state_.compare_exchange_weak(state, state | READERS_WAITING, std::memory_order_relaxed)) {
+      continue;
+    }
+    FutexWait(&state_, state | READERS_WAITING);
+    state = SpinUntil([](uint32_t s) { return (s & MASK) != WRITE_LOCKED || (s & ~MASK) != 0; });
+  }
+}
+
+void ReaderWriterLatch::WLockContended() {
+  uint32_t state = SpinUntil([](uint32_t s) { return (s & MASK) == 0 || (s & WRITERS_WAITING) != 0; });
+  // once this writer slept, others may be sleeping too; keep the bit set for them when taking the latch
+  uint32_t other_writers_waiting = 0;
+  while (true) {
+    if ((state & MASK) == 0) {
+      if (state_.compare_exchange_weak(state, state | WRITE_LOCKED | other_writers_waiting, std::memory_order_acquire,
+                                       std::memory_order_relaxed)) {
+        return;
+      }
+      continue;
+    }
+    if ((state & WRITERS_WAITING) == 0 &&
+        !state_.compare_exchange_weak(state, state | WRITERS_WAITING, std::memory_order_relaxed)) {
+      continue;
+    }
+    other_writers_waiting = WRITERS_WAITING;
+    // read the counter before checking the state again, so that a wake-up in between is not missed
+    uint32_t seq = writer_notify_.load(std::memory_order_acquire);
+    state = state_.load(std::memory_order_relaxed);
+    if ((state & MASK) == 0 || (state & WRITERS_WAITING) == 0) {
+      continue;
+    }
+    FutexWait(&writer_notify_, seq);
+    state = SpinUntil([](uint32_t s) { return (s & MASK) == 0 || (s & WRITERS_WAITING) != 0; });
+  }
+}
+
+/**
+ * A waiting writer goes first and the readers keep waiting behind it; the readers are woken up all at once when no
+ * writer waits. If the latch is taken again meanwhile, the new holder wakes the waiters when it leaves.
+ */
+void ReaderWriterLatch::WakeWriterOrReaders(uint32_t state) {
+  if (state == WRITERS_WAITING) {
+    if (state_.compare_exchange_strong(state, 0, std::memory_order_relaxed)) {
+      WakeWriter();
+      return;
+    }
+    // readers may have started waiting too
+  }
+  if (state == (READERS_WAITING | WRITERS_WAITING)) {
+    if (!state_.compare_exchange_strong(state, READERS_WAITING, std::memory_order_relaxed)) {
+      return;
+    }
+    if (WakeWriter()) {
+      return;
+    }
+    // the writer was not asleep yet and will take the latch by itself, the readers are woken up instead
+    state = READERS_WAITING;
+  }
+  if (state == READERS_WAITING) {
+    if (state_.compare_exchange_strong(state, 0, std::memory_order_relaxed)) {
+      FutexWake(&state_, INT32_MAX);
+    }
+  }
+}
+
+bool ReaderWriterLatch::WakeWriter() {
+  writer_notify_.fetch_add(1, std::memory_order_release);
+  return FutexWake(&writer_notify_, 1) > 0;
+}
+
+}  // namespace bustub
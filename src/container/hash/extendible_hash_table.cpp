@@ -10,8 +10,10 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
 #include <string>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
@@ -27,17 +29,24 @@ HASH_TABLE_TYPE::ExtendibleHashTable(const std::string &name, BufferPoolManager
                                      const KeyComparator &comparator, HashFunction<KeyType> hash_fn)
     : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
   //  implement me!
+  // header
+  auto header_page =
+          reinterpret_cast<HashTableDirectoryPage *>(buffer_pool_manager_->NewPageInSegment(&header_page_id_, &segment_)->GetData());
+  header_page->SetPageId(header_page_id_);
   // directory
+  page_id_t directory_page_id;
   auto directory_page =
-          reinterpret_cast<HashTableDirectoryPage *>(buffer_pool_manager_->NewPage(&directory_page_id_, nullptr)->GetData());
-  directory_page->SetPageId(directory_page_id_);
+          reinterpret_cast<HashTableDirectoryPage *>(buffer_pool_manager_->NewPageInSegment(&directory_page_id, &segment_)->GetData());
+  directory_page->SetPageId(directory_page_id);
+  header_page->SetBucketPageId(0,directory_page_id);
   // root bucket
   page_id_t root_bucket_page_id;
-  buffer_pool_manager_->NewPage(&root_bucket_page_id, nullptr);
+  buffer_pool_manager_->NewPageInSegment(&root_bucket_page_id, &segment_);
   // add root bucket
   directory_page->SetBucketPageId(0,root_bucket_page_id);
 
-  buffer_pool_manager_->UnpinPage(directory_page_id_, true, nullptr);
+  buffer_pool_manager_->UnpinPage(header_page_id_, true, nullptr);
+  buffer_pool_manager_->UnpinPage(directory_page_id, true, nullptr);
   buffer_pool_manager_->UnpinPage(root_bucket_page_id, true, nullptr);
 }
 
@@ -70,9 +79,29 @@ inline page_id_t HASH_TABLE_TYPE::KeyToPageId(KeyType key, HashTableDirectoryPag
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-HashTableDirectoryPage *HASH_TABLE_TYPE::FetchDirectoryPage() {
+inline uint32_t HASH_TABLE_TYPE::KeyToHeaderIndex(KeyType key, HashTableDirectoryPage *header_page) {
+  // the low DIRECTORY_MAX_DEPTH bits of the hash are left to the directory pages
+  return (Hash(key) >> DIRECTORY_MAX_DEPTH) & header_page->GetGlobalDepthMask();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+inline page_id_t HASH_TABLE_TYPE::KeyToDirectoryPageId(KeyType key, HashTableDirectoryPage *header_page) {
+  return header_page->GetBucketPageId(KeyToHeaderIndex(key, header_page));
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+HashTableDirectoryPage *HASH_TABLE_TYPE::FetchHeaderPage() {
+  return reinterpret_cast<HashTableDirectoryPage *>(
+          buffer_pool_manager_->FetchPage(header_page_id_,nullptr)->GetData());
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+HashTableDirectoryPage *HASH_TABLE_TYPE::FetchDirectoryPage(KeyType key, page_id_t *directory_page_id) {
+  HashTableDirectoryPage *header_page = FetchHeaderPage();
+  *directory_page_id = KeyToDirectoryPageId(key, header_page);
+  buffer_pool_manager_->UnpinPage(header_page_id_,false,nullptr);
   HashTableDirectoryPage * dir_page = reinterpret_cast<HashTableDirectoryPage *>(
-          buffer_pool_manager_->FetchPage(directory_page_id_,nullptr)->GetData());
+          buffer_pool_manager_->FetchPage(*directory_page_id,nullptr)->GetData());
   return dir_page;
 }
 
@@ -83,21 +112,138 @@ HASH_TABLE_BUCKET_TYPE *HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_i
   return page;
 }
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+std::vector<std::pair<page_id_t, uint32_t>> HASH_TABLE_TYPE::GroupByBucket(const std::vector<KeyType> &keys) {
+  // order the batch by directory first, so that only one directory page is pinned at a time
+  std::vector<uint32_t> hashes(keys.size());
+  std::vector<std::pair<page_id_t, uint32_t>> order(keys.size());
+  HashTableDirectoryPage *header_page = FetchHeaderPage();
+  for (uint32_t i = 0; i < keys.size(); i++) {
+    hashes[i] = Hash(keys[i]);
+    uint32_t header_idx = (hashes[i] >> DIRECTORY_MAX_DEPTH) & header_page->GetGlobalDepthMask();
+    order[i] = {header_page->GetBucketPageId(header_idx), i};
+  }
+  buffer_pool_manager_->UnpinPage(header_page_id_, false, nullptr);
+  std::sort(order.begin(), order.end());
+  for (size_t begin = 0, end; begin < order.size(); begin = end) {
+    page_id_t directory_page_id = order[begin].first;
+    auto dir_page = reinterpret_cast<HashTableDirectoryPage *>(
+        buffer_pool_manager_->FetchPage(directory_page_id, nullptr)->GetData());
+    for (end = begin; end < order.size() && order[end].first == directory_page_id; end++) {
+      order[end].first = dir_page->GetBucketPageId(hashes[order[end].second] & dir_page->GetGlobalDepthMask());
+    }
+    buffer_pool_manager_->UnpinPage(directory_page_id, false, nullptr);
+  }
+  std::sort(order.begin(), order.end());
+  return order;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+template <typename Visitor>
+bool HASH_TABLE_TYPE::ForEachBucket(const std::vector<std::pair<page_id_t, uint32_t>> &order, Visitor visit) {
+  std::vector<size_t> groups;
+  for (size_t i = 0; i < order.size(); i++) {
+    if (i == 0 || order[i].first != order[i - 1].first) {
+      groups.push_back(i);
+    }
+  }
+  groups.push_back(order.size());
+  size_t num_buckets = groups.size() - 1;
+  // keep up to PREFETCH_QUEUE_SIZE bucket reads in flight ahead of the one being visited
+  for (size_t g = 1; g < num_buckets && g <= static_cast<size_t>(PREFETCH_QUEUE_SIZE); g++) {
+    buffer_pool_manager_->PrefetchPage(order[groups[g]].first);
+  }
+  Page *next_bucket = num_buckets > 0 ? buffer_pool_manager_->FetchPage(order[0].first, nullptr) : nullptr;
+  for (size_t g = 0; g < num_buckets; g++) {
+    Page *bucket = next_bucket;
+    next_bucket = nullptr;
+    if (bucket == nullptr) {
+      // out of frames, nothing is pinned at this point
+      return false;
+    }
+    if (g + 1 < num_buckets) {
+      if (g + 1 + PREFETCH_QUEUE_SIZE < num_buckets) {
+        buffer_pool_manager_->PrefetchPage(order[groups[g + 1 + PREFETCH_QUEUE_SIZE]].first);
+      }
+      // the slot bitmaps and fingerprints of a bucket come first, fetch their cache lines while this bucket is visited
+      next_bucket = buffer_pool_manager_->FetchPage(order[groups[g + 1]].first, nullptr);
+      if (next_bucket != nullptr) {
+        __builtin_prefetch(next_bucket->GetData());
+        __builtin_prefetch(next_bucket->GetData() + 64);
+      }
+    }
+    bool dirty = visit(bucket, groups[g], groups[g + 1]);
+    buffer_pool_manager_->UnpinPage(bucket->GetPageId(), dirty, nullptr);
+  }
+  return true;
+}
+
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) {
-  HashTableDirectoryPage * directory_page = FetchDirectoryPage();
-  table_latch_.RLock();
-  page_id_t page_id = KeyToPageId(key, directory_page);
-  HASH_TABLE_BUCKET_TYPE * bucket_page = FetchBucketPage(page_id);
-  bool flag = bucket_page->GetValue(key,comparator_,result);
+  // The header and the directory are read optimistically. They are still valid once the bucket is read-latched, so
+  // the bucket cannot be split (nor merged away, nor emptied by a directory split) until it has been searched. The
+  // bucket is pinned under the directory's read latch, so that it cannot have been deleted by a merge in between.
+  BasicPageGuard header_guard = buffer_pool_manager_->FetchPageBasic(header_page_id_);
+  Page *header = header_guard.GetPage();
+  while (true) {
+    uint64_t header_version;
+    if (!header->TryOptimisticRead(&header_version)) {
+      std::this_thread::yield();
+      continue;
+    }
+    page_id_t directory_page_id = KeyToDirectoryPageId(key, header_guard.As<HashTableDirectoryPage>());
+    if (!header->ValidateRead(header_version)) {
+      continue;
+    }
+    // directory pages are never deleted, so a stale one is still safe to read before validating the header again
+    BasicPageGuard directory_guard = buffer_pool_manager_->FetchPageBasic(directory_page_id);
+    Page *directory = directory_guard.GetPage();
+    uint64_t version;
+    if (!directory->TryOptimisticRead(&version)) {
+      std::this_thread::yield();
+      continue;
+    }
+    page_id_t page_id = KeyToPageId(key, directory_guard.As<HashTableDirectoryPage>());
+    if (!directory->ValidateRead(version)) {
+      continue;
+    }
+    directory->RLatch();
+    Page *bucket = directory->ValidateRead(version) ? buffer_pool_manager_->FetchPage(page_id, nullptr) : nullptr;
+    directory->RUnlatch();
+    if (bucket == nullptr) {
+      continue;
+    }
+    bucket->RLatch();
+    ReadPageGuard bucket_guard(buffer_pool_manager_, bucket);
+    if (!directory->ValidateRead(version) || !header->ValidateRead(header_version)) {
+      continue;
+    }
+    return bucket_guard.As<HASH_TABLE_BUCKET_TYPE>()->GetValue(key, comparator_, result);
+  }
+}
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::GetValueBatch(Transaction *transaction, const std::vector<KeyType> &keys,
+                                    std::vector<std::vector<ValueType>> *results) {
+  results->assign(keys.size(), std::vector<ValueType>());
+  // unlike GetValue, the batch holds the table latch, so that the buckets it resolved up front stay the keys' buckets
+  table_latch_.RLock();
+  std::vector<std::pair<page_id_t, uint32_t>> order = GroupByBucket(keys);
+  bool complete = ForEachBucket(order, [&](Page *bucket, size_t begin, size_t end) {
+    auto bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(bucket->GetData());
+    bucket->RLatch();
+    for (size_t i = begin; i < end; i++) {
+      uint32_t key_idx = order[i].second;
+      bucket_page->GetValue(keys[key_idx], comparator_, &(*results)[key_idx]);
+    }
+    bucket->RUnlatch();
+    return false;
+  });
   table_latch_.RUnlock();
-  buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr);
-  buffer_pool_manager_->UnpinPage(page_id, false, nullptr);
-  return flag;
+  return complete;
 }
 
 /*****************************************************************************
@@ -105,94 +251,411 @@ bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  HashTableDirectoryPage * dir_page = FetchDirectoryPage();
+  // inserts into different buckets run side by side: the table latch is shared and only the bucket is write-latched,
+  // since the directory cannot change until SplitInsert or Merge takes the table latch exclusively
+  table_latch_.RLock();
+  page_id_t directory_page_id;
+  HashTableDirectoryPage * dir_page = FetchDirectoryPage(key, &directory_page_id);
+  page_id_t bucket_page_id = KeyToPageId(key, dir_page);
+  Page *bucket = buffer_pool_manager_->FetchPage(bucket_page_id, nullptr);
+  auto bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(bucket->GetData());
+  bucket->WLatch();
+  bool inserted = bucket_page->Insert(key, value, comparator_);
+  bool full = !inserted && bucket_page->IsFull();
+  bucket->WUnlatch();
+  table_latch_.RUnlock();
+  buffer_pool_manager_->UnpinPage(directory_page_id,false,nullptr);
+  buffer_pool_manager_->UnpinPage(bucket_page_id,inserted,nullptr);
+  if(full && SplitInsert(transaction, key, value)){
+    // the bucket was split, retry in the half the key belongs to
+    return Insert(transaction, key, value);
+  }
+  // inserted, duplicate, or the table cannot grow
+  return inserted;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+size_t HASH_TABLE_TYPE::InsertBatch(Transaction *transaction, const std::vector<KeyType> &keys,
+                                    const std::vector<ValueType> &values, bool *complete) {
+  size_t num_inserted = 0;
+  std::vector<uint32_t> overflow;
+  table_latch_.RLock();
+  std::vector<std::pair<page_id_t, uint32_t>> order = GroupByBucket(keys);
+  bool visited_all = ForEachBucket(order, [&](Page *bucket, size_t begin, size_t end) {
+    auto bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(bucket->GetData());
+    bool dirty = false;
+    bucket->WLatch();
+    for (size_t i = begin; i < end; i++) {
+      uint32_t key_idx = order[i].second;
+      if (bucket_page->Insert(keys[key_idx], values[key_idx], comparator_)) {
+        num_inserted++;
+        dirty = true;
+      } else if (bucket_page->IsFull()) {
+        overflow.push_back(key_idx);
+      }
+    }
+    bucket->WUnlatch();
+    return dirty;
+  });
+  table_latch_.RUnlock();
+  if (complete != nullptr) {
+    *complete = visited_all;
+  }
+  if (!visited_all) {
+    return num_inserted;
+  }
+  // the buckets that filled up are split one pair at a time
+  for (uint32_t key_idx : overflow) {
+    num_inserted += Insert(transaction, keys[key_idx], values[key_idx]) ? 1 : 0;
+  }
+  return num_inserted;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+size_t HASH_TABLE_TYPE::BulkLoad(Transaction *transaction, const std::vector<KeyType> &keys,
+                                 const std::vector<ValueType> &values) {
   table_latch_.WLock();
-  uint32_t bucket_id = KeyToDirectoryIndex(key, dir_page);
-  page_id_t bucket_page_id =  dir_page->GetBucketPageId(bucket_id);
-  HASH_TABLE_BUCKET_TYPE * bucket_page = FetchBucketPage(bucket_page_id);
-  if(bucket_page->Insert(key, value, comparator_)){
+  Page *header = buffer_pool_manager_->FetchPage(header_page_id_, nullptr);
+  auto header_page = reinterpret_cast<HashTableDirectoryPage *>(header->GetData());
+  page_id_t root_directory_page_id = header_page->GetBucketPageId(0);
+  Page *root_directory = buffer_pool_manager_->FetchPage(root_directory_page_id, nullptr);
+  auto root_dir_page = reinterpret_cast<HashTableDirectoryPage *>(root_directory->GetData());
+  page_id_t root_bucket_page_id = root_dir_page->GetBucketPageId(0);
+  Page *root_bucket = buffer_pool_manager_->FetchPage(root_bucket_page_id, nullptr);
+  auto root_bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(root_bucket->GetData());
+  if(header_page->GetGlobalDepth()!=0 || root_dir_page->GetGlobalDepth()!=0 || !root_bucket_page->IsEmpty()){
     table_latch_.WUnlock();
-    buffer_pool_manager_->UnpinPage(directory_page_id_,false,nullptr);
-    buffer_pool_manager_->UnpinPage(bucket_page_id,true,nullptr);
-    return true;
-  }
-  bool flag = bucket_page->IsFull();
-  //table_latch_.WUnlock();
-  if(flag){
-    //is full
-    if(SplitInsert(transaction, key, value)){
-      table_latch_.WUnlock();
-      buffer_pool_manager_->UnpinPage(directory_page_id_,false,nullptr);
-      buffer_pool_manager_->UnpinPage(bucket_page_id,false,nullptr);
-      return true;
+    buffer_pool_manager_->UnpinPage(header_page_id_,false,nullptr);
+    buffer_pool_manager_->UnpinPage(root_directory_page_id,false,nullptr);
+    buffer_pool_manager_->UnpinPage(root_bucket_page_id,false,nullptr);
+    return InsertBatch(transaction, keys, values);
+  }
+
+  // pick the depth: start from the number of buckets the pairs need at best, and add hash bits as long as some
+  // partition overflows a bucket and the extra bit still splits the largest one (it cannot split equal keys)
+  std::vector<uint32_t> hashes(keys.size());
+  for(size_t i = 0; i < keys.size(); i++){
+    hashes[i] = Hash(keys[i]);
+  }
+  auto count_partitions = [&hashes](uint32_t depth) {
+    std::vector<size_t> counts(static_cast<size_t>(1) << depth);
+    uint32_t mask = (0x1U << depth) - 1;
+    for(uint32_t hash : hashes){
+      counts[hash & mask]++;
+    }
+    return counts;
+  };
+  const uint32_t max_depth = 2 * DIRECTORY_MAX_DEPTH;
+  uint32_t depth = 0;
+  while(depth < max_depth && (keys.size() >> depth) > BUCKET_ARRAY_SIZE){
+    depth++;
+  }
+  std::vector<size_t> counts = count_partitions(depth);
+  size_t largest = *std::max_element(counts.begin(), counts.end());
+  while(depth < max_depth && largest > BUCKET_ARRAY_SIZE){
+    std::vector<size_t> deeper_counts = count_partitions(depth + 1);
+    size_t deeper_largest = *std::max_element(deeper_counts.begin(), deeper_counts.end());
+    if(deeper_largest == largest){
+      break;
+    }
+    depth++;
+    counts = std::move(deeper_counts);
+    largest = deeper_largest;
+  }
+
+  // radix-partition the pairs by the low depth bits of their hash
+  std::vector<size_t> offsets(counts.size() + 1, 0);
+  for(size_t p = 0; p < counts.size(); p++){
+    offsets[p + 1] = offsets[p] + counts[p];
+  }
+  std::vector<MappingType> partitioned(keys.size());
+  {
+    std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+    uint32_t mask = (0x1U << depth) - 1;
+    for(size_t i = 0; i < keys.size(); i++){
+      partitioned[next[hashes[i] & mask]++] = MappingType(keys[i], values[i]);
+    }
+  }
+
+  // the directory bits come first, the header maps the ones above them; every directory and every bucket gets the
+  // full depth, so that each bucket has exactly one directory slot
+  uint32_t header_depth = depth > DIRECTORY_MAX_DEPTH ? depth - DIRECTORY_MAX_DEPTH : 0;
+  uint32_t directory_depth = depth - header_depth;
+  size_t num_inserted = 0;
+  std::vector<size_t> overflow;
+  header->WLatch();
+  root_directory->WLatch();
+  root_bucket->WLatch();
+  for(uint32_t i = 0; i < header_depth; i++){
+    header_page->IncrGlobalDepth();
+  }
+  for(uint32_t header_idx = 0; header_idx < header_page->Size(); header_idx++){
+    page_id_t directory_page_id = root_directory_page_id;
+    HashTableDirectoryPage *dir_page = root_dir_page;
+    if(header_idx != 0){
+      dir_page = reinterpret_cast<HashTableDirectoryPage *>(
+              buffer_pool_manager_->NewPageInSegment(&directory_page_id, &segment_)->GetData());
+      dir_page->SetPageId(directory_page_id);
+    }
+    header_page->SetBucketPageId(header_idx, directory_page_id);
+    header_page->SetLocalDepth(header_idx, header_depth);
+    for(uint32_t i = 0; i < directory_depth; i++){
+      dir_page->IncrGlobalDepth();
+    }
+    for(uint32_t bucket_id = 0; bucket_id < dir_page->Size(); bucket_id++){
+      page_id_t bucket_page_id = root_bucket_page_id;
+      HASH_TABLE_BUCKET_TYPE *bucket_page = root_bucket_page;
+      if(header_idx != 0 || bucket_id != 0){
+        bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(
+                buffer_pool_manager_->NewPageInSegment(&bucket_page_id, &segment_)->GetData());
+      }
+      dir_page->SetBucketPageId(bucket_id, bucket_page_id);
+      dir_page->SetLocalDepth(bucket_id, directory_depth);
+      dir_page->SetHeaderDepth(bucket_id, header_depth);
+      uint32_t partition = (header_idx << DIRECTORY_MAX_DEPTH) | bucket_id;
+      for(size_t k = offsets[partition]; k < offsets[partition + 1]; k++){
+        if(bucket_page->Insert(partitioned[k].first, partitioned[k].second, comparator_)){
+          num_inserted++;
+        }else if(bucket_page->IsFull()){
+          overflow.push_back(k);
+        }
+      }
+      if(bucket_page_id != root_bucket_page_id){
+        buffer_pool_manager_->UnpinPage(bucket_page_id,true,nullptr);
+      }
+    }
+    if(directory_page_id != root_directory_page_id){
+      buffer_pool_manager_->UnpinPage(directory_page_id,true,nullptr);
     }
   }
-  // dupli and SplitInsert false
+  root_bucket->WUnlatch();
+  root_directory->WUnlatch();
+  header->WUnlatch();
   table_latch_.WUnlock();
-  buffer_pool_manager_->UnpinPage(directory_page_id_,false,nullptr);
-  buffer_pool_manager_->UnpinPage(bucket_page_id,false,nullptr);
-  return false;
+  buffer_pool_manager_->UnpinPage(header_page_id_,true,nullptr);
+  buffer_pool_manager_->UnpinPage(root_directory_page_id,true,nullptr);
+  buffer_pool_manager_->UnpinPage(root_bucket_page_id,true,nullptr);
+  // only runs of equal hashes larger than a bucket, or a table at its maximum depth, are left over
+  for(size_t k : overflow){
+    num_inserted += Insert(transaction, partitioned[k].first, partitioned[k].second) ? 1 : 0;
+  }
+  return num_inserted;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  HashTableDirectoryPage * dir_page = FetchDirectoryPage();
+  table_latch_.WLock();
+  Page *header = buffer_pool_manager_->FetchPage(header_page_id_, nullptr);
+  if(header == nullptr){
+    table_latch_.WUnlock();
+    return false;
+  }
+  auto header_page = reinterpret_cast<HashTableDirectoryPage *>(header->GetData());
+  uint32_t header_idx = KeyToHeaderIndex(key, header_page);
+  page_id_t directory_page_id = header_page->GetBucketPageId(header_idx);
+  Page *directory = buffer_pool_manager_->FetchPage(directory_page_id, nullptr);
+  if(directory == nullptr){
+    table_latch_.WUnlock();
+    buffer_pool_manager_->UnpinPage(header_page_id_,false,nullptr);
+    return false;
+  }
+  auto dir_page = reinterpret_cast<HashTableDirectoryPage *>(directory->GetData());
   uint32_t bucket_id = KeyToDirectoryIndex(key, dir_page);
   page_id_t bucket_page_id =  dir_page->GetBucketPageId(bucket_id);
-  HASH_TABLE_BUCKET_TYPE * bucket_page = FetchBucketPage(bucket_page_id);
-  // local depth == global depth
-  if(dir_page->GetLocalDepth(bucket_id)==dir_page->GetGlobalDepth()){
-    if(dir_page->CanIncrGlobalDepth()){
-      uint32_t  current_bucket_size = dir_page->Size();
-      for(uint32_t temp_bucket_id = 0; temp_bucket_id < current_bucket_size; temp_bucket_id++){
-        dir_page->SetBucketPageId(temp_bucket_id+current_bucket_size, dir_page->GetBucketPageId(temp_bucket_id));
-        dir_page->SetLocalDepth(temp_bucket_id+current_bucket_size, dir_page->GetLocalDepth(temp_bucket_id) );
+  Page *bucket = buffer_pool_manager_->FetchPage(bucket_page_id, nullptr);
+  // another insert may have split the bucket, or a remove made room, since Insert let go of the table latch
+  bool full = bucket != nullptr && reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(bucket->GetData())->IsFull();
+  if(bucket != nullptr){
+    buffer_pool_manager_->UnpinPage(bucket_page_id,false,nullptr);
+  }
+  uint32_t local_depth = dir_page->GetLocalDepth(bucket_id);
+  uint32_t header_depth = dir_page->GetHeaderDepth(bucket_id);
+  bool by_header_bit = local_depth==dir_page->GetGlobalDepth() && !dir_page->CanIncrGlobalDepth();
+  bool split = bucket != nullptr;
+  bool header_dirty = false;
+  bool directory_dirty = false;
+  if(!full){
+    // nothing to do, or out of frames
+  }else if(by_header_bit && header_depth==header_page->GetLocalDepth(header_idx)){
+    // the bucket is split by every hash bit the directory has, split the directory instead; the retry then splits the
+    // bucket by the new header bit
+    split = SplitDirectory(header, header_idx, dir_page);
+    header_dirty = split;
+  }else{
+    if(!by_header_bit && local_depth==dir_page->GetGlobalDepth()){
+      // a directory with room to grow is the only one, since only full directories are split
+      directory->WLatch();
+      GrowDirectory(dir_page);
+      directory->WUnlatch();
+      directory_dirty = true;
+    }
+    split = SplitBucket(header_page, header_idx, bucket_id, bucket_page_id, local_depth, header_depth, by_header_bit);
+  }
+  table_latch_.WUnlock();
+  buffer_pool_manager_->UnpinPage(directory_page_id,directory_dirty,nullptr);
+  buffer_pool_manager_->UnpinPage(header_page_id_,header_dirty,nullptr);
+  return split;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::SplitBucket(HashTableDirectoryPage *header_page, uint32_t header_idx, uint32_t bucket_id,
+                                  page_id_t bucket_page_id, uint32_t local_depth, uint32_t header_depth,
+                                  bool by_header_bit) {
+  page_id_t new_bucket_page_id;
+  Page *new_bucket = buffer_pool_manager_->NewPageInSegment(&new_bucket_page_id, &segment_);
+  if(new_bucket == nullptr){
+    return false;
+  }
+  Page *bucket = buffer_pool_manager_->FetchPage(bucket_page_id, nullptr);
+  if(bucket == nullptr){
+    buffer_pool_manager_->UnpinPage(new_bucket_page_id,false,nullptr);
+    buffer_pool_manager_->DeletePage(new_bucket_page_id);
+    return false;
+  }
+  // Both halves start out with all the pairs, so that lookups find them whichever directory was updated yet. Every
+  // directory sharing the bucket then points the indexes of the split bit at the new half.
+  memcpy(new_bucket->GetData(), bucket->GetData(), PAGE_SIZE);
+  uint32_t low_mask = (0x1U << local_depth) - 1;
+  auto update = [&](HashTableDirectoryPage *dir_page, uint32_t pattern) {
+    for(uint32_t idx = bucket_id & low_mask; idx < dir_page->Size(); idx += low_mask + 1){
+      if(by_header_bit){
+        dir_page->SetBucketPageId(idx, ((pattern >> header_depth) & 0x1) != 0 ? new_bucket_page_id : bucket_page_id);
+        dir_page->IncrHeaderDepth(idx);
+      }else{
+        dir_page->SetBucketPageId(idx, (idx & (low_mask + 1)) != 0 ? new_bucket_page_id : bucket_page_id);
+        dir_page->IncrLocalDepth(idx);
       }
-      dir_page->IncrGlobalDepth();
-    }else{
-      buffer_pool_manager_->UnpinPage(directory_page_id_,false,nullptr);
-      buffer_pool_manager_->UnpinPage(bucket_page_id,false,nullptr);
-      return false;
-    }    
-  }
-
-  // local depth < global depth
-  if(dir_page->GetLocalDepth(bucket_id)<dir_page->GetGlobalDepth()){
-    // local depth < global depth
-    page_id_t new_buctet_page_id;
-    HASH_TABLE_BUCKET_TYPE* new_buctet_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE*>(
-            buffer_pool_manager_->NewPage(&new_buctet_page_id, nullptr)->GetData() );
-    uint32_t locale_hight_bit = 0x1<< dir_page->GetLocalDepth(bucket_id);
-    uint32_t shared_bit =  bucket_id & (locale_hight_bit - 1);
-    uint32_t current_bucket_size = dir_page->Size();
-    for(uint32_t temp_bucket_id = shared_bit; temp_bucket_id < current_bucket_size; temp_bucket_id += locale_hight_bit){
-      if(temp_bucket_id & locale_hight_bit){
-        dir_page->SetBucketPageId(temp_bucket_id,new_buctet_page_id);
+    }
+  };
+  auto undo = [&](HashTableDirectoryPage *dir_page, uint32_t /*pattern*/) {
+    for(uint32_t idx = bucket_id & low_mask; idx < dir_page->Size(); idx += low_mask + 1){
+      dir_page->SetBucketPageId(idx, bucket_page_id);
+      if(by_header_bit){
+        dir_page->DecrHeaderDepth(idx);
+      }else{
+        dir_page->DecrLocalDepth(idx);
+      }
+    }
+  };
+  if(!UpdateDirectories(SharingDirectories(header_page, header_idx, header_depth), update, undo)){
+    buffer_pool_manager_->UnpinPage(bucket_page_id,false,nullptr);
+    buffer_pool_manager_->UnpinPage(new_bucket_page_id,false,nullptr);
+    // a lookup through a directory that was updated for a moment may still hold the new half
+    while (!buffer_pool_manager_->DeletePage(new_bucket_page_id)) {
+      std::this_thread::yield();
+    }
+    return false;
+  }
+  // now drop from each half the pairs that belong to the other one
+  uint32_t split_bit = by_header_bit ? 0x1U << (DIRECTORY_MAX_DEPTH + header_depth) : low_mask + 1;
+  auto bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(bucket->GetData());
+  auto new_bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(new_bucket->GetData());
+  bucket->WLatch();
+  new_bucket->WLatch();
+  uint32_t bucket_occupied_size = bucket_page->GetOccupiedSize();
+  for(uint32_t bucket_idx = 0; bucket_idx < bucket_occupied_size; bucket_idx++){
+    if(bucket_page->IsReadable(bucket_idx)){
+      if((Hash(bucket_page->KeyAt(bucket_idx)) & split_bit) != 0){
+        bucket_page->RemoveAt(bucket_idx);
+      }else{
+        new_bucket_page->RemoveAt(bucket_idx);
       }
-      dir_page->IncrLocalDepth(temp_bucket_id);
     }
-    //flash 
-    memcpy(reinterpret_cast<void*>(new_buctet_page), reinterpret_cast<void*>(bucket_page),PAGE_SIZE);
-    uint32_t bucket_occupid_size =  bucket_page->GetOccupiedSize();
-    for(uint32_t bucket_idx =0; bucket_idx < bucket_occupid_size; bucket_idx++){
-      if(bucket_page->IsReadable(bucket_idx)){
-          //allocat
-        if(KeyToPageId(bucket_page->KeyAt(bucket_idx),dir_page) == bucket_page_id){
-          new_buctet_page->RemoveAt(bucket_idx);
-        }else{
-          bucket_page->RemoveAt(bucket_idx);
+  }
+  new_bucket->WUnlatch();
+  bucket->WUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page_id,true,nullptr);
+  buffer_pool_manager_->UnpinPage(new_bucket_page_id,true,nullptr);
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+std::vector<std::pair<page_id_t, uint32_t>> HASH_TABLE_TYPE::SharingDirectories(HashTableDirectoryPage *header_page,
+                                                                                uint32_t header_idx,
+                                                                                uint32_t header_depth) {
+  std::vector<std::pair<page_id_t, uint32_t>> directories;
+  uint32_t mask = (0x1U << header_depth) - 1;
+  for(uint32_t idx = header_idx & mask; idx < header_page->Size(); idx += mask + 1){
+    // each directory once, at the first header index pointing to it
+    if(idx < (0x1U << header_page->GetLocalDepth(idx))){
+      directories.emplace_back(header_page->GetBucketPageId(idx), idx);
+    }
+  }
+  return directories;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+template <typename Update, typename Undo>
+bool HASH_TABLE_TYPE::UpdateDirectories(const std::vector<std::pair<page_id_t, uint32_t>> &directories, Update update,
+                                        Undo undo) {
+  for(size_t i = 0; i < directories.size(); i++){
+    Page *directory = buffer_pool_manager_->FetchPage(directories[i].first, nullptr);
+    if(directory == nullptr){
+      // out of frames: put back the directories updated so far, they were just used and are likely still resident
+      for(size_t j = 0; j < i; j++){
+        Page *updated;
+        while((updated = buffer_pool_manager_->FetchPage(directories[j].first, nullptr)) == nullptr){
+          std::this_thread::yield();
         }
+        updated->WLatch();
+        undo(reinterpret_cast<HashTableDirectoryPage *>(updated->GetData()), directories[j].second);
+        updated->WUnlatch();
+        buffer_pool_manager_->UnpinPage(directories[j].first,true,nullptr);
       }
+      return false;
     }
-    buffer_pool_manager_->UnpinPage(new_buctet_page_id,true,nullptr);
+    directory->WLatch();
+    update(reinterpret_cast<HashTableDirectoryPage *>(directory->GetData()), directories[i].second);
+    directory->WUnlatch();
+    buffer_pool_manager_->UnpinPage(directories[i].first,true,nullptr);
   }
-  table_latch_.WUnlock();
-  buffer_pool_manager_->UnpinPage(directory_page_id_,true,nullptr);
-  buffer_pool_manager_->UnpinPage(bucket_page_id,true, nullptr);
-  if(Insert(transaction, key, value)){
-    return true;
+  return true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::GrowDirectory(HashTableDirectoryPage *dir_page) {
+  uint32_t  current_bucket_size = dir_page->Size();
+  for(uint32_t temp_bucket_id = 0; temp_bucket_id < current_bucket_size; temp_bucket_id++){
+    dir_page->SetBucketPageId(temp_bucket_id+current_bucket_size, dir_page->GetBucketPageId(temp_bucket_id));
+    dir_page->SetLocalDepth(temp_bucket_id+current_bucket_size, dir_page->GetLocalDepth(temp_bucket_id) );
+    dir_page->SetHeaderDepth(temp_bucket_id+current_bucket_size, dir_page->GetHeaderDepth(temp_bucket_id) );
+  }
+  dir_page->IncrGlobalDepth();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::SplitDirectory(Page *header, uint32_t header_idx, HashTableDirectoryPage *dir_page) {
+  auto header_page = reinterpret_cast<HashTableDirectoryPage *>(header->GetData());
+  uint32_t header_local_depth = header_page->GetLocalDepth(header_idx);
+  if(header_local_depth==header_page->GetGlobalDepth() && !header_page->CanIncrGlobalDepth()){
+    return false;
   }
-  return false;
+  // The new directory takes the keys with the next hash bit above the ones the header already uses. It starts out as
+  // a copy, sharing every bucket with the full directory; only the bucket that overflowed is split, on the retry.
+  page_id_t new_directory_page_id;
+  Page *new_directory = buffer_pool_manager_->NewPageInSegment(&new_directory_page_id, &segment_);
+  if(new_directory == nullptr){
+    return false;
+  }
+  auto new_dir_page = reinterpret_cast<HashTableDirectoryPage *>(new_directory->GetData());
+  memcpy(reinterpret_cast<void*>(new_dir_page), reinterpret_cast<void*>(dir_page), PAGE_SIZE);
+  new_dir_page->SetPageId(new_directory_page_id);
+  header->WLatch();
+  if(header_local_depth==header_page->GetGlobalDepth()){
+    GrowDirectory(header_page);
+  }
+  // point the header entries of the split bit at the new directory
+  uint32_t header_hight_bit = 0x1 << header_local_depth;
+  uint32_t shared_bit = header_idx & (header_hight_bit - 1);
+  for(uint32_t temp_header_id = shared_bit; temp_header_id < header_page->Size(); temp_header_id += header_hight_bit){
+    if(temp_header_id & header_hight_bit){
+      header_page->SetBucketPageId(temp_header_id,new_directory_page_id);
+    }
+    header_page->IncrLocalDepth(temp_header_id);
+  }
+  header->WUnlatch();
+  buffer_pool_manager_->UnpinPage(new_directory_page_id,true,nullptr);
+  return true;
 }
 
 /*****************************************************************************
@@ -200,27 +663,23 @@ bool HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  HashTableDirectoryPage * dir_page = FetchDirectoryPage();
-  table_latch_.WLock();
-  uint32_t bucket_id = KeyToDirectoryIndex(key, dir_page);
-  page_id_t bucket_page_id =  dir_page->GetBucketPageId(bucket_id);
-  HASH_TABLE_BUCKET_TYPE * bucket_page = FetchBucketPage(bucket_page_id);
-
-  bool flag = bucket_page->Remove(key, value, comparator_);
-  if(flag&&bucket_page->IsEmpty()){
-    // removed
+  table_latch_.RLock();
+  page_id_t directory_page_id;
+  HashTableDirectoryPage * dir_page = FetchDirectoryPage(key, &directory_page_id);
+  page_id_t bucket_page_id = KeyToPageId(key, dir_page);
+  Page *bucket = buffer_pool_manager_->FetchPage(bucket_page_id, nullptr);
+  auto bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(bucket->GetData());
+  bucket->WLatch();
+  bool removed = bucket_page->Remove(key, value, comparator_);
+  bool empty = removed && bucket_page->IsEmpty();
+  bucket->WUnlatch();
+  table_latch_.RUnlock();
+  buffer_pool_manager_->UnpinPage(directory_page_id,false,nullptr);
+  buffer_pool_manager_->UnpinPage(bucket_page_id,removed,nullptr);
+  if(empty){
     Merge(transaction, key, value);
-
-    table_latch_.WUnlock();
-    buffer_pool_manager_->UnpinPage(directory_page_id_,true,nullptr);
-    buffer_pool_manager_->UnpinPage(bucket_page_id,true,nullptr);
-    return flag;
   }
-
-  table_latch_.WUnlock();
-  buffer_pool_manager_->UnpinPage(directory_page_id_,false,nullptr);
-  buffer_pool_manager_->UnpinPage(bucket_page_id,true,nullptr);
-  return flag;
+  return removed;
 }
 
 /*****************************************************************************
@@ -228,29 +687,67 @@ bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  HashTableDirectoryPage * dir_page = FetchDirectoryPage();
+  table_latch_.WLock();
+  Page *header = buffer_pool_manager_->FetchPage(header_page_id_, nullptr);
+  if(header == nullptr){
+    table_latch_.WUnlock();
+    return;
+  }
+  auto header_page = reinterpret_cast<HashTableDirectoryPage *>(header->GetData());
+  uint32_t header_idx = KeyToHeaderIndex(key, header_page);
+  page_id_t directory_page_id = header_page->GetBucketPageId(header_idx);
+  Page *directory = buffer_pool_manager_->FetchPage(directory_page_id, nullptr);
+  if(directory == nullptr){
+    table_latch_.WUnlock();
+    buffer_pool_manager_->UnpinPage(header_page_id_,false,nullptr);
+    return;
+  }
+  auto dir_page = reinterpret_cast<HashTableDirectoryPage *>(directory->GetData());
   uint32_t bucket_id = KeyToDirectoryIndex(key, dir_page);
   page_id_t bucket_page_id =  dir_page->GetBucketPageId(bucket_id);
-  //HASH_TABLE_BUCKET_TYPE * bucket_page = FetchBucketPage(bucket_page_id);
   uint32_t bucket_local_depth =  dir_page->GetLocalDepth(bucket_id);
-  // root bucket
-  if(bucket_local_depth==0){
-    return;
+  // root bucket, or a bucket split by a header bit, whose pair is in other directories: leave it
+  bool merged = bucket_local_depth!=0 && dir_page->GetHeaderDepth(bucket_id)==0;
+  if(merged){
+    // an insert may have refilled the bucket since Remove let go of the table latch
+    Page *bucket = buffer_pool_manager_->FetchPage(bucket_page_id, nullptr);
+    merged = bucket != nullptr && reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(bucket->GetData())->IsEmpty();
+    if(bucket != nullptr){
+      buffer_pool_manager_->UnpinPage(bucket_page_id,false,nullptr);
+    }
   }
-  // not root bucket, find the other bucket
-  uint32_t other_bucket_id =  bucket_id^(0x1<<(bucket_local_depth-1));
+  // find its pair, the bucket it was split from
+  uint32_t split_bit = merged ? 0x1U << (bucket_local_depth - 1) : 0;
+  uint32_t other_bucket_id = bucket_id ^ split_bit;
   page_id_t other_bucket_page_id = dir_page->GetBucketPageId(other_bucket_id);
-  //merge 
-  if(dir_page->GetLocalDepth(other_bucket_id)==bucket_local_depth){
-    uint32_t shared = bucket_id &((0x1<<(bucket_local_depth-1))-1);
-    uint32_t current_bucket_size = dir_page->Size();
-    for(uint32_t temp_bucket_id = shared; temp_bucket_id < current_bucket_size; temp_bucket_id+=(0x1<<(bucket_local_depth-1)) ){
-      dir_page->SetBucketPageId(temp_bucket_id, other_bucket_page_id);
-      dir_page->DecrLocalDepth(temp_bucket_id);
+  merged = merged && dir_page->GetLocalDepth(other_bucket_id)==bucket_local_depth &&
+           dir_page->GetHeaderDepth(other_bucket_id)==0;
+  if(merged){
+    // both buckets are shared by every directory
+    auto update = [&](HashTableDirectoryPage *shared_dir_page, uint32_t /*pattern*/) {
+      for(uint32_t idx = bucket_id & (split_bit - 1); idx < shared_dir_page->Size(); idx += split_bit){
+        shared_dir_page->SetBucketPageId(idx, other_bucket_page_id);
+        shared_dir_page->DecrLocalDepth(idx);
+      }
+    };
+    auto undo = [&](HashTableDirectoryPage *shared_dir_page, uint32_t /*pattern*/) {
+      for(uint32_t idx = bucket_id & (split_bit - 1); idx < shared_dir_page->Size(); idx += split_bit){
+        bool own_half = (idx & split_bit) == (bucket_id & split_bit);
+        shared_dir_page->SetBucketPageId(idx, own_half ? bucket_page_id : other_bucket_page_id);
+        shared_dir_page->IncrLocalDepth(idx);
+      }
+    };
+    merged = UpdateDirectories(SharingDirectories(header_page, header_idx, 0), update, undo);
+  }
+  if(merged){
+    // a GetValue that pinned the bucket before the directory changed lets go of it once it fails to validate
+    while (!buffer_pool_manager_->DeletePage(bucket_page_id)) {
+      std::this_thread::yield();
     }
-    buffer_pool_manager_->DeletePage(bucket_page_id);
   }
-  buffer_pool_manager_->UnpinPage(directory_page_id_,true,nullptr);
+  table_latch_.WUnlock();
+  buffer_pool_manager_->UnpinPage(directory_page_id,false,nullptr);
+  buffer_pool_manager_->UnpinPage(header_page_id_,false,nullptr);
 }
 
 /*****************************************************************************
@@ -258,11 +755,19 @@ void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 uint32_t HASH_TABLE_TYPE::GetGlobalDepth() {
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  // the number of hash bits the deepest directory uses: a directory is only split once it is full
   table_latch_.RLock();
-  uint32_t global_depth = dir_page->GetGlobalDepth();
+  HashTableDirectoryPage *header_page = FetchHeaderPage();
+  uint32_t global_depth = header_page->GetGlobalDepth() + DIRECTORY_MAX_DEPTH;
+  if(header_page->GetGlobalDepth()==0){
+    page_id_t directory_page_id = header_page->GetBucketPageId(0);
+    auto dir_page = reinterpret_cast<HashTableDirectoryPage *>(
+            buffer_pool_manager_->FetchPage(directory_page_id,nullptr)->GetData());
+    global_depth = dir_page->GetGlobalDepth();
+    buffer_pool_manager_->UnpinPage(directory_page_id, false, nullptr);
+  }
+  assert(buffer_pool_manager_->UnpinPage(header_page_id_, false, nullptr));
   table_latch_.RUnlock();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
   return global_depth;
 }
 
@@ -272,9 +777,19 @@ uint32_t HASH_TABLE_TYPE::GetGlobalDepth() {
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::VerifyIntegrity() {
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  dir_page->VerifyIntegrity();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+  HashTableDirectoryPage *header_page = FetchHeaderPage();
+  header_page->VerifyIntegrity();
+  for (uint32_t header_idx = 0; header_idx < header_page->Size(); header_idx++) {
+    // visit each directory once, at the first header index pointing to it
+    if (header_idx < (0x1U << header_page->GetLocalDepth(header_idx))) {
+      page_id_t directory_page_id = header_page->GetBucketPageId(header_idx);
+      auto dir_page = reinterpret_cast<HashTableDirectoryPage *>(
+          buffer_pool_manager_->FetchPage(directory_page_id, nullptr)->GetData());
+      dir_page->VerifyIntegrity();
+      buffer_pool_manager_->UnpinPage(directory_page_id, false, nullptr);
+    }
+  }
+  assert(buffer_pool_manager_->UnpinPage(header_page_id_, false, nullptr));
   table_latch_.RUnlock();
 }
 
@@ -23,6 +23,7 @@ InsertExecutor::InsertExecutor(ExecutorContext *exec_ctx, const InsertPlanNode *
     child_executor_(std::move(child_executor)) {
         table_info_ = exec_ctx_->GetCatalog()->GetTable(plan_->TableOid());
         table_indexs_ = exec_ctx_->GetCatalog()->GetTableIndexes(table_info_->name_);
+        index_keys_.resize(table_indexs_.size());
     }
 
 void InsertExecutor::Init() {
@@ -36,6 +37,7 @@ bool InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) {
 
     if(plan_->IsRawInsert()){
         if(insert_next_>=plan_->RawValues().size()){
+            FlushIndexEntries();
             return false;
         }else{
             const std::vector<Value> &raw_val = plan_->RawValuesAt(insert_next_); 
@@ -44,17 +46,41 @@ bool InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) {
         }
     }else{
         if(!child_executor_->Next(tuple,rid)){
+            FlushIndexEntries();
             return false;
         }
     }
     isinserted = table_info_->table_->InsertTuple(*tuple,rid,exec_ctx_->GetTransaction());
-    // 索引插入
+    // 索引插入: the entries are buffered and inserted a batch at a time
     if(isinserted){
-        for(auto &table_index: table_indexs_){
-            auto key_index = tuple->KeyFromTuple(table_info_->schema_,table_index->key_schema_, table_index->index_->GetKeyAttrs());
-            table_index->index_->InsertEntry( key_index, *rid, exec_ctx_->GetTransaction());
+        for(size_t i = 0; i < table_indexs_.size(); i++){
+            auto &table_index = table_indexs_[i];
+            index_keys_[i].push_back(tuple->KeyFromTuple(table_info_->schema_,table_index->key_schema_, table_index->index_->GetKeyAttrs()));
         }
+        index_rids_.push_back(*rid);
+        if(index_rids_.size() >= static_cast<size_t>(INDEX_BATCH_SIZE)){
+            FlushIndexEntries();
+        }
+    }else{
+        FlushIndexEntries();
     }
     return isinserted;
 }
+
+void InsertExecutor::FlushIndexEntries() {
+    if(index_rids_.empty()){
+        return;
+    }
+    for(size_t i = 0; i < table_indexs_.size(); i++){
+        Index *index = table_indexs_[i]->index_.get();
+        if(!index->InsertEntries(index_keys_[i], index_rids_, exec_ctx_->GetTransaction())){
+            // the batch stopped partway, insert one entry at a time; the ones already in are skipped as duplicates
+            for(size_t j = 0; j < index_rids_.size(); j++){
+                index->InsertEntry(index_keys_[i][j], index_rids_[j], exec_ctx_->GetTransaction());
+            }
+        }
+        index_keys_[i].clear();
+    }
+    index_rids_.clear();
+}
 }  // namespace bustub
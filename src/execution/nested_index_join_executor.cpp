@@ -12,14 +12,89 @@
 
 #include "execution/executors/nested_index_join_executor.h"
 
+#include "execution/expressions/column_value_expression.h"
+
 namespace bustub {
 
 NestIndexJoinExecutor::NestIndexJoinExecutor(ExecutorContext *exec_ctx, const NestedIndexJoinPlanNode *plan,
                                              std::unique_ptr<AbstractExecutor> &&child_executor)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx), plan_(plan), child_executor_(std::move(child_executor)) {}
+
+void NestIndexJoinExecutor::Init() {
+  child_executor_->Init();
+  inner_table_info_ = exec_ctx_->GetCatalog()->GetTable(plan_->GetInnerTableOid());
+  index_info_ = exec_ctx_->GetCatalog()->GetIndex(plan_->GetIndexName(), inner_table_info_->name_);
+  results_.clear();
+  next_pos_ = 0;
+}
+
+bool NestIndexJoinExecutor::Next(Tuple *tuple, RID *rid) {
+  while (next_pos_ >= results_.size()) {
+    if (!JoinNextBatch()) {
+      return false;
+    }
+  }
+  *tuple = results_[next_pos_++];
+  return true;
+}
+
+bool NestIndexJoinExecutor::JoinNextBatch() {
+  results_.clear();
+  next_pos_ = 0;
+  const Schema *outer_schema = plan_->OuterTableSchema();
+  const Schema *inner_schema = plan_->InnerTableSchema();
+  const AbstractExpression *outer_key = OuterKeyExpression();
+
+  std::vector<Tuple> outer_tuples;
+  std::vector<Tuple> keys;
+  Tuple outer_tuple;
+  RID outer_rid;
+  while (outer_tuples.size() < static_cast<size_t>(INDEX_BATCH_SIZE) &&
+         child_executor_->Next(&outer_tuple, &outer_rid)) {
+    keys.emplace_back(std::vector<Value>{outer_key->Evaluate(&outer_tuple, outer_schema)},
+                      index_info_->index_->GetKeySchema());
+    outer_tuples.push_back(outer_tuple);
+  }
+  if (outer_tuples.empty()) {
+    return false;
+  }
 
-void NestIndexJoinExecutor::Init() {}
+  std::vector<std::vector<RID>> inner_rids;
+  if (!index_info_->index_->ScanKeys(keys, &inner_rids, exec_ctx_->GetTransaction())) {
+    // the batch stopped partway, look the keys up one at a time instead
+    inner_rids.assign(keys.size(), std::vector<RID>());
+    for (size_t i = 0; i < keys.size(); i++) {
+      index_info_->index_->ScanKey(keys[i], &inner_rids[i], exec_ctx_->GetTransaction());
+    }
+  }
+  Tuple inner_tuple;
+  for (size_t i = 0; i < outer_tuples.size(); i++) {
+    for (const RID &inner_rid : inner_rids[i]) {
+      if (!inner_table_info_->table_->GetTuple(inner_rid, &inner_tuple, exec_ctx_->GetTransaction())) {
+        continue;
+      }
+      if (!plan_->Predicate()->EvaluateJoin(&outer_tuples[i], outer_schema, &inner_tuple, inner_schema).GetAs<bool>()) {
+        continue;
+      }
+      std::vector<Value> values;
+      values.reserve(plan_->OutputSchema()->GetColumnCount());
+      for (const auto &column : plan_->OutputSchema()->GetColumns()) {
+        values.push_back(column.GetExpr()->EvaluateJoin(&outer_tuples[i], outer_schema, &inner_tuple, inner_schema));
+      }
+      results_.emplace_back(values, plan_->OutputSchema());
+    }
+  }
+  return true;
+}
 
-bool NestIndexJoinExecutor::Next(Tuple *tuple, RID *rid) { return false; }
+const AbstractExpression *NestIndexJoinExecutor::OuterKeyExpression() const {
+  for (const AbstractExpression *child : plan_->Predicate()->GetChildren()) {
+    auto column = dynamic_cast<const ColumnValueExpression *>(child);
+    if (column != nullptr && column->GetTupleIdx() == 0) {
+      return child;
+    }
+  }
+  return plan_->Predicate()->GetChildAt(0);
+}
 
 }  // namespace bustub
@@ -15,14 +15,19 @@
 #include <list>
 #include <mutex>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
 #include "buffer/lru_replacer.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
+class BufferRing;
+class PageSegment;
+
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
  */
@@ -84,6 +89,107 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Fetch a page for a bulk read. A page that is not resident is read into a frame of the ring rather than one taken
+   * from the replacer, and it does not enter the replacer when unpinned. Unpin it with UnpinPage() as usual.
+   * @param page_id id of page to be fetched
+   * @param ring the access strategy of the calling scan
+   * @return the requested page, or nullptr if no frame was available
+   */
+  Page *FetchPageInRing(page_id_t page_id, BufferRing *ring) { return FetchPgInRingImp(page_id, ring); }
+
+  /**
+   * Create a new page that belongs to segment, i.e. whose id comes from the current extent of the segment.
+   * @param[out] page_id id of created page
+   * @param segment the table heap or index the page is created for
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPageInSegment(page_id_t *page_id, PageSegment *segment) { return NewPgInSegmentImp(page_id, segment); }
+
+  /**
+   * Ask for a page to be read into the buffer pool in the background. The page is not pinned and the call never
+   * blocks on I/O; the request is only a hint and may be dropped.
+   * @param page_id id of page to be prefetched
+   * @return true if the page is already resident, false if a read was requested (or dropped)
+   */
+  bool PrefetchPage(page_id_t page_id) { return PrefetchPgImp(page_id); }
+
+  /**
+   * List the resident pages for a later WarmUp(), e.g. after a restart. Pinned pages come first, then the others in
+   * the order the replacer would keep them.
+   * @return the page ids, hottest first
+   */
+  std::vector<page_id_t> GetResidentPages() { return GetResidentPgsImp(); }
+
+  /**
+   * Read pages into free frames before the buffer pool is used, starting with the first ones of page_ids until the
+   * free frames run out. The reads are sorted and merged where the pages are adjacent. The pages are left unpinned.
+   * @param page_ids pages to read, as returned by GetResidentPages()
+   * @return the number of pages read
+   */
+  size_t WarmUp(const std::vector<page_id_t> &page_ids) { return WarmUpImp(page_ids); }
+
+  /**
+   * Grow or shrink the buffer pool while it is in use. Growing adds free frames. Shrinking takes free frames first,
+   * then evicts unpinned pages in the replacer's victim order, and gives the memory of those frames back to the OS.
+   * @param pool_size the new size of the buffer pool
+   * @return false if pool_size is beyond what the pool was set up for, or if too many pages are pinned to shrink that
+   * far; the pool is as close to pool_size as it could get then
+   */
+  bool Resize(size_t pool_size) { return ResizeImp(pool_size); }
+
+  /**
+   * Fetch a page, with a guard that unpins it when it goes out of scope.
+   * @param page_id id of page to be fetched
+   * @return the guard, empty if no frame was available
+   */
+  BasicPageGuard FetchPageBasic(page_id_t page_id) { return {this, FetchPgImp(page_id)}; }
+
+  /**
+   * Fetch and read-latch a page, with a guard that unlatches and unpins it when it goes out of scope.
+   * @param page_id id of page to be fetched
+   * @return the guard, empty if no frame was available
+   */
+  ReadPageGuard FetchPageRead(page_id_t page_id) {
+    Page *page = FetchPgImp(page_id);
+    if (page != nullptr) {
+      page->RLatch();
+    }
+    return {this, page};
+  }
+
+  /**
+   * Fetch and write-latch a page, with a guard that unlatches and unpins it when it goes out of scope.
+   * @param page_id id of page to be fetched
+   * @return the guard, empty if no frame was available
+   */
+  WritePageGuard FetchPageWrite(page_id_t page_id) {
+    Page *page = FetchPgImp(page_id);
+    if (page != nullptr) {
+      page->WLatch();
+    }
+    return {this, page};
+  }
+
+  /**
+   * Create a new page, with a guard that unpins it when it goes out of scope. The page is marked dirty on release.
+   * @param[out] page_id id of created page
+   * @return the guard, empty if no new pages could be created
+   */
+  BasicPageGuard NewPageGuarded(page_id_t *page_id) {
+    BasicPageGuard guard(this, NewPgImp(page_id));
+    guard.SetDirty();
+    return guard;
+  }
+
+  /**
+   * Drop a pin of a page the caller has at hand, as page guards do. Unlike UnpinPage() this does not look up the page
+   * id, the pin keeps the page in its frame.
+   * @param page a page pinned by the caller
+   * @param is_dirty true if the page should be marked as dirty
+   */
+  void ReleasePage(Page *page, bool is_dirty) { ReleasePgImp(page, is_dirty); }
+
   /** @return size of the buffer pool */
   virtual size_t GetPoolSize() = 0;
 
@@ -108,6 +214,14 @@ class BufferPoolManager {
    */
   virtual Page *FetchPgImp(page_id_t page_id) = 0;
 
+  /**
+   * Fetch the requested page, recycling the frames of ring on a miss.
+   * @param page_id id of page to be fetched
+   * @param ring the access strategy of the caller
+   * @return the requested page
+   */
+  virtual Page *FetchPgInRingImp(page_id_t page_id, BufferRing *ring) = 0;
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -116,6 +230,13 @@ class BufferPoolManager {
    */
   virtual bool UnpinPgImp(page_id_t page_id, bool is_dirty) = 0;
 
+  /**
+   * Unpin a page pinned by the caller.
+   * @param page the pinned page
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   */
+  virtual void ReleasePgImp(Page *page, bool is_dirty) = 0;
+
   /**
    * Flushes the target page to disk.
    * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
@@ -130,6 +251,14 @@ class BufferPoolManager {
    */
   virtual Page *NewPgImp(page_id_t *page_id) = 0;
 
+  /**
+   * Creates a new page in the buffer pool, allocated from segment.
+   * @param[out] page_id id of created page
+   * @param segment the segment to allocate the page from
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  virtual Page *NewPgInSegmentImp(page_id_t *page_id, PageSegment *segment) = 0;
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -141,5 +270,32 @@ class BufferPoolManager {
    * Flushes all the pages in the buffer pool to disk.
    */
   virtual void FlushAllPgsImp() = 0;
+
+  /**
+   * Schedules a background read of the target page.
+   * @param page_id id of page to be prefetched
+   * @return true if the page is already resident, false otherwise
+   */
+  virtual bool PrefetchPgImp(page_id_t page_id) = 0;
+
+  /**
+   * List the resident pages, hottest first.
+   * @return the page ids
+   */
+  virtual std::vector<page_id_t> GetResidentPgsImp() = 0;
+
+  /**
+   * Read pages into free frames, the first ones of page_ids first.
+   * @param page_ids pages to read
+   * @return the number of pages read
+   */
+  virtual size_t WarmUpImp(const std::vector<page_id_t> &page_ids) = 0;
+
+  /**
+   * Grow or shrink the buffer pool.
+   * @param pool_size the new size of the buffer pool
+   * @return true if the buffer pool has the new size
+   */
+  virtual bool ResizeImp(size_t pool_size) = 0;
 };
 }  // namespace bustub
@@ -12,14 +12,29 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <climits>
+#include <condition_variable>  // NOLINT
+#include <deque>
 #include <list>
 #include <mutex>  // NOLINT
-#include <unordered_map>
+#include <thread>  // NOLINT
+#include <unordered_set>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_stats.h"
+#include "buffer/buffer_ring.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/frame_arena.h"
+#include "buffer/lru_k_replacer.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/page_table.h"
+#include "buffer/two_q_replacer.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/page_segment.h"
 #include "storage/page/page.h"
 
 namespace bustub {
@@ -28,14 +43,18 @@ namespace bustub {
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
  */
 class BufferPoolManagerInstance : public BufferPoolManager {
+  friend class BufferRing;
+
  public:
   /**
    * Creates a new BufferPoolManagerInstance.
    * @param pool_size the size of the buffer pool
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy
    */
-  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
+  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::CLOCK);
   /**
    * Creates a new BufferPoolManagerInstance.
    * @param pool_size the size of the buffer pool
@@ -43,9 +62,11 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param instance_index index of this BPI in the parallel BPM
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy
    */
   BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                            DiskManager *disk_manager, LogManager *log_manager = nullptr);
+                            DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::CLOCK);
 
   /**
    * Destroys an existing BufferPoolManagerInstance.
@@ -55,9 +76,59 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** @return size of the buffer pool */
   size_t GetPoolSize() override { return pool_size_; }
 
+  /** @return the size the buffer pool can grow to, BUFFER_POOL_MAX_GROWTH times its initial size */
+  size_t GetMaxPoolSize() const { return max_pool_size_; }
+
   /** @return pointer to all the pages in the buffer pool */
   Page *GetPages() { return pages_; }
 
+  /** @return the number of dirty victims FetchPage/NewPage had to write back themselves */
+  uint64_t GetForegroundWrites() const { return counters_.Get(BufferPoolCounters::FOREGROUND_WRITES); }
+
+  /** @return the number of dirty pages written back by the background writer */
+  uint64_t GetBackgroundWrites() const { return counters_.Get(BufferPoolCounters::BACKGROUND_WRITES); }
+
+  /**
+   * Take a snapshot of the counters of this instance. The counters are cheap to keep up and always on; the snapshot
+   * scans the frames for the pin-count histogram.
+   * @return the counters
+   */
+  BufferPoolStats GetStats() const;
+
+  /**
+   * Create a new page with an id that was already allocated, e.g. by a ParallelBufferPoolManager from a segment.
+   * @param page_id id of the page, allocated on disk and mapping to this instance
+   * @return nullptr if every frame is pinned, otherwise pointer to the new page
+   */
+  Page *NewPageWithId(page_id_t page_id);
+
+  /**
+   * First half of FlushAllPages(): pin every dirty page and mark it clean, so that it can be written back without the
+   * latch. A page modified meanwhile is dirtied again. Finish with UnpinFlushedPages() once the writes are done.
+   * @param[out] dirty_pages the pinned pages
+   */
+  void PinDirtyPages(std::vector<Page *> *dirty_pages);
+
+  /**
+   * Second half of FlushAllPages(): unpin the pages returned by PinDirtyPages().
+   * @param dirty_pages the pages to unpin
+   */
+  void UnpinFlushedPages(const std::vector<Page *> &dirty_pages);
+
+  /**
+   * First half of WarmUp(): map the first pages of page_ids that belong to this instance and are not resident to free
+   * frames, as long as there are any, and pin them. Read them, then finish with FinishWarmUp().
+   * @param page_ids pages to read, hottest first
+   * @param[out] loading_pages the pinned pages, in the order of page_ids
+   */
+  void StartWarmUp(const std::vector<page_id_t> &page_ids, std::vector<Page *> *loading_pages);
+
+  /**
+   * Second half of WarmUp(): unpin the pages returned by StartWarmUp() once they have been read, the hottest last.
+   * @param loading_pages the pages to unpin
+   */
+  void FinishWarmUp(const std::vector<Page *> &loading_pages);
+
  protected:
   /**
    * Fetch the requested page from the buffer pool.
@@ -66,6 +137,14 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   Page *FetchPgImp(page_id_t page_id) override;
 
+  /**
+   * Fetch the requested page, recycling the frames of ring on a miss.
+   * @param page_id id of page to be fetched
+   * @param ring the access strategy of the caller
+   * @return the requested page
+   */
+  Page *FetchPgInRingImp(page_id_t page_id, BufferRing *ring) override;
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -74,6 +153,13 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   bool UnpinPgImp(page_id_t page_id, bool is_dirty) override;
 
+  /**
+   * Unpin a page pinned by the caller.
+   * @param page the pinned page
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   */
+  void ReleasePgImp(Page *page, bool is_dirty) override;
+
   /**
    * Flushes the target page to disk.
    * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
@@ -88,6 +174,14 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   Page *NewPgImp(page_id_t *page_id) override;
 
+  /**
+   * Creates a new page in the buffer pool, allocated from segment.
+   * @param[out] page_id id of created page
+   * @param segment the segment to allocate the page from
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPgInSegmentImp(page_id_t *page_id, PageSegment *segment) override;
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -101,18 +195,43 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   void FlushAllPgsImp() override;
 
   /**
-   * Allocate a page on disk.∂
+   * Schedules a background read of the target page.
+   * @param page_id id of page to be prefetched
+   * @return true if the page is already resident, false otherwise
+   */
+  bool PrefetchPgImp(page_id_t page_id) override;
+
+  /**
+   * List the resident pages, hottest first.
+   * @return the page ids
+   */
+  std::vector<page_id_t> GetResidentPgsImp() override;
+
+  /**
+   * Read pages into free frames, the first ones of page_ids first.
+   * @param page_ids pages to read
+   * @return the number of pages read
+   */
+  size_t WarmUpImp(const std::vector<page_id_t> &page_ids) override;
+
+  /**
+   * Grow or shrink the buffer pool.
+   * @param pool_size the new number of frames, at most GetMaxPoolSize()
+   * @return false if pool_size is out of range, or if not enough unpinned frames could be evicted
+   */
+  bool ResizeImp(size_t pool_size) override;
+
+  /**
+   * Allocate a page on disk, reusing a deallocated page of this instance if there is one.
    * @return the id of the allocated page
    */
   page_id_t AllocatePage();
 
   /**
-   * Deallocate a page on disk.
+   * Deallocate a page on disk. Its id may be returned by a later AllocatePage().
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  void DeallocatePage(page_id_t page_id) { disk_manager_->DeallocatePage(page_id); }
 
   /**
    * Validate that the page_id being used is accessible to this BPI. This can be used in all of the functions to
@@ -121,40 +240,220 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   void ValidatePageId(page_id_t page_id) const;
 
-  /** Number of pages in the buffer pool. */
-  const size_t pool_size_;
+  /** Number of frames in use. Changed under latch_ by Resize(). */
+  std::atomic<size_t> pool_size_;
+  /** Number of frames the instance is set up for; frames beyond pool_size_ are kept in retired_frames_. */
+  const size_t max_pool_size_;
   /** How many instances are in the parallel BPM (if present, otherwise just 1 BPI) */
   const uint32_t num_instances_ = 1;
   /** Index of this BPI in the parallel BPM (if present, otherwise just 0) */
   const uint32_t instance_index_ = 0;
-  /** Each BPI maintains its own counter for page_ids to hand out, must ensure they mod back to its instance_index_ */
-  std::atomic<page_id_t> next_page_id_ = instance_index_;
 
-  /** Array of buffer pool pages. */
+  /** I/O state of a frame. Disk reads and writes are issued without holding latch_. */
+  enum class FrameIOState : uint8_t {
+    /** No I/O in flight, the frame content is valid. */
+    IDLE,
+    /** The page is being read from disk; fetchers of the same page wait on io_cv_. */
+    LOADING,
+    /** A dirty victim is being written back; it may still be pinned (its content stays valid). */
+    EVICTING,
+    /** The background writer is writing the page back. It stays evictable; an evictor waits for the write. */
+    FLUSHING
+  };
+
+  /** Who a frame's page was read in for. */
+  enum class FrameOwner : uint8_t {
+    /** A regular page, evictable through the replacer. */
+    POOL,
+    /** Read in by a prefetch and not fetched since; a bulk read that fetches it moves it into its ring. */
+    PREFETCH,
+    /** Part of a BufferRing: it is never handed to the replacer and only the ring recycles it. */
+    RING
+  };
+
+  /** Page-aligned data of all frames, kept apart from the Page metadata. */
+  FrameArena frame_arena_;
+  /** Array of buffer pool pages, each pointing at its frame in frame_arena_. */
   Page *pages_;
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
   /** Pointer to the log manager. */
   LogManager *log_manager_ __attribute__((__unused__));
-  /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
+  /** Page table for keeping track of buffer pool pages. Lookups are lock-free, updates happen under latch_. */
+  PageTable page_table_;
   /** Replacer to find unpinned pages for replacement. */
   Replacer *replacer_;
   /** List of free pages. */
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  /** Frames not in use since the pool shrank or never used yet, locked and without memory. Accessed under latch_. */
+  std::vector<frame_id_t> retired_frames_;
+  /** Per-frame I/O state, indexed by frame id. Written under latch_, read by the lock-free hit path. */
+  std::vector<std::atomic<FrameIOState>> frame_io_state_;
+  /** Per-frame owner, indexed by frame id. Written under latch_, read by the lock-free unpin path. */
+  std::vector<std::atomic<FrameOwner>> frame_owner_;
+  /**
+   * Serializes page table updates, free_list_, frame_io_state_ and every change of a frame's page_id_. It is never
+   * held across disk I/O, and page hits and unpins do not take it at all: they only touch the frame's atomic pin count.
+   */
   std::mutex latch_;
+  /** Signalled (together with latch_) whenever a frame goes back to FrameIOState::IDLE. */
+  std::condition_variable io_cv_;
 
-private:
   /**
-   * @return  Is there a free page in buffer
+   * Protects prefetch_queue_, prefetch_pending_, prefetch_threads_ and stop_prefetch_. Never held together with
+   * latch_.
    */
-  bool FindFreePage(frame_id_t *frame_id);
+  std::mutex prefetch_latch_;
+  /** Signalled when a prefetch is queued or the instance shuts down. */
+  std::condition_variable prefetch_cv_;
+  /** Page ids waiting to be prefetched, at most PREFETCH_QUEUE_SIZE. */
+  std::deque<page_id_t> prefetch_queue_;
+  /** Page ids that are queued or being read by a prefetch thread, so that each is requested once. */
+  std::unordered_set<page_id_t> prefetch_pending_;
+  /** Background readers, started by the first prefetch request. */
+  std::vector<std::thread> prefetch_threads_;
+  bool stop_prefetch_{false};
+
+  /** Protects stop_flush_. Never held together with latch_. */
+  std::mutex flush_latch_;
+  /** Wakes the background writer early, or for shutdown. */
+  std::condition_variable flush_cv_;
+  /** Background writer, running only if enable_background_flush was set at construction. */
+  std::thread flush_thread_;
+  bool stop_flush_{false};
+  /** Frame the background writer looks at first in its next round. Accessed under latch_. */
+  size_t flush_hand_{0};
+  /** Event counters for GetStats(). */
+  BufferPoolCounters counters_;
+
+ private:
+  /**
+   * Take a frame for a new page, from the free list first and then from the replacer. A dirty victim is written
+   * back with latch_ released, so lock is dropped and re-acquired in that case.
+   * @param lock the held lock on latch_
+   * @param[out] frame_id the frame that was reserved; it is not in the page table and not in the replacer
+   * @return false if every frame is pinned
+   */
+  bool FindFreePage(std::unique_lock<std::mutex> *lock, frame_id_t *frame_id);
+
+  /**
+   * Make an unpinned victim frame reusable: write it back if dirty (dropping lock meanwhile), lock it and remove its
+   * page from the page table.
+   * @param lock the held lock on latch_
+   * @param frame_id the victim
+   * @return false if the frame got pinned or is busy with I/O, in which case it is left alone
+   */
+  bool EvictFrame(std::unique_lock<std::mutex> *lock, frame_id_t frame_id);
+
+  /**
+   * Take a frame for a page read by a bulk read: the next frame of the ring once it is full, otherwise a frame from
+   * FindFreePage(). latch_ must be held through lock.
+   */
+  bool FindRingFrame(std::unique_lock<std::mutex> *lock, BufferRing *ring, frame_id_t *frame_id);
+
+  /** @return this instance's part of ring, set up on first use. latch_ must be held. */
+  BufferRing::InstanceRing *GetInstanceRing(BufferRing *ring);
+
+  /** Record that frame_id now holds page_id for ring, giving up the oldest ring frame if it is full. */
+  void AddRingSlot(BufferRing *ring, frame_id_t frame_id, page_id_t page_id);
+
   /**
-   * @return  page_id is in page_table_? turn it to frame_id 
-   * 
+   * Take a frame out of a ring: a clean unpinned frame is dropped to the free list, any other one becomes a regular
+   * frame. Does nothing if the frame was reassigned since. latch_ must be held.
    */
-  bool FindPagetoFrame(page_id_t page_id, frame_id_t *frame_id);  
+  void ReleaseRingSlot(const BufferRing::Slot &slot);
+
+  /** Release every frame of this instance's part of a ring that is being destroyed. */
+  void ReleaseRing(BufferRing::InstanceRing *instance_ring);
+
+  /**
+   * A pinned frame read in by a prefetch is now being used: it joins ring if there is one, otherwise it becomes a
+   * regular frame. latch_ must be held.
+   */
+  void ClaimPrefetchedFrame(BufferRing *ring, page_id_t page_id, frame_id_t frame_id);
+
+  /** Take a free, locked frame out of use and release its memory. latch_ must be held. */
+  void RetireFrame(frame_id_t frame_id);
+
+  /** Hand a frame whose pin count dropped to zero to the replacer, unless a ring owns it. */
+  void MakeEvictable(frame_id_t frame_id);
+
+  /**
+   * @return  page_id is in page_table_? turn it to frame_id
+   */
+  bool FindPagetoFrame(page_id_t page_id, frame_id_t *frame_id);
+
+  /** @return a lock on latch_; the time spent waiting for it is counted */
+  std::unique_lock<std::mutex> LockLatch();
+
+  /** Re-acquire latch_ through lock after it was released, counting the time spent waiting. */
+  void RelockLatch(std::unique_lock<std::mutex> *lock);
+
+  /** Block on io_cv_ until frame_id has no I/O in flight. latch_ must be held through lock. */
+  void WaitForIO(std::unique_lock<std::mutex> *lock, frame_id_t frame_id);
+
+  /**
+   * Map page_id to the reserved frame frame_id and read it from disk. latch_ is released during the read and held
+   * again on return. Fetchers of the same page wait for the read on io_cv_.
+   * @param lock the held lock on latch_
+   * @param page_id the page to read, it must not be in the page table
+   * @param frame_id a frame returned by FindFreePage(); it is pinned once on return
+   */
+  void LoadPage(std::unique_lock<std::mutex> *lock, page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * Map page_id to the reserved frame frame_id, pin it once and mark it LOADING. The caller reads the page and sets
+   * the frame IDLE again. Caller holds latch_.
+   */
+  void StartLoad(page_id_t page_id, frame_id_t frame_id);
+
+  /** Map page_id to the reserved frame frame_id as a new, zeroed and pinned page. Caller holds latch_. */
+  Page *InitNewPage(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * Drop whatever copy of the just allocated page_id is still resident from before it was deallocated, e.g. one read
+   * in by a prefetch that raced the deletion. Waits for its I/O and its pins; latch_ is released meanwhile and held
+   * again on return.
+   */
+  void DropStaleCopy(std::unique_lock<std::mutex> *lock, page_id_t page_id);
+
+  /** Unmap the locked frame frame_id and put it on the free list with its content dropped. Caller holds latch_. */
+  void FreeFrame(frame_id_t frame_id);
+
+  /**
+   * Body of a prefetch thread: read all queued pages that are still allocated into the pool with their reads in
+   * flight together, and leave them unpinned.
+   */
+  void PrefetchWorker();
+
+  /** Body of the background writer thread: run FlushDirtyFrames() every background_flush_interval. */
+  void FlushWorker();
+
+  /**
+   * One round of the background writer. If fewer than BACKGROUND_FLUSH_CLEAN_PERCENT of the frames are free or
+   * clean and unpinned, write back up to BACKGROUND_FLUSH_MAX_PAGES dirty unpinned frames so that victims are clean.
+   */
+  void FlushDirtyFrames();
+
+  /** Pin a resident frame while latch_ is held, removing it from the replacer. */
+  void PinFrame(frame_id_t frame_id);
+
+  /**
+   * Lock-free hit path: pin frame_id if it still holds page_id and is not being loaded.
+   * @return false if the frame was locked or reassigned, in which case the caller must take the slow path
+   */
+  bool TryPinResident(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * Try to lock an unpinned frame for reassignment by swapping its pin count from 0 to FRAME_LOCKED. latch_ must
+   * be held. A locked frame cannot be pinned by the lock-free hit path.
+   */
+  bool TryLockFrame(frame_id_t frame_id);
+
+  /** Pin count of a frame that is free or being reassigned under latch_. */
+  static constexpr int FRAME_LOCKED = INT_MIN / 2;
 
+  /** Drop a pin taken with PinFrame while latch_ is held, handing the frame back to the replacer at zero. */
+  void UnpinFrame(frame_id_t frame_id);
 };
 }  // namespace bustub
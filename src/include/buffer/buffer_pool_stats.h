@@ -0,0 +1,148 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.h
+//
+// Identification: src/include/buffer/buffer_pool_stats.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/** Number of buckets of the pin-count histogram: 0, 1, 2-3, 4-7, 8-15 and 16 or more pins. */
+static constexpr size_t PIN_COUNT_BUCKETS = 6;
+
+/**
+ * A snapshot of the counters of a buffer pool. The counters only ever grow, so the activity over an interval is the
+ * difference of two snapshots.
+ */
+struct BufferPoolStats {
+  /** Fetches of a page that was resident. */
+  uint64_t fetch_hits_{0};
+  /** Fetches that had to read the page from disk. */
+  uint64_t fetch_misses_{0};
+  /** Pages created by NewPage(). */
+  uint64_t new_pages_{0};
+  /** Pages removed from a frame to make room for another one. */
+  uint64_t evictions_{0};
+  /** Dirty victims that FetchPage/NewPage had to write back themselves. */
+  uint64_t foreground_writes_{0};
+  /** Dirty pages written back by the background writer. */
+  uint64_t background_writes_{0};
+  /** Times a frame was needed and the free list was empty, so that the replacer had to pick a victim. */
+  uint64_t free_list_empty_{0};
+  /** Times a thread found latch_ held and had to wait for it. */
+  uint64_t latch_waits_{0};
+  /** Total time spent waiting for latch_, in nanoseconds. */
+  uint64_t latch_wait_ns_{0};
+  /** Resident pages by pin count at the time of the snapshot, see PIN_COUNT_BUCKETS. */
+  std::array<uint64_t, PIN_COUNT_BUCKETS> pin_count_histogram_{};
+
+  /** @return the fraction of fetches that were hits, 0 if there were none */
+  double HitRatio() const {
+    uint64_t fetches = fetch_hits_ + fetch_misses_;
+    return fetches == 0 ? 0 : static_cast<double>(fetch_hits_) / static_cast<double>(fetches);
+  }
+
+  /** @return the histogram bucket of a page pinned pin_count times */
+  static size_t PinCountBucket(int pin_count) {
+    size_t bucket = 0;
+    while (pin_count > 0 && bucket < PIN_COUNT_BUCKETS - 1) {
+      pin_count >>= 1;
+      bucket++;
+    }
+    return bucket;
+  }
+
+  BufferPoolStats &operator+=(const BufferPoolStats &other) {
+    fetch_hits_ += other.fetch_hits_;
+    fetch_misses_ += other.fetch_misses_;
+    new_pages_ += other.new_pages_;
+    evictions_ += other.evictions_;
+    foreground_writes_ += other.foreground_writes_;
+    background_writes_ += other.background_writes_;
+    free_list_empty_ += other.free_list_empty_;
+    latch_waits_ += other.latch_waits_;
+    latch_wait_ns_ += other.latch_wait_ns_;
+    for (size_t i = 0; i < PIN_COUNT_BUCKETS; i++) {
+      pin_count_histogram_[i] += other.pin_count_histogram_[i];
+    }
+    return *this;
+  }
+};
+
+/**
+ * The event counters behind BufferPoolStats. Each counter is striped over cache-line sized shards and a thread always
+ * adds to the same shard, so threads hitting the pool at the same time do not contend on a counter. Reading a counter
+ * sums the shards.
+ */
+class BufferPoolCounters {
+ public:
+  enum Counter : size_t {
+    FETCH_HITS,
+    FETCH_MISSES,
+    NEW_PAGES,
+    EVICTIONS,
+    FOREGROUND_WRITES,
+    BACKGROUND_WRITES,
+    FREE_LIST_EMPTY,
+    LATCH_WAITS,
+    LATCH_WAIT_NS,
+    NUM_COUNTERS
+  };
+
+  /** Add n to a counter. */
+  void Add(Counter counter, uint64_t n = 1) {
+    shards_[ShardIndex()].counters_[counter].fetch_add(n, std::memory_order_relaxed);
+  }
+
+  /** @return the current value of a counter */
+  uint64_t Get(Counter counter) const {
+    uint64_t sum = 0;
+    for (const auto &shard : shards_) {
+      sum += shard.counters_[counter].load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+  /** Fill in the counters of stats; the pin-count histogram is left alone. */
+  void Snapshot(BufferPoolStats *stats) const {
+    stats->fetch_hits_ = Get(FETCH_HITS);
+    stats->fetch_misses_ = Get(FETCH_MISSES);
+    stats->new_pages_ = Get(NEW_PAGES);
+    stats->evictions_ = Get(EVICTIONS);
+    stats->foreground_writes_ = Get(FOREGROUND_WRITES);
+    stats->background_writes_ = Get(BACKGROUND_WRITES);
+    stats->free_list_empty_ = Get(FREE_LIST_EMPTY);
+    stats->latch_waits_ = Get(LATCH_WAITS);
+    stats->latch_wait_ns_ = Get(LATCH_WAIT_NS);
+  }
+
+ private:
+  static constexpr size_t NUM_SHARDS = 16;
+
+  struct alignas(64) Shard {
+    std::array<std::atomic<uint64_t>, NUM_COUNTERS> counters_{};
+  };
+
+  /** Threads are assigned shards round-robin on first use. */
+  static size_t ShardIndex() {
+    static std::atomic<size_t> next_shard{0};
+    thread_local size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % NUM_SHARDS;
+    return shard;
+  }
+
+  std::array<Shard, NUM_SHARDS> shards_{};
+};
+
+}  // namespace bustub
@@ -0,0 +1,81 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_ring.h
+//
+// Identification: src/include/buffer/buffer_ring.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+class BufferPoolManagerInstance;
+
+/**
+ * BufferRing is the access strategy of a bulk read, e.g. a sequential scan over a table larger than the buffer pool.
+ *
+ * Pages fetched through BufferPoolManager::FetchPageInRing() that miss in the pool are read into a small private ring
+ * of frames that the scan keeps recycling, instead of frames handed out by the replacer. Ring frames never enter the
+ * replacer, so the scan cannot push the rest of the working set out of the pool. Pages the scan finds resident are
+ * used in place. When the ring is destroyed, its clean unpinned frames go back to the free list and the others are
+ * handed to the replacer.
+ *
+ * A ring must be destroyed before the buffer pool it was used with. It is meant for a single scan and is not
+ * thread-safe, except that different buffer pool instances may use their parts of it concurrently.
+ */
+class BufferRing {
+ public:
+  /**
+   * Creates a new BufferRing.
+   * @param size number of frames in the ring, split between the instances of a parallel buffer pool
+   */
+  explicit BufferRing(size_t size = BUFFER_RING_SIZE) : size_(size) {}
+
+  /**
+   * Destroys the BufferRing, handing its frames back to their buffer pool instances.
+   */
+  ~BufferRing();
+
+  DISALLOW_COPY_AND_MOVE(BufferRing);
+
+ private:
+  friend class BufferPoolManagerInstance;
+
+  struct Slot {
+    frame_id_t frame_id_;
+    /** The page read into frame_id_ for the ring; the frame no longer belongs to the ring if it holds another. */
+    page_id_t page_id_;
+  };
+
+  /** The frames of one buffer pool instance. Only accessed under the latch of that instance. */
+  struct InstanceRing {
+    BufferPoolManagerInstance *bpm_{nullptr};
+    size_t capacity_{0};
+    /** Slot to recycle next once the ring is full. */
+    size_t next_{0};
+    std::vector<Slot> slots_;
+  };
+
+  /**
+   * @return the part of the ring that belongs to instance_index, with bpm_ still nullptr if it was never used
+   */
+  InstanceRing *GetInstanceRing(uint32_t instance_index, uint32_t num_instances);
+
+  const size_t size_;
+  /** Protects instance_rings_ while it is sized on first use. */
+  std::mutex latch_;
+  std::vector<InstanceRing> instance_rings_;
+};
+
+}  // namespace bustub
@@ -12,8 +12,7 @@
 
 #pragma once
 
-#include <list>
-#include <mutex>  // NOLINT
+#include <atomic>
 #include <vector>
 
 #include "buffer/replacer.h"
@@ -23,6 +22,10 @@ namespace bustub {
 
 /**
  * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used policy.
+ *
+ * Every frame has one byte of atomic state holding an evictable bit and a reference bit, so Pin() and Unpin() are a
+ * single atomic read-modify-write each. Victim() advances a shared atomic hand; concurrent victim searches take
+ * different slots off the hand and race with Pin() through compare-and-swap, so no lock is taken anywhere.
  */
 class ClockReplacer : public Replacer {
  public:
@@ -45,8 +48,16 @@ class ClockReplacer : public Replacer {
 
   size_t Size() override;
 
+  void GetRetentionOrder(std::vector<frame_id_t> *frame_ids) override;
+
  private:
-  // TODO(student): implement me!
+  /** Set while the frame is in the replacer, i.e. unpinned. */
+  static constexpr uint8_t EVICTABLE = 1;
+  /** Set when the frame is unpinned, cleared when the hand passes over it. */
+  static constexpr uint8_t REFERENCED = 2;
+
+  std::vector<std::atomic<uint8_t>> frames_;
+  std::atomic<size_t> hand_{0};
 };
 
 }  // namespace bustub
@@ -0,0 +1,67 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FrameArena holds the data of all frames of a buffer pool instance in one contiguous, zeroed mapping, separate from
+ * the Page metadata. Frames are PAGE_SIZE apart and the arena is aligned to the OS page size, so frame data can be the
+ * target of O_DIRECT I/O.
+ *
+ * With huge pages requested, the arena is mapped from the huge page pool if one is reserved and otherwise left to
+ * transparent huge pages.
+ *
+ * Memory is only committed for frames that are touched, so an arena can be mapped for more frames than are in use.
+ */
+class FrameArena {
+ public:
+  /**
+   * Map a new arena.
+   * @param num_frames number of PAGE_SIZE frames
+   * @param huge_pages try to back the arena with huge pages
+   */
+  FrameArena(size_t num_frames, bool huge_pages);
+
+  /**
+   * Unmap the arena.
+   */
+  ~FrameArena();
+
+  DISALLOW_COPY_AND_MOVE(FrameArena);
+
+  /** @return the data of frame frame_id */
+  char *GetFrame(frame_id_t frame_id) const { return data_ + static_cast<size_t>(frame_id) * PAGE_SIZE; }
+
+  /**
+   * Give the memory of frames back to the OS. They read as zeros when used again.
+   * @param frame_id the first frame
+   * @param num_frames number of consecutive frames
+   */
+  void Release(frame_id_t frame_id, size_t num_frames);
+
+  /** @return true if the arena is backed by the huge page pool */
+  bool IsHugeTLB() const { return huge_tlb_; }
+
+ private:
+  char *data_;
+  size_t size_;
+  bool huge_tlb_{false};
+};
+
+}  // namespace bustub
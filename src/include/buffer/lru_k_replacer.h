@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.h
+//
+// Identification: src/include/buffer/lru_k_replacer.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy (O'Neil, O'Neil and Weikum, 1993).
+ *
+ * The victim is the evictable frame whose K-th most recent reference is the oldest, i.e. the one with the largest
+ * backward K-distance. Frames with fewer than K references have an infinite distance and are evicted first, oldest
+ * first reference first, which is what keeps a one-pass scan from pushing out pages that are used repeatedly.
+ *
+ * Every Pin() is a reference. References that arrive within the correlated reference period of the previous one
+ * (measured in references to the replacer) are folded into it, so a page that is fetched many times in a row, e.g.
+ * once per tuple by a table iterator, still counts as referenced once. History is kept per frame and dropped when the
+ * frame is victimized.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of references to look back
+   * @param correlated_reference_period references closer than this to the previous one are considered correlated
+   */
+  LRUKReplacer(size_t num_pages, size_t k, size_t correlated_reference_period);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+  void GetRetentionOrder(std::vector<frame_id_t> *frame_ids) override;
+
+ private:
+  struct FrameHistory {
+    /** Timestamps of the last (up to) K uncorrelated references, most recent first. */
+    std::vector<uint64_t> history_;
+    /** Timestamp of the most recent reference, correlated or not. */
+    uint64_t last_{0};
+    bool evictable_{false};
+  };
+
+  /** Record a reference to frame_id at the next timestamp. */
+  void RecordAccess(FrameHistory *frame);
+
+  std::mutex mutex_;
+  const size_t k_;
+  const uint64_t correlated_reference_period_;
+  uint64_t current_timestamp_{0};
+  size_t num_evictable_{0};
+  std::vector<FrameHistory> frames_;
+};
+
+}  // namespace bustub
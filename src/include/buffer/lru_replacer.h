@@ -46,6 +46,8 @@ class LRUReplacer : public Replacer {
 
   size_t Size() override;
 
+  void GetRetentionOrder(std::vector<frame_id_t> *frame_ids) override;
+
  private:
   // TODO(student): implement me!
   std::mutex mutex_;
@@ -0,0 +1,97 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.h
+//
+// Identification: src/include/buffer/page_table.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * PageTable maps page ids to frame ids for a buffer pool instance.
+ *
+ * It is an open-addressing (linear probing) table with a fixed capacity of at least twice the number of frames, so
+ * it never needs to grow. Every slot is a single 64-bit atomic word holding both the page id and the frame id, which
+ * lets Find() run without any lock.
+ *
+ * Insert() and Erase() must be serialized by the caller (the buffer pool holds its latch). Erase() uses backward-shift
+ * deletion instead of tombstones, which means a concurrent Find() can miss an entry that is being moved, and can
+ * return a mapping that has just been removed. Callers must therefore treat a lock-free Find() as a hint: validate
+ * a hit against the frame itself and fall back to a locked lookup on a miss.
+ */
+class PageTable {
+ public:
+  /**
+   * Create a new PageTable.
+   * @param num_frames the maximum number of mappings the table will be required to store
+   */
+  explicit PageTable(size_t num_frames);
+
+  ~PageTable() = default;
+
+  DISALLOW_COPY_AND_MOVE(PageTable);
+
+  /**
+   * Look up the frame holding a page. Safe to call concurrently with Insert() and Erase().
+   * @param page_id the page to look up
+   * @param[out] frame_id the frame that holds the page
+   * @return true if a mapping was found
+   */
+  bool Find(page_id_t page_id, frame_id_t *frame_id) const;
+
+  /**
+   * Add a mapping. The page must not be present. Callers must serialize writers.
+   * @param page_id the page id
+   * @param frame_id the frame that holds the page
+   */
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * Remove a mapping. Callers must serialize writers.
+   * @param page_id the page id
+   * @return true if the page was present
+   */
+  bool Erase(page_id_t page_id);
+
+  /** @return the number of slots in the table */
+  size_t Capacity() const { return mask_ + 1; }
+
+ private:
+  static constexpr uint64_t EMPTY_SLOT = ~static_cast<uint64_t>(0);
+
+  static uint64_t Pack(page_id_t page_id, frame_id_t frame_id) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32 | static_cast<uint32_t>(frame_id);
+  }
+  static page_id_t KeyOf(uint64_t slot) { return static_cast<page_id_t>(slot >> 32); }
+  static frame_id_t ValueOf(uint64_t slot) { return static_cast<frame_id_t>(slot & 0xFFFFFFFF); }
+
+  /**
+   * Page ids handed out by one instance of a parallel buffer pool are all congruent modulo the number of instances,
+   * so the low bits are useless on their own; Fibonacci hashing spreads them over the whole table.
+   */
+  size_t HomeSlot(page_id_t page_id) const {
+    return (static_cast<uint32_t>(page_id) * 0x9E3779B9U) >> (32 - shift_bits_);
+  }
+
+  /** log2 of the capacity */
+  uint32_t shift_bits_;
+  /** capacity - 1 */
+  size_t mask_;
+  std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+};
+
+}  // namespace bustub
@@ -28,9 +28,10 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    * @param pool_size the pool size of each BufferPoolManagerInstance
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the replacement policy of every instance
    */
   ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
-                            LogManager *log_manager = nullptr);
+                            LogManager *log_manager = nullptr, ReplacerType replacer_type = ReplacerType::CLOCK);
 
   /**
    * Destroys an existing ParallelBufferPoolManager.
@@ -40,6 +41,15 @@ class ParallelBufferPoolManager : public BufferPoolManager {
   /** @return size of the buffer pool */
   size_t GetPoolSize() override;
 
+  /** @return the number of dirty victims written back inline, summed over all instances */
+  uint64_t GetForegroundWrites() const;
+
+  /** @return the number of dirty pages written back by the background writers of all instances */
+  uint64_t GetBackgroundWrites() const;
+
+  /** @return a snapshot of the counters of all instances, summed up */
+  BufferPoolStats GetStats() const;
+
  protected:
   /**
    * @param page_id id of page
@@ -54,6 +64,14 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    */
   Page *FetchPgImp(page_id_t page_id) override;
 
+  /**
+   * Fetch the requested page, recycling the frames of ring on a miss.
+   * @param page_id id of page to be fetched
+   * @param ring the access strategy of the caller
+   * @return the requested page
+   */
+  Page *FetchPgInRingImp(page_id_t page_id, BufferRing *ring) override;
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -62,6 +80,13 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    */
   bool UnpinPgImp(page_id_t page_id, bool is_dirty) override;
 
+  /**
+   * Unpin a page pinned by the caller.
+   * @param page the pinned page
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   */
+  void ReleasePgImp(Page *page, bool is_dirty) override;
+
   /**
    * Flushes the target page to disk.
    * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
@@ -76,6 +101,14 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    */
   Page *NewPgImp(page_id_t *page_id) override;
 
+  /**
+   * Creates a new page in the buffer pool, allocated from segment.
+   * @param[out] page_id id of created page
+   * @param segment the segment to allocate the page from
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPgInSegmentImp(page_id_t *page_id, PageSegment *segment) override;
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -87,11 +120,39 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    * Flushes all the pages in the buffer pool to disk.
    */
   void FlushAllPgsImp() override;
-  
+
+  /**
+   * Schedules a background read of the target page.
+   * @param page_id id of page to be prefetched
+   * @return true if the page is already resident, false otherwise
+   */
+  bool PrefetchPgImp(page_id_t page_id) override;
+
+  /**
+   * List the resident pages, hottest first.
+   * @return the page ids
+   */
+  std::vector<page_id_t> GetResidentPgsImp() override;
+
+  /**
+   * Read pages into free frames, the first ones of page_ids first.
+   * @param page_ids pages to read
+   * @return the number of pages read
+   */
+  size_t WarmUpImp(const std::vector<page_id_t> &page_ids) override;
+
+  /**
+   * Grow or shrink every instance by the same amount. The number of instances stays the same, since page ids are
+   * routed to instances (and allocated on disk) by their residue modulo num_instances_.
+   * @param pool_size the new size of all instances together
+   * @return true if every instance has its new size
+   */
+  bool ResizeImp(size_t pool_size) override;
+
   //std::mutex latch_;
   /** How many instances are in the parallel BPM (if present, otherwise just 1 BPI) */
   const uint32_t num_instances_;
-  /** Number of pages in the buffer pool. */
+  /** Number of pages in each instance at construction. */
   const size_t pool_size_;
   std::atomic<size_t> start_index_;
   /** Array of BPM*/
@@ -12,10 +12,24 @@
 
 #pragma once
 
+#include <vector>
+
 #include "common/config.h"
 
 namespace bustub {
 
+/** Replacement policies a buffer pool instance can be constructed with. */
+enum class ReplacerType {
+  /** ClockReplacer */
+  CLOCK,
+  /** LRUReplacer */
+  LRU,
+  /** LRUKReplacer with LRUK_REPLACER_K and CORRELATED_REFERENCE_PERIOD */
+  LRU_K,
+  /** TwoQReplacer with TWO_Q_A1_PERCENT of the pool as probation queue */
+  TWO_Q
+};
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -45,6 +59,19 @@ class Replacer {
 
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
+
+  /**
+   * List the frames that can be victimized, from the one the policy would keep longest to the next victim.
+   * @param[out] frame_ids the frames in that order
+   */
+  virtual void GetRetentionOrder(std::vector<frame_id_t> *frame_ids) = 0;
+
+  /**
+   * Tell the replacer how many frames the buffer pool uses, when it is created and whenever it is resized. Policies
+   * that size part of their state after the pool override this.
+   * @param pool_size the number of frames in use
+   */
+  virtual void SetPoolSize(size_t pool_size) {}
 };
 
 }  // namespace bustub
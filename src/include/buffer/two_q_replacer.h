@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_q_replacer.h
+//
+// Identification: src/include/buffer/two_q_replacer.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * TwoQReplacer implements the 2Q replacement policy (Johnson and Shasha, 1994).
+ *
+ * Frames enter a FIFO probation queue (A1) on their first reference and are only promoted to the main LRU queue (Am)
+ * when they are referenced again after their correlated reference period has passed. Victims are taken from A1
+ * while it holds more than its target share of the pool, so a scan cycles through A1 and leaves Am alone.
+ *
+ * The replacer only sees frame ids, which are reused for different pages, so it cannot keep the A1out queue of
+ * evicted page ids from the paper. A1in's job of absorbing correlated references is done by the correlated reference
+ * period instead: repeated fetches of a page in quick succession do not promote it.
+ */
+class TwoQReplacer : public Replacer {
+ public:
+  /**
+   * Create a new TwoQReplacer.
+   * @param num_pages the maximum number of pages the TwoQReplacer will be required to store
+   * @param a1_percent target share of the pool in the probation queue, in percent; the pool is num_pages frames
+   * until SetPoolSize() says otherwise
+   * @param correlated_reference_period re-references closer than this to the previous one do not promote a frame
+   */
+  TwoQReplacer(size_t num_pages, size_t a1_percent, size_t correlated_reference_period);
+
+  /**
+   * Destroys the TwoQReplacer.
+   */
+  ~TwoQReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+  void GetRetentionOrder(std::vector<frame_id_t> *frame_ids) override;
+
+  void SetPoolSize(size_t pool_size) override;
+
+ private:
+  enum class Queue : uint8_t { NONE, A1, AM };
+
+  struct FrameState {
+    Queue queue_{Queue::NONE};
+    bool evictable_{false};
+    /** Timestamp of the most recent reference. */
+    uint64_t last_{0};
+    /** Position in a1_list_ or am_list_, valid while evictable_. */
+    std::list<frame_id_t>::iterator pos_;
+  };
+
+  /** Drop frame_id from the evictable list of its queue. */
+  void RemoveEvictable(FrameState *frame);
+
+  std::mutex mutex_;
+  const size_t a1_percent_;
+  /** Target number of frames in A1, a1_percent_ of the pool. */
+  size_t a1_size_;
+  const uint64_t correlated_reference_period_;
+  uint64_t current_timestamp_{0};
+  /** Number of frames in A1, pinned or not. */
+  size_t a1_count_{0};
+  /** Evictable frames of A1 in FIFO order, newest at the front. */
+  std::list<frame_id_t> a1_list_;
+  /** Evictable frames of Am in LRU order, most recently unpinned at the front. */
+  std::list<frame_id_t> am_list_;
+  std::vector<FrameState> frames_;
+};
+
+}  // namespace bustub
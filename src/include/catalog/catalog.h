@@ -217,12 +217,18 @@ class Catalog {
     auto index = std::make_unique<ExtendibleHashTableIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_,
                                                                                                hash_function);
 
-    // Populate the index with all tuples in table heap
+    // Populate the index with all tuples in table heap. The keys are collected first, so that the index pages can be
+    // built bottom-up instead of splitting their way up one insert at a time
     auto *table_meta = GetTable(table_name);
     auto *heap = table_meta->table_.get();
+    std::vector<KeyType> keys;
+    std::vector<RID> rids;
     for (auto tuple = heap->Begin(txn); tuple != heap->End(); ++tuple) {
-      index->InsertEntry(tuple->KeyFromTuple(schema, key_schema, key_attrs), tuple->GetRid(), txn);
+      keys.emplace_back();
+      keys.back().SetFromKey(tuple->KeyFromTuple(schema, key_schema, key_attrs));
+      rids.push_back(tuple->GetRid());
     }
+    index->BulkLoad(keys, rids, txn);
 
     // Get the next OID for the new index
     const auto index_oid = next_index_oid_.fetch_add(1);
@@ -17,22 +17,30 @@
 #include "concurrency/lock_manager.h"
 #include "recovery/checkpoint_manager.h"
 #include "recovery/log_manager.h"
+#include "storage/disk/disk_backend.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
 
 class BustubInstance {
  public:
-  explicit BustubInstance(const std::string &db_file_name) {
+  /**
+   * @param db_file_name the database file, also used to name the log file
+   * @param backend where the pages are kept, e.g. in memory to measure CPU cost apart from I/O
+   */
+  explicit BustubInstance(const std::string &db_file_name, DiskBackend backend = DefaultDiskBackend()) {
     enable_logging = false;
 
     // storage related
-    disk_manager_ = new DiskManager(db_file_name);
+    disk_manager_ = CreateDiskManager(db_file_name, backend).release();
 
     // log related
     log_manager_ = new LogManager(disk_manager_);
 
     buffer_pool_manager_ = new BufferPoolManagerInstance(BUFFER_POOL_SIZE, disk_manager_, log_manager_);
+    if (enable_buffer_pool_warmup) {
+      buffer_pool_manager_->WarmUp(disk_manager_->ReadResidentPages());
+    }
 
     // txn related
     lock_manager_ = new LockManager();
@@ -46,6 +54,9 @@ class BustubInstance {
     if (enable_logging) {
       log_manager_->StopFlushThread();
     }
+    if (enable_buffer_pool_warmup) {
+      disk_manager_->WriteResidentPages(buffer_pool_manager_->GetResidentPages());
+    }
     delete checkpoint_manager_;
     delete log_manager_;
     delete buffer_pool_manager_;
@@ -27,6 +27,21 @@ extern std::atomic<bool> enable_logging;
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/** True if buffer pool instances should run a background writer for dirty pages. Read at construction. */
+extern std::atomic<bool> enable_background_flush;
+
+/** The background writer runs a round every BACKGROUND_FLUSH_INTERVAL, or earlier when a victim had to be written. */
+extern std::chrono::milliseconds background_flush_interval;
+
+/** True if disk managers should open their db file with O_DIRECT, bypassing the OS page cache. */
+extern std::atomic<bool> enable_direct_io;
+
+/** True if buffer pool instances should try to back their frames with huge pages. */
+extern std::atomic<bool> enable_huge_page_frames;
+
+/** True if a BustubInstance should save its resident pages on shutdown and read them back on startup. */
+extern std::atomic<bool> enable_buffer_pool_warmup;
+
 static constexpr int INVALID_PAGE_ID = -1;                                    // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                     // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                        // invalid log sequence number
@@ -35,6 +50,21 @@ static constexpr int PAGE_SIZE = 4096;                                        //
 static constexpr int BUFFER_POOL_SIZE = 10;                                   // size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                        // size of extendible hash bucket
+static constexpr int LRUK_REPLACER_K = 2;                                     // lookback window of the lru-k replacer
+static constexpr int CORRELATED_REFERENCE_PERIOD = 8;                         // lru-k/2Q correlated reference window
+static constexpr int TWO_Q_A1_PERCENT = 25;                                   // 2Q probation queue share of the pool
+static constexpr int PREFETCH_THREADS = 2;                                    // prefetch I/O threads per pool instance
+static constexpr int PREFETCH_QUEUE_SIZE = 32;                                // pending prefetches per pool instance
+static constexpr int TABLE_READAHEAD_PAGES = 4;                               // pages a table scan reads ahead
+static constexpr int BACKGROUND_FLUSH_CLEAN_PERCENT = 10;                     // bg writer keeps this % of frames clean
+static constexpr int BACKGROUND_FLUSH_MAX_PAGES = 16;                         // bg writer pages per round (rate limit)
+static constexpr int BUFFER_RING_SIZE = 16;                                   // frames recycled by a bulk read
+static constexpr int BUFFER_RING_THRESHOLD_PERCENT = 25;                      // scans of larger tables use a ring
+static constexpr int IO_URING_QUEUE_DEPTH = 64;                               // async disk requests in flight per file
+static constexpr int EXTENT_SIZE = 64;                                        // contiguous pages per table/index extent
+static constexpr int IO_COALESCE_MAX_PAGES = 64;                              // adjacent pages merged into one I/O
+static constexpr int BUFFER_POOL_MAX_GROWTH = 4;                              // a pool can grow to this x initial size
+static constexpr int INDEX_BATCH_SIZE = 256;                                  // index entries per batched insert/probe
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
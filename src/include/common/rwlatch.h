@@ -12,25 +12,27 @@
 
 #pragma once
 
-#include <climits>
-#include <condition_variable>  // NOLINT
-#include <mutex>               // NOLINT
+#include <atomic>
+#include <cstdint>
 
 #include "common/macros.h"
 
 namespace bustub {
 
 /**
- * Reader-Writer latch backed by std::mutex.
+ * Reader-Writer latch on a single atomic word. An uncontended RLock() or WLock() is one compare-and-swap, and the
+ * matching unlock one atomic subtraction. Threads that have to wait spin briefly, then sleep on a futex. Writers are
+ * preferred: once a writer waits, new readers wait behind it.
+ *
+ * The latch also keeps a version that is odd while a writer holds the latch and advances with every write latch, so
+ * that readers can skip the latch altogether: read the version, read the protected data, and accept what was read only
+ * if the version is still the same. Such optimistic reads must tolerate torn data (e.g. check bounds before following
+ * an offset they read) since a writer may be in the middle of an update.
  */
 class ReaderWriterLatch {
-  using mutex_t = std::mutex;
-  using cond_t = std::condition_variable;
-  static const uint32_t MAX_READERS = UINT_MAX;
-
  public:
   ReaderWriterLatch() = default;
-  ~ReaderWriterLatch() { std::lock_guard<mutex_t> guard(mutex_); }
+  ~ReaderWriterLatch() = default;
 
   DISALLOW_COPY(ReaderWriterLatch);
 
@@ -38,59 +40,102 @@ class ReaderWriterLatch {
    * Acquire a write latch.
    */
   void WLock() {
-    std::unique_lock<mutex_t> latch(mutex_);
-    while (writer_entered_) {
-      reader_.wait(latch);
-    }
-    writer_entered_ = true;
-    while (reader_count_ > 0) {
-      writer_.wait(latch);
+    uint32_t state = 0;
+    if (!state_.compare_exchange_weak(state, WRITE_LOCKED, std::memory_order_acquire, std::memory_order_relaxed)) {
+      WLockContended();
     }
+    version_.fetch_add(1, std::memory_order_relaxed);
+    // the odd version must be visible before any of the writer's stores
+    std::atomic_thread_fence(std::memory_order_release);
   }
 
   /**
    * Release a write latch.
    */
   void WUnlock() {
-    std::lock_guard<mutex_t> guard(mutex_);
-    writer_entered_ = false;
-    reader_.notify_all();
+    version_.fetch_add(1, std::memory_order_release);
+    uint32_t state = state_.fetch_sub(WRITE_LOCKED, std::memory_order_release) - WRITE_LOCKED;
+    if ((state & (READERS_WAITING | WRITERS_WAITING)) != 0) {
+      WakeWriterOrReaders(state);
+    }
   }
 
   /**
    * Acquire a read latch.
    */
   void RLock() {
-    std::unique_lock<mutex_t> latch(mutex_);
-    while (writer_entered_ || reader_count_ == MAX_READERS) {
-      reader_.wait(latch);
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    if (!IsReadLockable(state) ||
+        !state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+      RLockContended();
     }
-    reader_count_++;
   }
 
   /**
    * Release a read latch.
    */
   void RUnlock() {
-    std::lock_guard<mutex_t> guard(mutex_);
-    reader_count_--;
-    if (writer_entered_) {
-      if (reader_count_ == 0) {
-        writer_.notify_one();
-      }
-    } else {
-      if (reader_count_ == MAX_READERS - 1) {
-        reader_.notify_one();
-      }
+    uint32_t state = state_.fetch_sub(1, std::memory_order_release) - 1;
+    // readers only wait on a read-latched latch behind a waiting writer, so the last reader wakes that writer
+    if ((state & MASK) == 0 && (state & WRITERS_WAITING) != 0) {
+      WakeWriterOrReaders(state);
     }
   }
 
+  /**
+   * Start an optimistic read, without taking the latch.
+   * @param[out] version the version to pass to Validate() once done reading
+   * @return false if a writer holds the latch; the caller should retry later or take the read latch
+   */
+  bool TryOptimisticRead(uint64_t *version) const {
+    *version = version_.load(std::memory_order_acquire);
+    return (*version & 1) == 0;
+  }
+
+  /**
+   * Finish an optimistic read.
+   * @param version the version TryOptimisticRead() returned
+   * @return true if no writer latched in the meantime, i.e. everything read since is consistent
+   */
+  bool Validate(uint64_t version) const {
+    // the reads of the protected data must not move past the check
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
  private:
-  mutex_t mutex_;
-  cond_t writer_;
-  cond_t reader_;
-  uint32_t reader_count_{0};
-  bool writer_entered_{false};
+  /** The low 30 bits of state_ count the readers, or are all set while a writer holds the latch. */
+  static constexpr uint32_t MASK = (1U << 30) - 1;
+  static constexpr uint32_t WRITE_LOCKED = MASK;
+  static constexpr uint32_t MAX_READERS = MASK - 1;
+  /** Some reader sleeps on state_. */
+  static constexpr uint32_t READERS_WAITING = 1U << 30;
+  /** Some writer sleeps on writer_notify_. */
+  static constexpr uint32_t WRITERS_WAITING = 1U << 31;
+
+  static bool IsReadLockable(uint32_t state) {
+    return (state & MASK) < MAX_READERS && (state & (READERS_WAITING | WRITERS_WAITING)) == 0;
+  }
+
+  /** Spin for a while on state_ until it satisfies pred. @return the last state seen */
+  template <typename Pred>
+  uint32_t SpinUntil(Pred pred) const;
+
+  void RLockContended();
+
+  void WLockContended();
+
+  /** Called by the thread that just left the latch unlocked with waiters in state. */
+  void WakeWriterOrReaders(uint32_t state);
+
+  /** @return true if a writer was woken up */
+  bool WakeWriter();
+
+  std::atomic<uint32_t> state_{0};
+  /** Writers sleep on this counter, which every wake-up of a writer bumps. */
+  std::atomic<uint32_t> writer_notify_{0};
+  /** Twice the number of write latches taken so far, plus one while a writer holds the latch. */
+  std::atomic<uint64_t> version_{0};
 };
 
 }  // namespace bustub
@@ -14,11 +14,13 @@
 
 #include <queue>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/transaction.h"
 #include "container/hash/hash_function.h"
+#include "storage/disk/page_segment.h"
 #include "storage/page/hash_table_bucket_page.h"
 #include "storage/page/hash_table_directory_page.h"
 
@@ -30,6 +32,15 @@ namespace bustub {
  * Implementation of extendible hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
  * table grows/shrinks dynamically as buckets become full/empty.
+ *
+ * A directory page maps the low DIRECTORY_MAX_DEPTH bits of a hash to buckets. Once a directory page is full, it is
+ * split in two by a higher hash bit, and a header page maps these higher bits to directory pages; the header is
+ * itself laid out as a HashTableDirectoryPage. A lookup visits the header, one directory and one bucket.
+ *
+ * The two halves of a split directory share their buckets: a bucket is split by a header bit only once it overflows,
+ * and its header depth in the directories records by how many. The header and a directory each map 9 hash bits, so
+ * the table holds at most 2^18 buckets; with 237 pairs per bucket for GenericKey<8> and 55 for GenericKey<64>, that
+ * is about 62M and 14M keys at best, and fewer for a skewed hash. Beyond that, Insert returns false.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class ExtendibleHashTable {
@@ -74,6 +85,45 @@ class ExtendibleHashTable {
    */
   bool GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result);
 
+  /**
+   * Inserts a batch of key-value pairs. The keys are hashed up front and grouped by bucket, so that each bucket is
+   * pinned and latched once for all of its keys, while the next buckets are prefetched. The pairs whose bucket is
+   * full are inserted one at a time afterwards, splitting buckets as needed.
+   *
+   * @param transaction the current transaction
+   * @param keys the keys to insert
+   * @param values the values to insert, values[i] with keys[i]
+   * @param[out] complete if not null, set to false when a bucket could not be fetched; the pairs of the buckets past it
+   * are not inserted then
+   * @return the number of pairs inserted; duplicates are not
+   */
+  size_t InsertBatch(Transaction *transaction, const std::vector<KeyType> &keys, const std::vector<ValueType> &values,
+                     bool *complete = nullptr);
+
+  /**
+   * Fills an empty table with key-value pairs bottom-up, e.g. to build an index over an existing table. The hashes are
+   * counted first to pick the smallest depth at which every bucket fits, the pairs are radix-partitioned by that many
+   * low hash bits, and each bucket page is then written once with its whole partition, so that no bucket is ever split.
+   * If the table is not empty, this falls back to InsertBatch.
+   *
+   * @param transaction the current transaction
+   * @param keys the keys to insert
+   * @param values the values to insert, values[i] with keys[i]
+   * @return the number of pairs inserted; duplicates are not
+   */
+  size_t BulkLoad(Transaction *transaction, const std::vector<KeyType> &keys, const std::vector<ValueType> &values);
+
+  /**
+   * Performs a point query for each of a batch of keys, grouping them by bucket like InsertBatch.
+   *
+   * @param transaction the current transaction
+   * @param keys the keys to look up
+   * @param[out] results results->at(i) receives the value(s) associated with keys[i]
+   * @return false if a bucket could not be fetched; the results of the keys past it are left empty
+   */
+  bool GetValueBatch(Transaction *transaction, const std::vector<KeyType> &keys,
+                     std::vector<std::vector<ValueType>> *results);
+
   /**
    * Returns the global depth.  Do not touch.
    */
@@ -116,17 +166,45 @@ class ExtendibleHashTable {
    * Get the bucket page_id corresponding to a key.
    *
    * @param key the key for lookup
-   * @param dir_page a pointer to the hash table's directory page
+   * @param dir_page a pointer to the directory page of the key
    * @return the bucket page_id corresponding to the input key
    */
   inline page_id_t KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page);
 
   /**
-   * Fetches the directory page from the buffer pool manager.
+   * Map a key to a header index, using the hash bits above the ones directory pages use.
+   *
+   * @param key the key to use for lookup
+   * @param header_page the hash table's header page
+   * @return the header index
+   */
+  inline uint32_t KeyToHeaderIndex(KeyType key, HashTableDirectoryPage *header_page);
+
+  /**
+   * Get the directory page_id corresponding to a key.
+   *
+   * @param key the key for lookup
+   * @param header_page the hash table's header page
+   * @return the directory page_id corresponding to the input key
+   */
+  inline page_id_t KeyToDirectoryPageId(KeyType key, HashTableDirectoryPage *header_page);
+
+  /**
+   * Fetches the header page from the buffer pool manager.
+   *
+   * @return a pointer to the header page
+   */
+  HashTableDirectoryPage *FetchHeaderPage();
+
+  /**
+   * Fetches the directory page of a key from the buffer pool manager. The header page is only pinned meanwhile, so
+   * the caller must hold table_latch_ for the result to stay the key's directory.
    *
+   * @param key the key for lookup
+   * @param[out] directory_page_id the page_id of the directory page
    * @return a pointer to the directory page
    */
-  HashTableDirectoryPage *FetchDirectoryPage();
+  HashTableDirectoryPage *FetchDirectoryPage(KeyType key, page_id_t *directory_page_id);
 
   /**
    * Fetches the a bucket page from the buffer pool manager using the bucket's page_id.
@@ -137,23 +215,102 @@ class ExtendibleHashTable {
   HASH_TABLE_BUCKET_TYPE *FetchBucketPage(page_id_t bucket_page_id);
 
   /**
-   * Performs insertion with an optional bucket splitting.
+   * Maps every key of a batch to its bucket and orders the batch by bucket. The caller holds table_latch_.
+   *
+   * @param keys the batch
+   * @return (bucket page_id, index in keys) pairs, sorted by bucket page_id
+   */
+  std::vector<std::pair<page_id_t, uint32_t>> GroupByBucket(const std::vector<KeyType> &keys);
+
+  /**
+   * Calls visit(bucket, begin, end) once per bucket of a batch ordered by GroupByBucket, with the bucket pinned and
+   * [begin, end) the range of order that maps to it. The disk reads of the buckets further down the batch are
+   * requested ahead, and the next bucket is pulled into the CPU cache while visit runs.
+   *
+   * @param order the batch, as returned by GroupByBucket
+   * @param visit returns true if it dirtied the bucket
+   * @return false if a bucket could not be fetched; the buckets before it were visited, the rest are not
+   */
+  template <typename Visitor>
+  bool ForEachBucket(const std::vector<std::pair<page_id_t, uint32_t>> &order, Visitor visit);
+
+  /**
+   * Splits the full bucket that key maps to, growing the directory if needed. Takes table_latch_ in write mode; the
+   * caller must not hold it, and retries the insertion afterwards.
    *
    * @param transaction a pointer to the current transaction
    * @param key the key to insert
    * @param value the value to insert
-   * @return whether or not the insertion was successful
+   * @return false if the table cannot grow any further
    */
   bool SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value);
 
+  /**
+   * Splits a full bucket in two, by the next local bit, or by the next header bit once the directory uses all of its
+   * bits. Every directory sharing the bucket is updated; the caller holds table_latch_ in write mode.
+   *
+   * @param header_page the header page
+   * @param header_idx the header index of the key that overflowed
+   * @param bucket_id the directory index of the bucket
+   * @param bucket_page_id the bucket to split
+   * @param local_depth the bucket's local depth
+   * @param header_depth the bucket's header depth
+   * @param by_header_bit whether to split by the next header bit instead of the next local bit
+   * @return false if a page could not be allocated or fetched; the table is left as it was
+   */
+  bool SplitBucket(HashTableDirectoryPage *header_page, uint32_t header_idx, uint32_t bucket_id,
+                   page_id_t bucket_page_id, uint32_t local_depth, uint32_t header_depth, bool by_header_bit);
+
+  /**
+   * Lists the directories that share the buckets with the given header depth of the directory at header_idx.
+   *
+   * @param header_page the header page
+   * @param header_idx a header index pointing at the directory
+   * @param header_depth the header depth of the buckets
+   * @return the page id of each directory, with the first header index pointing at it
+   */
+  std::vector<std::pair<page_id_t, uint32_t>> SharingDirectories(HashTableDirectoryPage *header_page,
+                                                                 uint32_t header_idx, uint32_t header_depth);
+
+  /**
+   * Applies update to each directory under its write latch. If a directory cannot be fetched, undo is applied to the
+   * ones already updated.
+   *
+   * @param directories the directories, as returned by SharingDirectories
+   * @param update called with each directory page and its first header index
+   * @param undo reverts update
+   * @return false if a directory could not be fetched
+   */
+  template <typename Update, typename Undo>
+  bool UpdateDirectories(const std::vector<std::pair<page_id_t, uint32_t>> &directories, Update update, Undo undo);
+
+  /**
+   * Doubles a directory (or the header) that has room for it, the new upper half mirroring the lower one.
+   *
+   * @param dir_page the page to grow
+   */
+  void GrowDirectory(HashTableDirectoryPage *dir_page);
+
+  /**
+   * Splits a full directory page in two by the next hash bit the header does not use yet, growing the header if
+   * needed. The new directory shares all the buckets of the full one. The caller holds table_latch_ in write mode.
+   *
+   * @param header the header page
+   * @param header_idx a header index pointing at the directory
+   * @param dir_page the directory to split
+   * @return false if the header is already at its maximum size, or the new directory could not be allocated
+   */
+  bool SplitDirectory(Page *header, uint32_t header_idx, HashTableDirectoryPage *dir_page);
+
   /**
    * Optionally merges an empty bucket into it's pair.  This is called by Remove,
-   * if Remove makes a bucket empty.
+   * if Remove makes a bucket empty. Takes table_latch_ in write mode; the caller must not hold it.
    *
    * There are three conditions under which we skip the merge:
    * 1. The bucket is no longer empty.
    * 2. The bucket has local depth 0.
    * 3. The bucket's local depth doesn't match its split image's local depth.
+   * 4. Either bucket was split by a header bit, it is then not shared by all directories.
    *
    * @param transaction a pointer to the current transaction
    * @param key the key that was removed
@@ -162,13 +319,16 @@ class ExtendibleHashTable {
   void Merge(Transaction *transaction, const KeyType &key, const ValueType &value);
 
   // member variables
-  page_id_t directory_page_id_;
+  page_id_t header_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
 
-  // Readers includes inserts and removes, writers are splits and merges
+  // Readers includes inserts and removes, which also write-latch their bucket page; writers are splits and merges.
+  // Lookups do not take it, see GetValue().
   ReaderWriterLatch table_latch_;
   HashFunction<KeyType> hash_fn_;
+  // directory and bucket pages are allocated from the table's own extents
+  PageSegment segment_;
 };
 
 }  // namespace bustub
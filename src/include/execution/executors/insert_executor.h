@@ -14,6 +14,7 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
@@ -57,6 +58,9 @@ class InsertExecutor : public AbstractExecutor {
   const Schema *GetOutputSchema() override { return plan_->OutputSchema(); };
 
  private:
+  /** Insert the buffered index entries of the tuples inserted so far. */
+  void FlushIndexEntries();
+
   /** The insert plan node to be executed*/
   const InsertPlanNode *plan_;
   size_t insert_next_{0};
@@ -64,6 +68,9 @@ class InsertExecutor : public AbstractExecutor {
   std::unique_ptr<AbstractExecutor> child_executor_;
   TableInfo* table_info_;
   std::vector<IndexInfo*> table_indexs_;
+  /** Index keys not inserted yet, one batch per index, and the RIDs of their tuples. */
+  std::vector<std::vector<Tuple>> index_keys_;
+  std::vector<RID> index_rids_;
 };
 
 }  // namespace bustub
@@ -28,7 +28,9 @@
 namespace bustub {
 
 /**
- * IndexJoinExecutor executes index join operations.
+ * IndexJoinExecutor executes index join operations. The outer tuples are pulled a batch at a time and the index is
+ * probed for the whole batch at once. The probe key of an outer tuple is the side of the join predicate that reads
+ * the outer tuple, so the index key has a single column.
  */
 class NestIndexJoinExecutor : public AbstractExecutor {
  public:
@@ -48,7 +50,23 @@ class NestIndexJoinExecutor : public AbstractExecutor {
   bool Next(Tuple *tuple, RID *rid) override;
 
  private:
+  /**
+   * Join the next batch of outer tuples.
+   * @return false if the outer table is exhausted
+   */
+  bool JoinNextBatch();
+
+  /** @return the side of the join predicate that is evaluated on the outer tuple */
+  const AbstractExpression *OuterKeyExpression() const;
+
   /** The nested index join plan node. */
   const NestedIndexJoinPlanNode *plan_;
+  /** The child executor producing the outer tuples. */
+  std::unique_ptr<AbstractExecutor> child_executor_;
+  TableInfo *inner_table_info_{nullptr};
+  IndexInfo *index_info_{nullptr};
+  /** The joined tuples of the current batch, and the next one to return. */
+  std::vector<Tuple> results_;
+  size_t next_pos_{0};
 };
 }  // namespace bustub
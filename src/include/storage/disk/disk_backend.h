@@ -0,0 +1,48 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_backend.h
+//
+// Identification: src/include/storage/disk/disk_backend.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * Where a database keeps its pages.
+ * FILE: the db file. MEMORY: a MemoryDiskManager, no I/O at all.
+ * HDD, SATA_SSD, NVME: in memory behind a LatencyDiskManager with the timing of that device.
+ */
+enum class DiskBackend { FILE, MEMORY, HDD, SATA_SSD, NVME };
+
+/**
+ * Create a disk manager of the given backend.
+ * @param db_file the file name of the database file, only used by the FILE backend
+ * @param backend the backend to create
+ */
+std::unique_ptr<DiskManager> CreateDiskManager(const std::string &db_file, DiskBackend backend);
+
+/**
+ * @return the backend named by the BUSTUB_DISK_BACKEND environment variable (file, memory, hdd, sata_ssd or nvme),
+ * FILE if it is not set
+ */
+DiskBackend DefaultDiskBackend();
+
+/**
+ * Create a disk manager of the default backend, e.g. for a test that does not depend on where its pages are kept.
+ * @param db_file the file name of the database file, only used by the FILE backend
+ */
+std::unique_ptr<DiskManager> CreateDiskManager(const std::string &db_file);
+
+}  // namespace bustub
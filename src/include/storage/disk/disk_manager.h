@@ -12,11 +12,9 @@
 
 #pragma once
 
-#include <atomic>
-#include <fstream>
 #include <future>  // NOLINT
-#include <mutex>   // NOLINT
-#include <string>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 
@@ -25,24 +23,24 @@ namespace bustub {
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * This is the interface of the storage backends: FileDiskManager keeps the pages in the db file, MemoryDiskManager in
+ * memory, and LatencyDiskManager adds the timing of a storage device to another backend. The synchronous and batched
+ * page methods are built on the asynchronous ones. See CreateDiskManager() to pick a backend.
  */
 class DiskManager {
  public:
-  /**
-   * Creates a new disk manager that writes to the specified database file.
-   * @param db_file the file name of the database file to write to
-   */
-  explicit DiskManager(const std::string &db_file);
+  DiskManager() = default;
 
-  ~DiskManager() = default;
+  virtual ~DiskManager() = default;
 
   /**
-   * Shut down the disk manager and close all the file resources.
+   * Shut down the disk manager and close all the file resources. Requests in flight complete first.
    */
-  void ShutDown();
+  virtual void ShutDown() = 0;
 
   /**
-   * Write a page to the database file.
+   * Write a page to the database file. Page writes are not synced, see SyncDB().
    * @param page_id id of the page
    * @param page_data raw page data
    */
@@ -55,12 +53,69 @@ class DiskManager {
    */
   void ReadPage(page_id_t page_id, char *page_data);
 
+  /**
+   * Start writing a page to the database file. page_data must stay valid until the returned future is ready. With
+   * O_DIRECT, PAGE_SIZE aligned buffers (such as buffer pool frames) avoid an extra copy.
+   * @param page_id id of the page
+   * @param page_data raw page data
+   * @return a future that becomes ready when the write has completed
+   */
+  virtual std::future<void> WritePageAsync(page_id_t page_id, const char *page_data) = 0;
+
+  /**
+   * Start writing consecutive pages to the database file with a single vectored write. The pages must be adjacent in
+   * the file, see IsAdjacent().
+   * @param first_page_id id of the first page
+   * @param pages raw data of each page, which must stay valid until the returned future is ready
+   * @return a future that becomes ready when all pages have been written
+   */
+  virtual std::future<void> WritePagesAsync(page_id_t first_page_id, const std::vector<const char *> &pages) = 0;
+
+  /**
+   * Write a batch of pages, e.g. on a checkpoint. Runs of adjacent pages are merged into vectored writes, which are all
+   * in flight together. Returns when every page has been written; the writes are not synced.
+   * @param pages ids and raw data of the pages
+   */
+  void WritePages(std::vector<std::pair<page_id_t, const char *>> pages);
+
+  /**
+   * Start reading a page from the database file. page_data must not be used until the returned future is ready.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer
+   * @return a future that becomes ready when page_data holds the page
+   */
+  virtual std::future<void> ReadPageAsync(page_id_t page_id, char *page_data) = 0;
+
+  /**
+   * Start reading consecutive pages from the database file with a single vectored read. The pages must be adjacent in
+   * the file, see IsAdjacent().
+   * @param first_page_id id of the first page
+   * @param[out] pages output buffer of each page, which must not be used until the returned future is ready
+   * @return a future that becomes ready when all pages have been read
+   */
+  virtual std::future<void> ReadPagesAsync(page_id_t first_page_id, const std::vector<char *> &pages) = 0;
+
+  /**
+   * Read a batch of pages, e.g. to warm up the buffer pool. Runs of adjacent pages are merged into vectored reads,
+   * which are all in flight together. Returns when every page has been read.
+   * @param pages ids and output buffers of the pages
+   */
+  void ReadPages(std::vector<std::pair<page_id_t, char *>> pages);
+
+  /** @return true if page next directly follows page_id in storage, so that both fit in one vectored request */
+  virtual bool IsAdjacent(page_id_t page_id, page_id_t next) const { return next == page_id + 1; }
+
+  /**
+   * Force all page writes completed so far to stable storage.
+   */
+  virtual void SyncDB() = 0;
+
   /**
    * Flush the entire log buffer into disk.
    * @param log_data raw log data
    * @param size size of log entry
    */
-  void WriteLog(char *log_data, int size);
+  virtual void WriteLog(char *log_data, int size) = 0;
 
   /**
    * Read a log entry from the log file.
@@ -69,53 +124,77 @@ class DiskManager {
    * @param offset offset of the log entry in the file
    * @return true if the read was successful, false otherwise
    */
-  bool ReadLog(char *log_data, int size, int offset);
+  virtual bool ReadLog(char *log_data, int size, int offset) = 0;
+
+  /**
+   * Save the ids of the pages resident in the buffer pool, so that it can be warmed up after a restart.
+   * @param page_ids the resident pages, the ones to load first at the front
+   */
+  virtual void WriteResidentPages(const std::vector<page_id_t> &page_ids) = 0;
+
+  /**
+   * @return the page ids saved by the last WriteResidentPages(), without pages that have been deallocated since; empty
+   * if none were saved
+   */
+  virtual std::vector<page_id_t> ReadResidentPages() = 0;
 
-   /**
-   * Allocate a page on disk.
+  /**
+   * Allocate a page on disk, reusing a deallocated one if possible. The page id is congruent to instance_index modulo
+   * num_instances, so that each instance of a parallel buffer pool gets ids that map back to it.
+   * @param num_instances number of instances sharing the page id space
+   * @param instance_index residue of the page id
    * @return the id of the allocated page
    */
-  page_id_t AllocatePage();
+  virtual page_id_t AllocatePage(uint32_t num_instances = 1, uint32_t instance_index = 0) = 0;
 
   /**
    * Deallocate a page on disk.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(page_id_t page_id);
+  virtual void DeallocatePage(page_id_t page_id) = 0;
+
+  /** @return true if page_id is allocated, and not deallocated since */
+  virtual bool IsPageAllocated(page_id_t page_id) = 0;
+
+  /**
+   * Reserve an extent of EXTENT_SIZE contiguous pages for a table or index. Its pages are handed out one by one with
+   * AllocateReservedPage(); AllocatePage() does not use them.
+   * @return the id of the first page of the extent
+   */
+  virtual page_id_t ReserveExtent() = 0;
+
+  /**
+   * Allocate a page of a reserved extent.
+   * @param page_id id of a reserved page
+   */
+  virtual void AllocateReservedPage(page_id_t page_id) = 0;
+
+  /** @return the number of deallocated pages waiting to be reused */
+  virtual int GetNumFreePages() = 0;
 
   /** @return the number of disk flushes */
-  int GetNumFlushes() const;
+  virtual int GetNumFlushes() const = 0;
 
   /** @return true iff the in-memory content has not been flushed yet */
-  bool GetFlushState() const;
+  virtual bool GetFlushState() const = 0;
 
   /** @return the number of disk writes */
-  int GetNumWrites() const;
+  virtual int GetNumWrites() const = 0;
+
+  /** @return the number of disk reads */
+  virtual int GetNumReads() const = 0;
+
+  /** @return true if the pages bypass the OS page cache */
+  virtual bool IsDirectIO() const { return false; }
 
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
    */
-  inline void SetFlushLogFuture(std::future<void> *f) { flush_log_f_ = f; }
+  virtual void SetFlushLogFuture(std::future<void> *f) = 0;
 
   /** Checks if the non-blocking flush future was set. */
-  inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
-
- private:
-  int GetFileSize(const std::string &file_name);
-  // stream to write log file
-  std::fstream log_io_;
-  std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
-  std::string file_name_;
-  std::atomic<page_id_t> next_page_id_;
-  int num_flushes_;
-  int num_writes_;
-  bool flush_log_;
-  std::future<void> *flush_log_f_;
-  // With multiple buffer pool instances, need to protect file access
-  std::mutex db_io_latch_;
+  virtual bool HasFlushLogFuture() = 0;
 };
 
 }  // namespace bustub
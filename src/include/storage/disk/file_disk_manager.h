@@ -0,0 +1,145 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// file_disk_manager.h
+//
+// Identification: src/include/storage/disk/file_disk_manager.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <fstream>
+#include <future>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/free_space_map.h"
+#include "storage/disk/io_uring.h"
+
+namespace bustub {
+
+/**
+ * FileDiskManager keeps the pages in a single database file, the log in a log file next to it. Pages are read and
+ * written positionally through io_uring, or pread/pwrite where it is unavailable. The free space map is stored in the
+ * db file too: each map page precedes the FreeSpaceMap::MAP_PAGE_CAPACITY pages it describes. Allocations only mark
+ * the map pages dirty, so they never wait on the disk; SyncDB() and ShutDown() write them back. The first page of the
+ * file is a header naming the file format.
+ */
+class FileDiskManager : public DiskManager {
+ public:
+  /**
+   * Creates a new disk manager that writes to the specified database file.
+   * @param db_file the file name of the database file to write to
+   * @throws Exception if the file exists but has a different format
+   */
+  explicit FileDiskManager(const std::string &db_file);
+
+  ~FileDiskManager() override;
+
+  /** Page requests after this complete right away: reads return zeros and writes are dropped. */
+  void ShutDown() override;
+
+  std::future<void> WritePageAsync(page_id_t page_id, const char *page_data) override;
+
+  std::future<void> WritePagesAsync(page_id_t first_page_id, const std::vector<const char *> &pages) override;
+
+  std::future<void> ReadPageAsync(page_id_t page_id, char *page_data) override;
+
+  std::future<void> ReadPagesAsync(page_id_t first_page_id, const std::vector<char *> &pages) override;
+
+  /** Map pages sit between the runs of data pages they describe. */
+  bool IsAdjacent(page_id_t page_id, page_id_t next) const override;
+
+  void SyncDB() override;
+
+  void WriteLog(char *log_data, int size) override;
+
+  bool ReadLog(char *log_data, int size, int offset) override;
+
+  void WriteResidentPages(const std::vector<page_id_t> &page_ids) override;
+
+  std::vector<page_id_t> ReadResidentPages() override;
+
+  page_id_t AllocatePage(uint32_t num_instances = 1, uint32_t instance_index = 0) override;
+
+  void DeallocatePage(page_id_t page_id) override;
+
+  bool IsPageAllocated(page_id_t page_id) override;
+
+  page_id_t ReserveExtent() override;
+
+  void AllocateReservedPage(page_id_t page_id) override;
+
+  int GetNumFreePages() override;
+
+  int GetNumFlushes() const override;
+
+  bool GetFlushState() const override;
+
+  int GetNumWrites() const override;
+
+  int GetNumReads() const override;
+
+  /** @return true if the db file was opened with O_DIRECT */
+  bool IsDirectIO() const override { return direct_io_; }
+
+  void SetFlushLogFuture(std::future<void> *f) override { flush_log_f_ = f; }
+
+  bool HasFlushLogFuture() override { return flush_log_f_ != nullptr; }
+
+ private:
+  /** The header page starts with this, followed by the format version and the page size as uint32_t. */
+  static constexpr char FILE_MAGIC[8] = {'B', 'U', 'S', 'T', 'U', 'B', 'D', 'B'};
+  /** Bump on any change to the file layout. */
+  static constexpr uint32_t FILE_FORMAT_VERSION = 1;
+
+  int GetFileSize(const std::string &file_name);
+  void InitHeader();
+  static off_t PageOffset(page_id_t page_id);
+  static off_t MapPageOffset(size_t map_page);
+  char *AllocateBounceBuffer(const char *page_data);
+  void WriteAt(off_t offset, const char *page_data, size_t written);
+  void ReadAt(off_t offset, char *page_data, size_t read_count);
+  void LoadFreeSpaceMap();
+  void FlushFreeSpaceMap();
+  bool BeginIO();
+  void EndIO();
+  void StopIO();
+
+  int num_flushes_{0};
+  std::atomic<int> num_writes_{0};
+  std::atomic<int> num_reads_{0};
+  bool flush_log_{false};
+  std::future<void> *flush_log_f_{nullptr};
+  // stream to write log file
+  std::fstream log_io_;
+  std::string log_name_;
+  std::string file_name_;
+  // where WriteResidentPages() saves the page ids, next to the db file
+  std::string resident_pages_name_;
+  // descriptor of the db file, pages are read and written positionally so no latch is needed
+  int db_fd_{-1};
+  // true if db_fd_ bypasses the page cache; page buffers that are not PAGE_SIZE aligned then go through a copy
+  bool direct_io_{false};
+  // async page I/O, requests fall back to pread/pwrite when io_uring is unavailable
+  std::unique_ptr<IOUring> io_ring_;
+  // page requests whose completion has not run yet; ShutDown() waits for them and refuses new ones
+  std::mutex io_latch_;
+  std::condition_variable io_cv_;
+  int in_flight_{0};
+  bool io_stopped_{false};
+  FreeSpaceMap fsm_;
+  // serializes writing back map pages, so that an older copy never overwrites a newer one
+  std::mutex fsm_flush_latch_;
+};
+
+}  // namespace bustub
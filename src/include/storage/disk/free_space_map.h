@@ -0,0 +1,96 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.h
+//
+// Identification: src/include/storage/disk/free_space_map.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <set>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * FreeSpaceMap tracks which pages of a disk manager are allocated, with one bit per page. The bits are grouped in map
+ * pages of PAGE_SIZE bytes, each covering MAP_PAGE_CAPACITY pages, which a disk manager can store alongside the pages
+ * they describe. Reserved extents are kept in memory only.
+ */
+class FreeSpaceMap {
+ public:
+  /** Pages tracked by one map page. */
+  static constexpr size_t MAP_PAGE_CAPACITY = PAGE_SIZE * 8;
+
+  /**
+   * Allocate the lowest free page with the given residue, or a new one past the end.
+   * @param num_instances number of instances sharing the page id space
+   * @param instance_index residue of the page id
+   * @return the id of the allocated page
+   */
+  page_id_t AllocatePage(uint32_t num_instances, uint32_t instance_index);
+
+  /**
+   * Free an allocated page, so that AllocatePage() hands it out again.
+   * @return false if the page was not allocated
+   */
+  bool DeallocatePage(page_id_t page_id);
+
+  /** @return the first page of a free extent of EXTENT_SIZE pages, see DiskManager::ReserveExtent() */
+  page_id_t ReserveExtent();
+
+  /** Allocate a page of an extent returned by ReserveExtent(). */
+  void AllocateReservedPage(page_id_t page_id);
+
+  /** @return true if page_id is allocated */
+  bool IsAllocated(page_id_t page_id);
+
+  /** @return the number of pages below the highest allocated one that are neither allocated nor reserved */
+  int GetNumFreePages();
+
+  /**
+   * Replace the map with stored map pages.
+   * @param map_pages the contents of map pages 0, 1, ..., each PAGE_SIZE bytes
+   */
+  void Load(const std::vector<char> &map_pages);
+
+  /**
+   * Copy out the map pages changed since the last call, e.g. to write them back.
+   * @param[out] map_pages the indexes of the changed map pages
+   * @param[out] data their contents, PAGE_SIZE bytes each
+   */
+  void TakeDirtyMapPages(std::vector<size_t> *map_pages, std::vector<char> *data);
+
+ private:
+  static constexpr size_t MAP_PAGE_WORDS = PAGE_SIZE / sizeof(uint64_t);
+  static_assert(EXTENT_SIZE % 64 == 0 && MAP_PAGE_CAPACITY % EXTENT_SIZE == 0, "extents must not straddle map pages");
+
+  page_id_t FindFreePage(uint32_t num_instances, uint32_t instance_index);
+  bool IsSet(page_id_t page_id) const;
+  void SetAllocated(page_id_t page_id, bool allocated);
+  void Grow(page_id_t page_id);
+
+  std::mutex latch_;
+  // one bit per page, set if the page is allocated
+  std::vector<uint64_t> bits_;
+  // pages of reserved extents that are not allocated yet
+  std::vector<uint64_t> reserved_;
+  // map pages changed since the last TakeDirtyMapPages()
+  std::set<size_t> dirty_map_pages_;
+  // one past the highest page id ever allocated
+  page_id_t num_pages_{0};
+  // pages below num_pages_ that are neither allocated nor reserved
+  int num_free_pages_{0};
+  // words of bits_ before this one have no free pages
+  size_t free_hint_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,106 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// io_uring.h
+//
+// Identification: src/include/storage/disk/io_uring.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <condition_variable>  // NOLINT
+#include <functional>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+
+struct io_uring_sqe;
+
+namespace bustub {
+
+/**
+ * IOUring is a minimal io_uring instance for positional reads and writes, driven through the raw system calls.
+ *
+ * Any number of threads may submit concurrently; each request is handed to the kernel right away. A completion thread
+ * reaps finished requests and runs their callbacks. At most `entries` requests are in flight, Submit() blocks beyond
+ * that. When the kernel does not support io_uring (or it is disabled, as in many containers), IsAvailable() returns
+ * false and every Submit() is refused, so that the caller can fall back to synchronous I/O.
+ */
+class IOUring {
+ public:
+  /** Called on the completion thread with the number of bytes transferred, or -errno. */
+  using Callback = std::function<void(int)>;
+
+  /**
+   * Set up a new io_uring.
+   * @param entries maximum number of requests in flight
+   */
+  explicit IOUring(uint32_t entries);
+
+  /**
+   * Wait for all requests in flight, then tear down the ring.
+   */
+  ~IOUring();
+
+  /** @return true if the ring was set up and accepts requests */
+  bool IsAvailable() const { return ring_fd_ >= 0; }
+
+  /**
+   * Start reading len bytes at offset of fd into buf, or writing them from buf when write is set.
+   * @return false if the ring is not available or the kernel refused the request; the callback is not called then
+   */
+  bool Submit(bool write, int fd, char *buf, uint32_t len, off_t offset, Callback callback);
+
+  /**
+   * Start a vectored read or write of the iovcnt buffers in iov, back to back at offset of fd. iov must stay valid
+   * until the callback runs.
+   * @return false if the ring is not available or the kernel refused the request; the callback is not called then
+   */
+  bool SubmitVectored(bool write, int fd, const iovec *iov, uint32_t iovcnt, off_t offset, Callback callback);
+
+ private:
+  /** Reserve a slot among the requests in flight and hand the request to the kernel. */
+  bool SubmitRequest(uint8_t opcode, int fd, const void *addr, uint32_t len, off_t offset, Callback callback);
+
+  /**
+   * Hand one sqe to the kernel. Caller holds sq_latch_.
+   * @return 0, or the errno of io_uring_enter; the sqe is then taken back and will not complete
+   */
+  int Enqueue(uint8_t opcode, int fd, const void *addr, uint32_t len, off_t offset, uint64_t user_data);
+
+  /** Body of the completion thread. */
+  void ReapCompletions();
+
+  int ring_fd_{-1};
+  void *sq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  void *cq_ring_{nullptr};
+  size_t cq_ring_size_{0};
+  io_uring_sqe *sqes_{nullptr};
+  size_t sqes_size_{0};
+
+  // pointers into the shared rings
+  unsigned *sq_tail_{nullptr};
+  unsigned *sq_mask_{nullptr};
+  unsigned *sq_array_{nullptr};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned *cq_mask_{nullptr};
+  void *cqes_{nullptr};
+
+  const uint32_t entries_;
+  /** Serializes submissions, the kernel only supports a single producer per ring. */
+  std::mutex sq_latch_;
+  /** Protects in_flight_. */
+  std::mutex latch_;
+  std::condition_variable cv_;
+  uint32_t in_flight_{0};
+  std::thread completion_thread_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,161 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// latency_disk_manager.h
+//
+// Identification: src/include/storage/disk/latency_disk_manager.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <future>              // NOLINT
+#include <map>
+#include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * Timing of an emulated storage device.
+ */
+struct DeviceProfile {
+  /** Time from issuing a page read until its data arrives, without queueing. */
+  std::chrono::microseconds read_latency_;
+  /** Time from issuing a page write until the device acknowledges it, without queueing. */
+  std::chrono::microseconds write_latency_;
+  /** Time a SyncDB() takes once the device is idle. */
+  std::chrono::microseconds sync_latency_;
+  /** Transfer rate in bytes per second, shared by all requests. */
+  uint64_t bandwidth_;
+  /** Requests the device works on in parallel; more have to wait. */
+  uint32_t queue_depth_;
+
+  /** A 7200 rpm hard disk: seeks dominate and requests are served one at a time. */
+  static DeviceProfile Hdd();
+  /** A SATA flash SSD, limited by the bus bandwidth and NCQ depth. */
+  static DeviceProfile SataSsd();
+  /** A NVMe flash SSD. */
+  static DeviceProfile Nvme();
+};
+
+/**
+ * LatencyDiskManager wraps another disk manager and delays the completion of each request as the emulated device
+ * would. A request occupies one of queue_depth_ slots for its latency, and its transfer is serialized with all others
+ * at bandwidth_; SyncDB() waits for the device to become idle. The requests are carried out by the wrapped disk
+ * manager right away, only their completion is held back, so the wrapped one should be fast (a MemoryDiskManager
+ * gives the same timing on any machine).
+ *
+ * Completions are delivered by a timer thread which spins for the last stretch, so latencies of a few microseconds are
+ * still met rather than rounded up to the scheduler's timer slack.
+ */
+class LatencyDiskManager : public DiskManager {
+ public:
+  /**
+   * @param disk_manager the disk manager that carries out the requests, owned by the new one
+   * @param profile timing of the emulated device
+   */
+  LatencyDiskManager(std::unique_ptr<DiskManager> disk_manager, const DeviceProfile &profile);
+
+  /** Waits for all requests in flight. */
+  ~LatencyDiskManager() override;
+
+  void ShutDown() override;
+
+  std::future<void> WritePageAsync(page_id_t page_id, const char *page_data) override;
+
+  std::future<void> WritePagesAsync(page_id_t first_page_id, const std::vector<const char *> &pages) override;
+
+  std::future<void> ReadPageAsync(page_id_t page_id, char *page_data) override;
+
+  std::future<void> ReadPagesAsync(page_id_t first_page_id, const std::vector<char *> &pages) override;
+
+  bool IsAdjacent(page_id_t page_id, page_id_t next) const override;
+
+  void SyncDB() override;
+
+  /** Log writes are charged like a page write of size bytes, and return when it has completed. */
+  void WriteLog(char *log_data, int size) override;
+
+  bool ReadLog(char *log_data, int size, int offset) override;
+
+  void WriteResidentPages(const std::vector<page_id_t> &page_ids) override;
+
+  std::vector<page_id_t> ReadResidentPages() override;
+
+  page_id_t AllocatePage(uint32_t num_instances = 1, uint32_t instance_index = 0) override;
+
+  void DeallocatePage(page_id_t page_id) override;
+
+  bool IsPageAllocated(page_id_t page_id) override;
+
+  page_id_t ReserveExtent() override;
+
+  void AllocateReservedPage(page_id_t page_id) override;
+
+  int GetNumFreePages() override;
+
+  int GetNumFlushes() const override;
+
+  bool GetFlushState() const override;
+
+  int GetNumWrites() const override;
+
+  int GetNumReads() const override;
+
+  bool IsDirectIO() const override;
+
+  void SetFlushLogFuture(std::future<void> *f) override;
+
+  bool HasFlushLogFuture() override;
+
+  /** @return the emulated device */
+  const DeviceProfile &GetProfile() const { return profile_; }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  /** A request whose completion is held back until its deadline. */
+  struct Completion {
+    std::future<void> io_;
+    std::shared_ptr<std::promise<void>> done_;
+  };
+
+  /**
+   * Book a request transferring num_bytes on the emulated device.
+   * @return the time at which the request completes
+   */
+  Clock::time_point Schedule(uint64_t num_bytes, std::chrono::microseconds latency);
+
+  /** @return a future that becomes ready once io is and deadline has passed */
+  std::future<void> Complete(std::future<void> io, Clock::time_point deadline);
+
+  /** Body of the timer thread. */
+  void DeliverCompletions();
+
+  std::unique_ptr<DiskManager> disk_manager_;
+  const DeviceProfile profile_;
+
+  /** Protects the device state and the pending completions. */
+  std::mutex latch_;
+  std::condition_variable cv_;
+  /** When each queue slot becomes free. */
+  std::vector<Clock::time_point> slot_free_at_;
+  /** When the transfers booked so far are done. */
+  Clock::time_point bus_free_at_;
+  /** Pending completions by deadline. */
+  std::multimap<Clock::time_point, Completion> pending_;
+  bool shutdown_{false};
+  std::thread timer_thread_;
+};
+
+}  // namespace bustub
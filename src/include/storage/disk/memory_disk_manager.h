@@ -0,0 +1,103 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// memory_disk_manager.h
+//
+// Identification: src/include/storage/disk/memory_disk_manager.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <future>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/free_space_map.h"
+
+namespace bustub {
+
+/**
+ * MemoryDiskManager keeps the pages and the log in memory. Nothing survives the disk manager, and every request
+ * completes before it returns, so it measures the CPU cost of the layers above without any I/O.
+ */
+class MemoryDiskManager : public DiskManager {
+ public:
+  MemoryDiskManager() = default;
+
+  ~MemoryDiskManager() override = default;
+
+  void ShutDown() override {}
+
+  std::future<void> WritePageAsync(page_id_t page_id, const char *page_data) override;
+
+  std::future<void> WritePagesAsync(page_id_t first_page_id, const std::vector<const char *> &pages) override;
+
+  std::future<void> ReadPageAsync(page_id_t page_id, char *page_data) override;
+
+  std::future<void> ReadPagesAsync(page_id_t first_page_id, const std::vector<char *> &pages) override;
+
+  void SyncDB() override {}
+
+  void WriteLog(char *log_data, int size) override;
+
+  bool ReadLog(char *log_data, int size, int offset) override;
+
+  void WriteResidentPages(const std::vector<page_id_t> &page_ids) override;
+
+  std::vector<page_id_t> ReadResidentPages() override;
+
+  page_id_t AllocatePage(uint32_t num_instances = 1, uint32_t instance_index = 0) override;
+
+  /** Deallocating a page also frees its memory. */
+  void DeallocatePage(page_id_t page_id) override;
+
+  bool IsPageAllocated(page_id_t page_id) override;
+
+  page_id_t ReserveExtent() override;
+
+  void AllocateReservedPage(page_id_t page_id) override;
+
+  int GetNumFreePages() override;
+
+  int GetNumFlushes() const override;
+
+  /** Log writes complete right away, so this is always false. */
+  bool GetFlushState() const override { return false; }
+
+  int GetNumWrites() const override;
+
+  int GetNumReads() const override;
+
+  void SetFlushLogFuture(std::future<void> *f) override { flush_log_f_ = f; }
+
+  bool HasFlushLogFuture() override { return flush_log_f_ != nullptr; }
+
+ private:
+  /** @return the buffer of page_id, allocating it if create is set; nullptr if it was never written */
+  char *GetPageData(page_id_t page_id, bool create);
+
+  /** Protects the page table; the contents of a page are protected by the caller, as with a file. */
+  std::shared_mutex latch_;
+  /** Page buffers indexed by page id, nullptr for pages that were never written. */
+  std::vector<std::unique_ptr<char[]>> pages_;
+  std::mutex log_latch_;
+  std::string log_;
+  /** The page ids of WriteResidentPages(). */
+  std::vector<page_id_t> resident_pages_;
+  FreeSpaceMap fsm_;
+  int num_flushes_{0};
+  std::atomic<int> num_writes_{0};
+  std::atomic<int> num_reads_{0};
+  std::future<void> *flush_log_f_{nullptr};
+};
+
+}  // namespace bustub
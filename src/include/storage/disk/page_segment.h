@@ -0,0 +1,53 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_segment.h
+//
+// Identification: src/include/storage/disk/page_segment.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * PageSegment is the set of pages owned by one table heap or index. Its pages are allocated from extents of EXTENT_SIZE
+ * contiguous pages that the segment reserves one at a time, so that pages created one after the other are also
+ * neighbors in the db file and a sequential scan over them is sequential I/O.
+ *
+ * Pass it to BufferPoolManager::NewPageInSegment(). The page ids of an extent are spread over all instances of a
+ * parallel buffer pool as usual; only their placement in the file changes. Pages of the current extent that are never
+ * allocated stay reserved until the disk manager is reopened.
+ */
+class PageSegment {
+ public:
+  PageSegment() = default;
+
+  DISALLOW_COPY_AND_MOVE(PageSegment);
+
+  /**
+   * Allocate the next page of the segment, reserving a new extent when the current one is used up.
+   * @param disk_manager the disk manager of the db file
+   * @return the id of the allocated page
+   */
+  page_id_t AllocatePage(DiskManager *disk_manager);
+
+ private:
+  std::mutex latch_;
+  /** Next unallocated page of the current extent. */
+  page_id_t next_page_id_{INVALID_PAGE_ID};
+  /** One past the last page of the current extent. */
+  page_id_t extent_end_{INVALID_PAGE_ID};
+};
+
+}  // namespace bustub
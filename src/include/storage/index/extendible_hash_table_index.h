@@ -39,6 +39,20 @@ class ExtendibleHashTableIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  bool InsertEntries(const std::vector<Tuple> &keys, const std::vector<RID> &rids, Transaction *transaction) override;
+
+  bool ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                Transaction *transaction) override;
+
+  /**
+   * Builds the index from scratch, see ExtendibleHashTable::BulkLoad(). The index must be empty for the pages to be
+   * written bottom-up; otherwise the entries are inserted in a batch.
+   * @param keys the index keys, already extracted from the tuples
+   * @param rids the rids of the tuples, rids[i] with keys[i]
+   * @param transaction the current transaction
+   */
+  void BulkLoad(const std::vector<KeyType> &keys, const std::vector<RID> &rids, Transaction *transaction);
+
  protected:
   // comparator for key
   KeyComparator comparator_;
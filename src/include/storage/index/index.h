@@ -175,6 +175,43 @@ class Index {
    */
   virtual void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) = 0;
 
+  ///////////////////////////////////////////////////////////////////
+  // Batch Modification
+  ///////////////////////////////////////////////////////////////////
+
+  /**
+   * Insert a batch of entries into the index. The default inserts them one at a time; an index that can do better,
+   * e.g. by visiting each of its pages once per batch, overrides it.
+   * @param keys The index keys
+   * @param rids The RIDs associated with the keys, rids[i] with keys[i]
+   * @param transaction The transaction context
+   * @return false if the batch could not be completed, e.g. because the buffer pool ran out of frames; some entries
+   * may be missing then, InsertEntry() them one at a time
+   */
+  virtual bool InsertEntries(const std::vector<Tuple> &keys, const std::vector<RID> &rids, Transaction *transaction) {
+    for (size_t i = 0; i < keys.size(); i++) {
+      InsertEntry(keys[i], rids[i], transaction);
+    }
+    return true;
+  }
+
+  /**
+   * Search the index for each of a batch of keys. The default searches them one at a time.
+   * @param keys The index keys
+   * @param results results->at(i) is populated with the RIDs of keys[i]
+   * @param transaction The transaction context
+   * @return false if the batch could not be completed, e.g. because the buffer pool ran out of frames; some results
+   * may be missing then, ScanKey() the keys one at a time
+   */
+  virtual bool ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                        Transaction *transaction) {
+    results->assign(keys.size(), std::vector<RID>());
+    for (size_t i = 0; i < keys.size(); i++) {
+      ScanKey(keys[i], &(*results)[i], transaction);
+    }
+    return true;
+  }
+
  private:
   /** The Index structure owns its metadata */
   std::unique_ptr<IndexMetadata> metadata_;
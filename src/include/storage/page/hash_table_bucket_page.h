@@ -34,6 +34,10 @@ namespace bustub {
  *  The above format omits the space required for the occupied_ and
  *  readable_ arrays. More information is in storage/page/hash_table_page_defs.h.
  *
+ *  Every slot also keeps a one-byte fingerprint of its key in fingerprints_.
+ *  A probe compares the fingerprint of the probed key with a whole block of
+ *  slots at once (with SSE2/AVX2 when available) and only calls the
+ *  comparator on the readable slots whose fingerprint matches.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class HashTableBucketPage {
@@ -144,10 +148,24 @@ class HashTableBucketPage {
   void PrintBucket();
 
  private:
+  /** @return the fingerprint of key, the top byte of a hash of its bytes */
+  static uint8_t Fingerprint(const KeyType &key);
+
+  /**
+   * @return bit i set if slot first_idx + i has the given fingerprint, for the 64 slots from first_idx on; slots past
+   * the end of the bucket never match
+   */
+  uint64_t MatchFingerprints(uint32_t first_idx, uint8_t fingerprint) const;
+
+  /** @return the bits of slots 64 * word_idx to 64 * word_idx + 63 of bitmap, which is occupied_ or readable_ */
+  static uint64_t BitmapWord(const char *bitmap, uint32_t word_idx);
+
   //  For more on BUCKET_ARRAY_SIZE see storage/page/hash_table_page_defs.h
   char occupied_[(BUCKET_ARRAY_SIZE - 1) / 8 + 1];
   // 0 if tombstone/brand new (never occupied), 1 otherwise.
   char readable_[(BUCKET_ARRAY_SIZE - 1) / 8 + 1];
+  // fingerprint of the key in each slot, meaningless unless the slot is readable
+  uint8_t fingerprints_[BUCKET_ARRAY_SIZE];
   MappingType array_[0];
 };
 
@@ -27,9 +27,13 @@ namespace bustub {
  * Directory Page for extendible hash table.
  *
  * Directory format (size in byte):
- * --------------------------------------------------------------------------------------------
- * | LSN (4) | PageId(4) | GlobalDepth(4) | LocalDepths(512) | BucketPageIds(2048) | Free(1524)
- * --------------------------------------------------------------------------------------------
+ * ---------------------------------------------------------------------------------------------------------------
+ * | LSN (4) | PageId(4) | GlobalDepth(4) | LocalDepths(512) | BucketPageIds(2048) | HeaderDepths(512) | Free(1012)
+ * ---------------------------------------------------------------------------------------------------------------
+ *
+ * Directories under a header share the buckets that are not split by the hash bits the header maps yet. The header
+ * depth of a bucket counts those it is split by, so the bucket is shared by every directory whose header index agrees
+ * on that many low bits.
  */
 class HashTableDirectoryPage {
  public:
@@ -167,6 +171,34 @@ class HashTableDirectoryPage {
    */
   void DecrLocalDepth(uint32_t bucket_idx);
 
+  /**
+   * Gets the number of header hash bits the bucket at bucket_idx is split by, on top of its local depth
+   *
+   * @param bucket_idx the bucket index to lookup
+   * @return the header depth of the bucket at bucket_idx
+   */
+  uint32_t GetHeaderDepth(uint32_t bucket_idx);
+
+  /**
+   * Set the header depth of the bucket at bucket_idx to header_depth
+   *
+   * @param bucket_idx bucket index to update
+   * @param header_depth new header depth
+   */
+  void SetHeaderDepth(uint32_t bucket_idx, uint8_t header_depth);
+
+  /**
+   * Increment the header depth of the bucket at bucket_idx
+   * @param bucket_idx bucket index to increment
+   */
+  void IncrHeaderDepth(uint32_t bucket_idx);
+
+  /**
+   * Decrement the header depth of the bucket at bucket_idx
+   * @param bucket_idx bucket index to decrement
+   */
+  void DecrHeaderDepth(uint32_t bucket_idx);
+
   /**
    * Gets the high bit corresponding to the bucket's local depth.
    * This is not the same as the bucket index itself.  This method
@@ -199,6 +231,7 @@ class HashTableDirectoryPage {
   uint32_t mask_{0};
   uint8_t local_depths_[DIRECTORY_ARRAY_SIZE];
   page_id_t bucket_page_ids_[DIRECTORY_ARRAY_SIZE];
+  uint8_t header_depths_[DIRECTORY_ARRAY_SIZE];
 };
 
 }  // namespace bustub
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
 
@@ -30,11 +31,22 @@ class Page {
   friend class BufferPoolManagerInstance;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
-
-  /** Default destructor. */
-  ~Page() = default;
+  /** Constructor. Allocates and zeros out the page data. */
+  Page() : data_(new char[PAGE_SIZE]), owns_data_(true) { ResetMemory(); }
+
+  /**
+   * Constructor for a page whose data lives elsewhere, e.g. in the frame arena of a buffer pool. The data is not
+   * touched, so that a fresh (zeroed) arena is only backed by memory once its frames are used.
+   * @param data PAGE_SIZE bytes that outlive the page
+   */
+  explicit Page(char *data) : data_(data), owns_data_(false) {}
+
+  /** Destructor. Frees the page data if the page allocated it. */
+  ~Page() {
+    if (owns_data_) {
+      delete[] data_;
+    }
+  }
 
   /** @return the actual data contained within this page */
   inline char *GetData() { return data_; }
@@ -60,6 +72,20 @@ class Page {
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
+  /**
+   * Start an optimistic read of the page, without taking a latch. Writers bump the page version through WLatch(), so
+   * the page must only be written under the write latch while optimistic readers may be around.
+   * @param[out] version the version to pass to ValidateRead() once done reading
+   * @return false if the page is write-latched; retry later or take the read latch instead
+   */
+  inline bool TryOptimisticRead(uint64_t *version) { return rwlatch_.TryOptimisticRead(version); }
+
+  /**
+   * @param version the version TryOptimisticRead() returned
+   * @return true if the page was not write-latched since, so that what was read from it is consistent
+   */
+  inline bool ValidateRead(uint64_t version) { return rwlatch_.Validate(version); }
+
   /** @return the page LSN. */
   inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
@@ -79,13 +105,15 @@ class Page {
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
   /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
-  /** The ID of this page. */
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  /** The pin count of this page. */
-  int pin_count_ = 0;
+  char *const data_;
+  /** True if data_ was allocated by the page itself. */
+  const bool owns_data_;
+  /** The ID of this page. Atomic because buffer pool hits validate it without the pool latch. */
+  std::atomic<page_id_t> page_id_ = INVALID_PAGE_ID;
+  /** The pin count of this page. Negative while the buffer pool has the frame locked for reassignment. */
+  std::atomic<int> pin_count_ = 0;
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
-  bool is_dirty_ = false;
+  std::atomic<bool> is_dirty_ = false;
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
 };
@@ -0,0 +1,177 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.h
+//
+// Identification: src/include/storage/page/page_guard.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/macros.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+
+/**
+ * BasicPageGuard owns the pin of a page and releases it when it goes out of scope, marking the page dirty if the
+ * guard was. It does not latch the page. A guard can be moved but not copied; a guard that was moved from, or whose
+ * fetch failed, is empty.
+ */
+class BasicPageGuard {
+ public:
+  BasicPageGuard() = default;
+
+  /**
+   * Adopt a pin of page.
+   * @param bpm the buffer pool page was fetched from
+   * @param page a pinned page, or nullptr for an empty guard
+   */
+  BasicPageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  DISALLOW_COPY(BasicPageGuard);
+
+  BasicPageGuard(BasicPageGuard &&that) noexcept;
+
+  BasicPageGuard &operator=(BasicPageGuard &&that) noexcept;
+
+  ~BasicPageGuard() { Drop(); }
+
+  /** Unpin the page now. The guard is empty afterwards. */
+  void Drop();
+
+  /** @return true unless the guard is empty */
+  explicit operator bool() const { return page_ != nullptr; }
+
+  /** @return the id of the guarded page */
+  page_id_t PageId() const { return page_->GetPageId(); }
+
+  /** @return the guarded page */
+  Page *GetPage() const { return page_; }
+
+  /** @return the data of the guarded page */
+  char *GetData() const { return page_->GetData(); }
+
+  /** @return the data of the guarded page as a T, e.g. one of the page layouts in storage/page */
+  template <class T>
+  T *As() const {
+    return reinterpret_cast<T *>(page_->GetData());
+  }
+
+  /** Mark the page dirty when the guard releases it. */
+  void SetDirty() { is_dirty_ = true; }
+
+  /** @return true if the page will be marked dirty on release */
+  bool IsDirty() const { return is_dirty_; }
+
+ private:
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+  bool is_dirty_{false};
+};
+
+/**
+ * ReadPageGuard owns the pin and the read latch of a page, and releases both when it goes out of scope.
+ */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+
+  /**
+   * Adopt a pin and the read latch of page.
+   * @param bpm the buffer pool page was fetched from
+   * @param page a pinned and read-latched page, or nullptr for an empty guard
+   */
+  ReadPageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  DISALLOW_COPY(ReadPageGuard);
+
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+
+  ReadPageGuard &operator=(ReadPageGuard &&that) noexcept;
+
+  ~ReadPageGuard() { Drop(); }
+
+  /** Unlatch and unpin the page now. The guard is empty afterwards. */
+  void Drop();
+
+  explicit operator bool() const { return static_cast<bool>(guard_); }
+
+  page_id_t PageId() const { return guard_.PageId(); }
+
+  Page *GetPage() const { return guard_.GetPage(); }
+
+  const char *GetData() const { return guard_.GetData(); }
+
+  /** @return the data of the guarded page as a T; the page methods of this codebase are not const-qualified */
+  template <class T>
+  T *As() const {
+    return guard_.As<T>();
+  }
+
+ private:
+  BasicPageGuard guard_;
+};
+
+/**
+ * WritePageGuard owns the pin and the write latch of a page, and releases both when it goes out of scope. The page
+ * is marked dirty on release once the guard handed out its data or SetDirty() was called.
+ */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+
+  /**
+   * Adopt a pin and the write latch of page.
+   * @param bpm the buffer pool page was fetched from
+   * @param page a pinned and write-latched page, or nullptr for an empty guard
+   */
+  WritePageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  DISALLOW_COPY(WritePageGuard);
+
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+
+  WritePageGuard &operator=(WritePageGuard &&that) noexcept;
+
+  ~WritePageGuard() { Drop(); }
+
+  /** Unlatch and unpin the page now. The guard is empty afterwards. */
+  void Drop();
+
+  explicit operator bool() const { return static_cast<bool>(guard_); }
+
+  page_id_t PageId() const { return guard_.PageId(); }
+
+  Page *GetPage() const { return guard_.GetPage(); }
+
+  /** @return the data of the guarded page for reading; the page is not marked dirty */
+  const char *GetData() const { return guard_.GetData(); }
+
+  /** @return the data of the guarded page for writing; the page is marked dirty */
+  char *GetDataMut() {
+    guard_.SetDirty();
+    return guard_.GetData();
+  }
+
+  /** @return the data of the guarded page as a T for writing; the page is marked dirty */
+  template <class T>
+  T *AsMut() {
+    guard_.SetDirty();
+    return guard_.As<T>();
+  }
+
+  /** Mark the page dirty when the guard releases it. */
+  void SetDirty() { guard_.SetDirty(); }
+
+ private:
+  BasicPageGuard guard_;
+};
+
+}  // namespace bustub
@@ -12,8 +12,11 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
+#include "storage/disk/page_segment.h"
 #include "storage/page/table_page.h"
 #include "storage/table/table_iterator.h"
 #include "storage/table/tuple.h"
@@ -108,11 +111,17 @@ class TableHeap {
   /** @return the id of the first page of this table */
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  /** @return the number of pages this heap created, 0 if it was opened from an existing first page */
+  inline uint32_t GetNumPages() const { return num_pages_; }
+
  private:
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+  std::atomic<uint32_t> num_pages_{0};
+  /** New pages of the heap come from its own extents, so the page chain is laid out sequentially on disk. */
+  PageSegment segment_;
 };
 
 }  // namespace bustub
@@ -13,17 +13,26 @@
 #pragma once
 
 #include <cassert>
+#include <memory>
 
+#include "buffer/buffer_ring.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
+#include "storage/page/page_guard.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 
+class Page;
 class TableHeap;
+class TablePage;
 
 /**
  * TableIterator enables the sequential scan of a TableHeap.
+ *
+ * Once the table is known to be larger than BUFFER_RING_THRESHOLD_PERCENT of the buffer pool, either from its page
+ * count or from the pages scanned so far, the iterator reads through a BufferRing so that the scan does not flush the
+ * pool. Copies of an iterator share its ring.
  */
 class TableIterator {
   friend class Cursor;
@@ -32,7 +41,13 @@ class TableIterator {
   TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        readahead_page_id_(other.readahead_page_id_),
+        readahead_pages_(other.readahead_pages_),
+        pages_scanned_(other.pages_scanned_),
+        ring_(other.ring_) {}
 
   ~TableIterator() { delete tuple_; }
 
@@ -52,13 +67,42 @@ class TableIterator {
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    readahead_page_id_ = other.readahead_page_id_;
+    readahead_pages_ = other.readahead_pages_;
+    pages_scanned_ = other.pages_scanned_;
+    ring_ = other.ring_;
     return *this;
   }
 
  private:
+  /**
+   * Keep TABLE_READAHEAD_PAGES pages of the next_page_id chain ahead of the scan requested from the buffer pool.
+   * A page's successor is only known once the page itself is resident, so the window grows by following pages whose
+   * prefetch has completed and stops at the first one still being read.
+   * @param page the page the iterator just moved to, pinned and read-latched by the caller
+   */
+  void Readahead(TablePage *page);
+
+  /** Fetch a page of the table, through the ring once the scan uses one. */
+  Page *FetchPage(page_id_t page_id);
+
+  /** Fetch and read-latch a page of the table, through the ring once the scan uses one. */
+  ReadPageGuard FetchPageRead(page_id_t page_id);
+
+  /** Switch to a ring if a table of num_pages pages is large compared to the buffer pool. */
+  void UseRingIfLarge(uint32_t num_pages);
+
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  /** Last page of the chain a prefetch was requested for. */
+  page_id_t readahead_page_id_{INVALID_PAGE_ID};
+  /** Number of pages between the current page and readahead_page_id_, inclusive of the latter. */
+  int readahead_pages_{0};
+  /** Number of pages this scan moved to so far. */
+  uint32_t pages_scanned_{0};
+  /** Access strategy of a large scan, nullptr while the scan goes through the pool as usual. */
+  std::shared_ptr<BufferRing> ring_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,64 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_backend.cpp
+//
+// Identification: src/storage/disk/disk_backend.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_backend.h"
+
+#include <cstdlib>
+
+#include "common/exception.h"
+#include "storage/disk/file_disk_manager.h"
+#include "storage/disk/latency_disk_manager.h"
+#include "storage/disk/memory_disk_manager.h"
+
+namespace bustub {
+
+std::unique_ptr<DiskManager> CreateDiskManager(const std::string &db_file, DiskBackend backend) {
+  switch (backend) {
+    case DiskBackend::FILE:
+      return std::make_unique<FileDiskManager>(db_file);
+    case DiskBackend::MEMORY:
+      return std::make_unique<MemoryDiskManager>();
+    case DiskBackend::HDD:
+      return std::make_unique<LatencyDiskManager>(std::make_unique<MemoryDiskManager>(), DeviceProfile::Hdd());
+    case DiskBackend::SATA_SSD:
+      return std::make_unique<LatencyDiskManager>(std::make_unique<MemoryDiskManager>(), DeviceProfile::SataSsd());
+    case DiskBackend::NVME:
+      return std::make_unique<LatencyDiskManager>(std::make_unique<MemoryDiskManager>(), DeviceProfile::Nvme());
+  }
+  return nullptr;
+}
+
+DiskBackend DefaultDiskBackend() {
+  const char *name = std::getenv("BUSTUB_DISK_BACKEND");
+  if (name == nullptr || std::string(name).empty() || std::string(name) == "file") {
+    return DiskBackend::FILE;
+  }
+  if (std::string(name) == "memory") {
+    return DiskBackend::MEMORY;
+  }
+  if (std::string(name) == "hdd") {
+    return DiskBackend::HDD;
+  }
+  if (std::string(name) == "sata_ssd") {
+    return DiskBackend::SATA_SSD;
+  }
+  if (std::string(name) == "nvme") {
+    return DiskBackend::NVME;
+  }
+  throw Exception(ExceptionType::INVALID, "unknown BUSTUB_DISK_BACKEND " + std::string(name));
+}
+
+std::unique_ptr<DiskManager> CreateDiskManager(const std::string &db_file) {
+  return CreateDiskManager(db_file, DefaultDiskBackend());
+}
+
+}  // namespace bustub
@@ -0,0 +1,608 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// file_disk_manager.cpp
+//
+// Identification: src/storage/disk/file_disk_manager.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "common/macros.h"
+#include "storage/disk/file_disk_manager.h"
+
+namespace bustub {
+
+static char *buffer_used;
+
+static std::future<void> MakeReadyFuture() {
+  std::promise<void> done;
+  done.set_value();
+  return done.get_future();
+}
+
+/**
+ * Constructor: open/create a single database file & log file
+ * @input db_file: database file name
+ */
+FileDiskManager::FileDiskManager(const std::string &db_file) : file_name_(db_file) {
+  std::string::size_type n = file_name_.rfind('.');
+  if (n == std::string::npos) {
+    LOG_DEBUG("wrong file format");
+    return;
+  }
+  log_name_ = file_name_.substr(0, n) + ".log";
+  resident_pages_name_ = file_name_.substr(0, n) + ".warmup";
+
+  log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
+  // directory or file does not exist
+  if (!log_io_.is_open()) {
+    log_io_.clear();
+    // create a new file
+    log_io_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::app | std::ios::out);
+    log_io_.close();
+    // reopen with original mode
+    log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
+    if (!log_io_.is_open()) {
+      throw Exception("can't open dblog file");
+    }
+  }
+
+  if (enable_direct_io) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+    direct_io_ = db_fd_ >= 0;
+    // not every file system supports O_DIRECT (e.g. tmpfs), use the page cache there
+    if (!direct_io_ && errno == EINVAL) {
+      LOG_DEBUG("O_DIRECT is not supported for %s", db_file.c_str());
+    }
+  }
+  if (db_fd_ < 0) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  }
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
+  }
+  InitHeader();
+  LoadFreeSpaceMap();
+  io_ring_ = std::make_unique<IOUring>(IO_URING_QUEUE_DEPTH);
+  buffer_used = nullptr;
+}
+
+FileDiskManager::~FileDiskManager() {
+  StopIO();
+  if (db_fd_ >= 0) {
+    FlushFreeSpaceMap();
+    close(db_fd_);
+  }
+}
+
+/**
+ * Close all file streams, once the page requests in flight have completed. Later page requests complete right away:
+ * reads return zeros and writes are dropped.
+ */
+void FileDiskManager::ShutDown() {
+  StopIO();
+  if (db_fd_ >= 0) {
+    FlushFreeSpaceMap();
+    if (fdatasync(db_fd_) != 0) {
+      LOG_DEBUG("I/O error while syncing");
+    }
+    close(db_fd_);
+    db_fd_ = -1;
+  }
+  log_io_.close();
+}
+
+/**
+ * Start writing the specified page. The write is positional and takes no latch, so writes to different pages run in
+ * parallel. It is not synced, call SyncDB() to make it durable.
+ */
+std::future<void> FileDiskManager::WritePageAsync(page_id_t page_id, const char *page_data) {
+  if (!BeginIO()) {
+    LOG_DEBUG("write of page %d after shutdown is dropped", page_id);
+    return MakeReadyFuture();
+  }
+  num_writes_ += 1;
+  auto done = std::make_shared<std::promise<void>>();
+  std::future<void> future = done->get_future();
+  off_t offset = PageOffset(page_id);
+  char *buffer = const_cast<char *>(page_data);
+  char *bounce = AllocateBounceBuffer(page_data);
+  if (bounce != nullptr) {
+    memcpy(bounce, page_data, PAGE_SIZE);
+    buffer = bounce;
+  }
+  auto on_complete = [this, offset, buffer, bounce, done](int result) {
+    // finish short or failed writes synchronously
+    if (result != PAGE_SIZE) {
+      WriteAt(offset, buffer, result > 0 ? result : 0);
+    }
+    free(bounce);
+    EndIO();
+    done->set_value();
+  };
+  if (io_ring_ == nullptr || !io_ring_->Submit(true, db_fd_, buffer, PAGE_SIZE, offset, on_complete)) {
+    on_complete(0);
+  }
+  return future;
+}
+
+/**
+ * Start writing pages.size() consecutive pages from first_page_id on with a single vectored write
+ */
+std::future<void> FileDiskManager::WritePagesAsync(page_id_t first_page_id, const std::vector<const char *> &pages) {
+  if (!BeginIO()) {
+    LOG_DEBUG("write of pages %d.. after shutdown is dropped", first_page_id);
+    return MakeReadyFuture();
+  }
+  num_writes_ += static_cast<int>(pages.size());
+  auto done = std::make_shared<std::promise<void>>();
+  std::future<void> future = done->get_future();
+  off_t offset = PageOffset(first_page_id);
+  auto iov = std::make_shared<std::vector<iovec>>(pages.size());
+  auto bounces = std::make_shared<std::vector<char *>>();
+  for (size_t i = 0; i < pages.size(); i++) {
+    char *buffer = const_cast<char *>(pages[i]);
+    char *bounce = AllocateBounceBuffer(pages[i]);
+    if (bounce != nullptr) {
+      memcpy(bounce, pages[i], PAGE_SIZE);
+      buffer = bounce;
+      bounces->push_back(bounce);
+    }
+    (*iov)[i] = {buffer, static_cast<size_t>(PAGE_SIZE)};
+  }
+  auto on_complete = [this, offset, iov, bounces, done](int result) {
+    // finish short or failed writes page by page
+    size_t written = result > 0 ? result : 0;
+    for (size_t i = 0; i < iov->size(); i++) {
+      size_t page_written = written > i * PAGE_SIZE ? std::min<size_t>(written - i * PAGE_SIZE, PAGE_SIZE) : 0;
+      if (page_written < PAGE_SIZE) {
+        WriteAt(offset + i * PAGE_SIZE, static_cast<const char *>((*iov)[i].iov_base), page_written);
+      }
+    }
+    for (auto *bounce : *bounces) {
+      free(bounce);
+    }
+    EndIO();
+    done->set_value();
+  };
+  if (io_ring_ == nullptr ||
+      !io_ring_->SubmitVectored(true, db_fd_, iov->data(), static_cast<uint32_t>(iov->size()), offset, on_complete)) {
+    on_complete(static_cast<int>(pwritev(db_fd_, iov->data(), static_cast<int>(iov->size()), offset)));
+  }
+  return future;
+}
+
+/**
+ * Start reading pages.size() consecutive pages from first_page_id on with a single vectored read
+ */
+std::future<void> FileDiskManager::ReadPagesAsync(page_id_t first_page_id, const std::vector<char *> &pages) {
+  if (!BeginIO()) {
+    for (auto *page_data : pages) {
+      memset(page_data, 0, PAGE_SIZE);
+    }
+    return MakeReadyFuture();
+  }
+  num_reads_ += static_cast<int>(pages.size());
+  auto done = std::make_shared<std::promise<void>>();
+  std::future<void> future = done->get_future();
+  off_t offset = PageOffset(first_page_id);
+  auto iov = std::make_shared<std::vector<iovec>>(pages.size());
+  auto bounces = std::make_shared<std::vector<char *>>(pages.size());
+  for (size_t i = 0; i < pages.size(); i++) {
+    (*bounces)[i] = AllocateBounceBuffer(pages[i]);
+    (*iov)[i] = {(*bounces)[i] != nullptr ? (*bounces)[i] : pages[i], static_cast<size_t>(PAGE_SIZE)};
+  }
+  auto on_complete = [this, offset, pages, iov, bounces, done](int result) {
+    // finish short reads and reads past the end of the file page by page
+    size_t read_count = result > 0 ? result : 0;
+    for (size_t i = 0; i < iov->size(); i++) {
+      size_t page_read = read_count > i * PAGE_SIZE ? std::min<size_t>(read_count - i * PAGE_SIZE, PAGE_SIZE) : 0;
+      if (page_read < PAGE_SIZE) {
+        ReadAt(offset + i * PAGE_SIZE, static_cast<char *>((*iov)[i].iov_base), page_read);
+      }
+      if ((*bounces)[i] != nullptr) {
+        memcpy(pages[i], (*bounces)[i], PAGE_SIZE);
+        free((*bounces)[i]);
+      }
+    }
+    EndIO();
+    done->set_value();
+  };
+  if (io_ring_ == nullptr ||
+      !io_ring_->SubmitVectored(false, db_fd_, iov->data(), static_cast<uint32_t>(iov->size()), offset, on_complete)) {
+    on_complete(static_cast<int>(preadv(db_fd_, iov->data(), static_cast<int>(iov->size()), offset)));
+  }
+  return future;
+}
+
+/**
+ * Start reading the specified page into the given memory area
+ */
+std::future<void> FileDiskManager::ReadPageAsync(page_id_t page_id, char *page_data) {
+  if (!BeginIO()) {
+    memset(page_data, 0, PAGE_SIZE);
+    return MakeReadyFuture();
+  }
+  num_reads_ += 1;
+  auto done = std::make_shared<std::promise<void>>();
+  std::future<void> future = done->get_future();
+  off_t offset = PageOffset(page_id);
+  char *bounce = AllocateBounceBuffer(page_data);
+  char *buffer = bounce != nullptr ? bounce : page_data;
+  auto on_complete = [this, offset, page_data, buffer, bounce, done](int result) {
+    // finish short reads and reads past the end of the file synchronously
+    if (result != PAGE_SIZE) {
+      ReadAt(offset, buffer, result > 0 ? result : 0);
+    }
+    if (bounce != nullptr) {
+      memcpy(page_data, bounce, PAGE_SIZE);
+      free(bounce);
+    }
+    EndIO();
+    done->set_value();
+  };
+  if (io_ring_ == nullptr || !io_ring_->Submit(false, db_fd_, buffer, PAGE_SIZE, offset, on_complete)) {
+    on_complete(0);
+  }
+  return future;
+}
+
+/**
+ * Private helper function to get an aligned buffer for O_DIRECT I/O on page_data, which the caller frees
+ * @return nullptr if page_data can be used as it is
+ */
+char *FileDiskManager::AllocateBounceBuffer(const char *page_data) {
+  if (!direct_io_ || reinterpret_cast<uintptr_t>(page_data) % PAGE_SIZE == 0) {
+    return nullptr;
+  }
+  return static_cast<char *>(aligned_alloc(PAGE_SIZE, PAGE_SIZE));
+}
+
+/**
+ * Private helper function to write the rest of the page at file offset `offset` from byte `written` on
+ */
+void FileDiskManager::WriteAt(off_t offset, const char *page_data, size_t written) {
+  while (written < PAGE_SIZE) {
+    ssize_t rc = pwrite(db_fd_, page_data + written, PAGE_SIZE - written, offset + written);
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // check for I/O error
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    written += rc;
+  }
+}
+
+/**
+ * Private helper function to read the rest of the page at file offset `offset` from byte `read_count` on
+ */
+void FileDiskManager::ReadAt(off_t offset, char *page_data, size_t read_count) {
+  while (read_count < PAGE_SIZE) {
+    ssize_t rc = pread(db_fd_, page_data + read_count, PAGE_SIZE - read_count, offset + read_count);
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_DEBUG("I/O error while reading");
+      return;
+    }
+    if (rc == 0) {
+      // reading past the end of the file, or the file ends before reading PAGE_SIZE
+      LOG_DEBUG("Read less than a page");
+      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+      return;
+    }
+    read_count += rc;
+  }
+}
+
+/**
+ * Make every page write issued so far, and the free space map, durable
+ */
+void FileDiskManager::SyncDB() {
+  if (!BeginIO()) {
+    return;
+  }
+  FlushFreeSpaceMap();
+  if (fdatasync(db_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing");
+  }
+  EndIO();
+}
+
+/**
+ * Write the contents of the log into disk file
+ * Only return when sync is done, and only perform sequence write
+ */
+void FileDiskManager::WriteLog(char *log_data, int size) {
+  // enforce swap log buffer
+  assert(log_data != buffer_used);
+  buffer_used = log_data;
+
+  if (size == 0) {  // no effect on num_flushes_ if log buffer is empty
+    return;
+  }
+
+  flush_log_ = true;
+
+  if (flush_log_f_ != nullptr) {
+    // used for checking non-blocking flushing
+    assert(flush_log_f_->wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+  }
+
+  num_flushes_ += 1;
+  // sequence write
+  log_io_.write(log_data, size);
+
+  // check for I/O error
+  if (log_io_.bad()) {
+    LOG_DEBUG("I/O error while writing log");
+    return;
+  }
+  // needs to flush to keep disk file in sync
+  log_io_.flush();
+  flush_log_ = false;
+}
+
+/**
+ * Read the contents of the log into the given memory area
+ * Always read from the beginning and perform sequence read
+ * @return: false means already reach the end
+ */
+bool FileDiskManager::ReadLog(char *log_data, int size, int offset) {
+  if (offset >= GetFileSize(log_name_)) {
+    // LOG_DEBUG("end of log file");
+    // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
+    return false;
+  }
+  log_io_.seekp(offset);
+  log_io_.read(log_data, size);
+
+  if (log_io_.bad()) {
+    LOG_DEBUG("I/O error while reading log");
+    return false;
+  }
+  // if log file ends before reading "size"
+  int read_count = log_io_.gcount();
+  if (read_count < size) {
+    log_io_.clear();
+    memset(log_data + read_count, 0, size - read_count);
+  }
+
+  return true;
+}
+
+/**
+ * Save the resident page ids to the warm-up file, replacing it as a whole
+ */
+void FileDiskManager::WriteResidentPages(const std::vector<page_id_t> &page_ids) {
+  std::string tmp_name = resident_pages_name_ + ".tmp";
+  std::ofstream out(tmp_name, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char *>(page_ids.data()),
+            static_cast<std::streamsize>(page_ids.size() * sizeof(page_id_t)));
+  out.close();
+  if (out.fail() || rename(tmp_name.c_str(), resident_pages_name_.c_str()) != 0) {
+    LOG_DEBUG("I/O error while writing the resident pages");
+    remove(tmp_name.c_str());
+  }
+}
+
+/**
+ * Read the page ids saved by WriteResidentPages(), dropping the ones that are no longer allocated
+ */
+std::vector<page_id_t> FileDiskManager::ReadResidentPages() {
+  std::vector<page_id_t> page_ids;
+  int size = GetFileSize(resident_pages_name_);
+  if (size > 0) {
+    page_ids.resize(size / sizeof(page_id_t));
+    std::ifstream in(resident_pages_name_, std::ios::binary);
+    in.read(reinterpret_cast<char *>(page_ids.data()),
+            static_cast<std::streamsize>(page_ids.size() * sizeof(page_id_t)));
+    page_ids.resize(in.gcount() / sizeof(page_id_t));
+  }
+  page_ids.erase(std::remove_if(page_ids.begin(), page_ids.end(),
+                                [&](page_id_t page_id) { return !fsm_.IsAllocated(page_id); }),
+                 page_ids.end());
+  return page_ids;
+}
+
+/**
+ * Allocate new page (operations like create index/table)
+ * Reuses the lowest deallocated page of the requested residue class, or extends the file
+ */
+page_id_t FileDiskManager::AllocatePage(uint32_t num_instances, uint32_t instance_index) {
+  return fsm_.AllocatePage(num_instances, instance_index);
+}
+
+/**
+ * Deallocate page (operations like drop index/table)
+ * The page goes back to the free space map and is handed out again by AllocatePage()
+ */
+void FileDiskManager::DeallocatePage(page_id_t page_id) { fsm_.DeallocatePage(page_id); }
+
+bool FileDiskManager::IsPageAllocated(page_id_t page_id) { return fsm_.IsAllocated(page_id); }
+
+page_id_t FileDiskManager::ReserveExtent() { return fsm_.ReserveExtent(); }
+
+void FileDiskManager::AllocateReservedPage(page_id_t page_id) {
+  fsm_.AllocateReservedPage(page_id);
+}
+
+/**
+ * Returns number of free pages below the end of the file
+ */
+int FileDiskManager::GetNumFreePages() { return fsm_.GetNumFreePages(); }
+
+/**
+ * Returns true if next is stored right behind page_id in the file
+ */
+bool FileDiskManager::IsAdjacent(page_id_t page_id, page_id_t next) const {
+  return next == page_id + 1 && next % FreeSpaceMap::MAP_PAGE_CAPACITY != 0;
+}
+
+/**
+ * Private helper function to get the file offset of a page, past the header and the free space map page of its group
+ */
+off_t FileDiskManager::PageOffset(page_id_t page_id) {
+  auto id = static_cast<off_t>(page_id);
+  return (id + id / FreeSpaceMap::MAP_PAGE_CAPACITY + 2) * PAGE_SIZE;
+}
+
+/**
+ * Private helper function to get the file offset of a free space map page, in front of the pages it describes
+ */
+off_t FileDiskManager::MapPageOffset(size_t map_page) {
+  return static_cast<off_t>((map_page * (FreeSpaceMap::MAP_PAGE_CAPACITY + 1) + 1) * PAGE_SIZE);
+}
+
+/**
+ * Private helper function to write the header page of a new db file, or to check the one of an existing file
+ */
+void FileDiskManager::InitHeader() {
+  char *buffer = static_cast<char *>(aligned_alloc(PAGE_SIZE, PAGE_SIZE));
+  memset(buffer, 0, PAGE_SIZE);
+  const uint32_t format[2] = {FILE_FORMAT_VERSION, static_cast<uint32_t>(PAGE_SIZE)};
+  struct stat stat_buf;
+  bool is_new = fstat(db_fd_, &stat_buf) == 0 && stat_buf.st_size == 0;
+  bool is_valid = true;
+  if (is_new) {
+    memcpy(buffer, FILE_MAGIC, sizeof(FILE_MAGIC));
+    memcpy(buffer + sizeof(FILE_MAGIC), format, sizeof(format));
+    WriteAt(0, buffer, 0);
+  } else {
+    ReadAt(0, buffer, 0);
+    is_valid = memcmp(buffer, FILE_MAGIC, sizeof(FILE_MAGIC)) == 0 &&
+               memcmp(buffer + sizeof(FILE_MAGIC), format, sizeof(format)) == 0;
+  }
+  free(buffer);
+  if (!is_valid) {
+    close(db_fd_);
+    db_fd_ = -1;
+    throw Exception("db file " + file_name_ + " has an unknown format or version");
+  }
+}
+
+/**
+ * Private helper function to read the free space map pages of an existing db file
+ */
+void FileDiskManager::LoadFreeSpaceMap() {
+  struct stat stat_buf;
+  off_t num_blocks = fstat(db_fd_, &stat_buf) == 0 ? (stat_buf.st_size + PAGE_SIZE - 1) / PAGE_SIZE : 0;
+  // every block past the header is a map page or one of the data pages behind it
+  size_t num_map_pages =
+      num_blocks > 1 ? (num_blocks - 1 + FreeSpaceMap::MAP_PAGE_CAPACITY) / (FreeSpaceMap::MAP_PAGE_CAPACITY + 1) : 0;
+  std::vector<char> map_pages(num_map_pages * PAGE_SIZE);
+  char *buffer = static_cast<char *>(aligned_alloc(PAGE_SIZE, PAGE_SIZE));
+  for (size_t map_page = 0; map_page < num_map_pages; map_page++) {
+    ReadAt(MapPageOffset(map_page), buffer, 0);
+    memcpy(&map_pages[map_page * PAGE_SIZE], buffer, PAGE_SIZE);
+  }
+  free(buffer);
+  fsm_.Load(map_pages);
+}
+
+/**
+ * Private helper function to count a request in flight
+ * @return false if the disk manager is shut down, and the request must not touch the file
+ */
+bool FileDiskManager::BeginIO() {
+  std::scoped_lock scoped_io_latch(io_latch_);
+  if (io_stopped_) {
+    return false;
+  }
+  in_flight_++;
+  return true;
+}
+
+/**
+ * Private helper function to count a request as completed, once it no longer uses the file
+ */
+void FileDiskManager::EndIO() {
+  std::scoped_lock scoped_io_latch(io_latch_);
+  if (--in_flight_ == 0) {
+    io_cv_.notify_all();
+  }
+}
+
+/**
+ * Private helper function to refuse new requests and wait for the ones in flight, then stop io_uring
+ */
+void FileDiskManager::StopIO() {
+  {
+    std::unique_lock io_lock(io_latch_);
+    io_stopped_ = true;
+    io_cv_.wait(io_lock, [&] { return in_flight_ == 0; });
+  }
+  io_ring_.reset();
+}
+
+/**
+ * Private helper function to write back the dirty free space map pages
+ */
+void FileDiskManager::FlushFreeSpaceMap() {
+  std::scoped_lock scoped_flush_latch(fsm_flush_latch_);
+  std::vector<size_t> map_pages;
+  std::vector<char> data;
+  fsm_.TakeDirtyMapPages(&map_pages, &data);
+  if (map_pages.empty()) {
+    return;
+  }
+  char *buffer = static_cast<char *>(aligned_alloc(PAGE_SIZE, PAGE_SIZE));
+  for (size_t i = 0; i < map_pages.size(); i++) {
+    memcpy(buffer, &data[i * PAGE_SIZE], PAGE_SIZE);
+    WriteAt(MapPageOffset(map_pages[i]), buffer, 0);
+  }
+  free(buffer);
+}
+
+/**
+ * Returns number of flushes made so far
+ */
+int FileDiskManager::GetNumFlushes() const { return num_flushes_; }
+
+/**
+ * Returns number of Writes made so far
+ */
+int FileDiskManager::GetNumWrites() const { return num_writes_; }
+
+/**
+ * Returns number of Reads made so far
+ */
+int FileDiskManager::GetNumReads() const { return num_reads_; }
+
+/**
+ * Returns true if the log is currently being flushed
+ */
+bool FileDiskManager::GetFlushState() const { return flush_log_; }
+
+/**
+ * Private helper function to get disk file size
+ */
+int FileDiskManager::GetFileSize(const std::string &file_name) {
+  struct stat stat_buf;
+  int rc = stat(file_name.c_str(), &stat_buf);
+  return rc == 0 ? static_cast<int>(stat_buf.st_size) : -1;
+}
+
+}  // namespace bustub
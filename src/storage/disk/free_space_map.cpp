@@ -0,0 +1,186 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.cpp
+//
+// Identification: src/storage/disk/free_space_map.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/free_space_map.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * Reuses the lowest deallocated page of the requested residue class, or extends the map
+ */
+page_id_t FreeSpaceMap::AllocatePage(uint32_t num_instances, uint32_t instance_index) {
+  std::scoped_lock scoped_latch(latch_);
+  page_id_t page_id = num_free_pages_ > 0 ? FindFreePage(num_instances, instance_index) : INVALID_PAGE_ID;
+  if (page_id == INVALID_PAGE_ID) {
+    // first page id past the end with the right residue; the ones skipped become free pages of other residues
+    auto end = static_cast<uint32_t>(num_pages_);
+    page_id = static_cast<page_id_t>(end + (instance_index + num_instances - end % num_instances) % num_instances);
+    num_free_pages_ += page_id - num_pages_;
+    num_pages_ = page_id + 1;
+  } else {
+    num_free_pages_--;
+  }
+  SetAllocated(page_id, true);
+  return page_id;
+}
+
+bool FreeSpaceMap::DeallocatePage(page_id_t page_id) {
+  std::scoped_lock scoped_latch(latch_);
+  if (page_id < 0 || page_id >= num_pages_ || !IsSet(page_id)) {
+    return false;
+  }
+  SetAllocated(page_id, false);
+  num_free_pages_++;
+  free_hint_ = std::min(free_hint_, static_cast<size_t>(page_id) / 64);
+  return true;
+}
+
+/**
+ * Reserve EXTENT_SIZE contiguous pages, starting at a multiple of EXTENT_SIZE
+ * The reservation is not persistent: pages that are never allocated from it are free again after a restart
+ */
+page_id_t FreeSpaceMap::ReserveExtent() {
+  std::scoped_lock scoped_latch(latch_);
+  const size_t extent_words = EXTENT_SIZE / 64;
+  page_id_t start = INVALID_PAGE_ID;
+  // a completely free extent below the end, e.g. one left behind by a dropped table
+  if (num_free_pages_ >= EXTENT_SIZE) {
+    for (size_t word = 0; word + extent_words <= static_cast<size_t>(num_pages_) / 64; word += extent_words) {
+      bool is_free = true;
+      for (size_t i = word; i < word + extent_words && is_free; i++) {
+        is_free = (bits_[i] | reserved_[i]) == 0;
+      }
+      if (is_free) {
+        start = static_cast<page_id_t>(word * 64);
+        num_free_pages_ -= EXTENT_SIZE;
+        break;
+      }
+    }
+  }
+  if (start == INVALID_PAGE_ID) {
+    start = (num_pages_ + EXTENT_SIZE - 1) / EXTENT_SIZE * EXTENT_SIZE;
+    num_free_pages_ += start - num_pages_;
+    num_pages_ = start + EXTENT_SIZE;
+  }
+  Grow(start + EXTENT_SIZE - 1);
+  for (auto i = static_cast<size_t>(start) / 64; i < static_cast<size_t>(start + EXTENT_SIZE) / 64; i++) {
+    reserved_[i] = ~uint64_t{0};
+  }
+  return start;
+}
+
+void FreeSpaceMap::AllocateReservedPage(page_id_t page_id) {
+  std::scoped_lock scoped_latch(latch_);
+  BUSTUB_ASSERT(reserved_[page_id / 64] >> (page_id % 64) & 1, "page was not reserved");
+  reserved_[page_id / 64] &= ~(uint64_t{1} << (page_id % 64));
+  SetAllocated(page_id, true);
+}
+
+bool FreeSpaceMap::IsAllocated(page_id_t page_id) {
+  std::scoped_lock scoped_latch(latch_);
+  return page_id >= 0 && page_id < num_pages_ && IsSet(page_id);
+}
+
+int FreeSpaceMap::GetNumFreePages() {
+  std::scoped_lock scoped_latch(latch_);
+  return num_free_pages_;
+}
+
+void FreeSpaceMap::Load(const std::vector<char> &map_pages) {
+  std::scoped_lock scoped_latch(latch_);
+  size_t num_map_pages = map_pages.size() / PAGE_SIZE;
+  bits_.assign(num_map_pages * MAP_PAGE_WORDS, 0);
+  reserved_.assign(num_map_pages * MAP_PAGE_WORDS, 0);
+  memcpy(bits_.data(), map_pages.data(), num_map_pages * PAGE_SIZE);
+  dirty_map_pages_.clear();
+  free_hint_ = 0;
+
+  num_pages_ = 0;
+  int num_allocated = 0;
+  for (size_t word = 0; word < bits_.size(); word++) {
+    if (bits_[word] != 0) {
+      num_pages_ = static_cast<page_id_t>(word * 64 + 64 - __builtin_clzll(bits_[word]));
+      num_allocated += __builtin_popcountll(bits_[word]);
+    }
+  }
+  num_free_pages_ = num_pages_ - num_allocated;
+}
+
+void FreeSpaceMap::TakeDirtyMapPages(std::vector<size_t> *map_pages, std::vector<char> *data) {
+  std::scoped_lock scoped_latch(latch_);
+  map_pages->assign(dirty_map_pages_.begin(), dirty_map_pages_.end());
+  data->resize(map_pages->size() * PAGE_SIZE);
+  for (size_t i = 0; i < map_pages->size(); i++) {
+    memcpy(data->data() + i * PAGE_SIZE, &bits_[(*map_pages)[i] * MAP_PAGE_WORDS], PAGE_SIZE);
+  }
+  dirty_map_pages_.clear();
+}
+
+/**
+ * Private helper function to find the lowest free page with the given residue. Caller holds latch_.
+ */
+page_id_t FreeSpaceMap::FindFreePage(uint32_t num_instances, uint32_t instance_index) {
+  size_t num_words = (num_pages_ + 63) / 64;
+  bool all_full = true;
+  for (size_t word = free_hint_; word < num_words; word++) {
+    uint64_t free_bits = ~(bits_[word] | reserved_[word]);
+    if (free_bits == 0 && all_full) {
+      free_hint_ = word + 1;
+      continue;
+    }
+    all_full = false;
+    for (; free_bits != 0; free_bits &= free_bits - 1) {
+      auto page_id = static_cast<page_id_t>(word * 64 + __builtin_ctzll(free_bits));
+      if (page_id >= num_pages_) {
+        return INVALID_PAGE_ID;
+      }
+      if (static_cast<uint32_t>(page_id) % num_instances == instance_index) {
+        return page_id;
+      }
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+bool FreeSpaceMap::IsSet(page_id_t page_id) const { return (bits_[page_id / 64] >> (page_id % 64) & 1) != 0; }
+
+/**
+ * Private helper function to flip the bit of page_id and mark its map page dirty. Caller holds latch_.
+ */
+void FreeSpaceMap::SetAllocated(page_id_t page_id, bool allocated) {
+  Grow(page_id);
+  uint64_t bit = uint64_t{1} << (page_id % 64);
+  if (allocated) {
+    bits_[page_id / 64] |= bit;
+  } else {
+    bits_[page_id / 64] &= ~bit;
+  }
+  dirty_map_pages_.insert(page_id / MAP_PAGE_CAPACITY);
+}
+
+/**
+ * Private helper function to make the map cover page_id. Caller holds latch_.
+ */
+void FreeSpaceMap::Grow(page_id_t page_id) {
+  size_t num_words = (page_id / MAP_PAGE_CAPACITY + 1) * MAP_PAGE_WORDS;
+  if (bits_.size() < num_words) {
+    bits_.resize(num_words, 0);
+    reserved_.resize(num_words, 0);
+  }
+}
+
+}  // namespace bustub
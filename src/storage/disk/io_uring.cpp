@@ -0,0 +1,243 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// io_uring.cpp
+//
+// Identification: src/storage/disk/io_uring.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/io_uring.h"
+
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#define BUSTUB_HAS_IO_URING 1
+#endif
+
+#include "common/logger.h"
+
+namespace bustub {
+
+#ifdef BUSTUB_HAS_IO_URING
+
+namespace {
+
+template <typename T>
+T *RingField(void *ring, uint32_t offset) {
+  return reinterpret_cast<T *>(static_cast<char *>(ring) + offset);
+}
+
+}  // namespace
+
+IOUring::IOUring(uint32_t entries) : entries_(entries) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+  if (ring_fd < 0) {
+    LOG_DEBUG("io_uring is not available, falling back to synchronous I/O");
+    return;
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sq_ring_ =
+      mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+  if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+    cq_ring_ = sq_ring_;
+  } else if (sq_ring_ != MAP_FAILED) {
+    cq_ring_ =
+        mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void *sqes = MAP_FAILED;
+  if (sq_ring_ != MAP_FAILED && cq_ring_ != MAP_FAILED) {
+    sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+  }
+  if (sqes == MAP_FAILED) {
+    LOG_DEBUG("can't map io_uring, falling back to synchronous I/O");
+    if (cq_ring_ != sq_ring_ && cq_ring_ != nullptr && cq_ring_ != MAP_FAILED) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != MAP_FAILED) {
+      munmap(sq_ring_, sq_ring_size_);
+    }
+    sq_ring_ = cq_ring_ = nullptr;
+    close(ring_fd);
+    return;
+  }
+  sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+  sq_tail_ = RingField<unsigned>(sq_ring_, params.sq_off.tail);
+  sq_mask_ = RingField<unsigned>(sq_ring_, params.sq_off.ring_mask);
+  sq_array_ = RingField<unsigned>(sq_ring_, params.sq_off.array);
+  cq_head_ = RingField<unsigned>(cq_ring_, params.cq_off.head);
+  cq_tail_ = RingField<unsigned>(cq_ring_, params.cq_off.tail);
+  cq_mask_ = RingField<unsigned>(cq_ring_, params.cq_off.ring_mask);
+  cqes_ = RingField<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+  ring_fd_ = ring_fd;
+  completion_thread_ = std::thread(&IOUring::ReapCompletions, this);
+}
+
+IOUring::~IOUring() {
+  if (!IsAvailable()) {
+    return;
+  }
+  {
+    std::unique_lock<std::mutex> lock(latch_);
+    cv_.wait(lock, [&] { return in_flight_ == 0; });
+  }
+  {
+    // a no-op with user_data 0 tells the completion thread to exit
+    std::lock_guard<std::mutex> sq_lock(sq_latch_);
+    if (int error = Enqueue(IORING_OP_NOP, -1, nullptr, 0, 0, 0); error != 0) {
+      LOG_DEBUG("io_uring_enter failed: %s", strerror(error));
+    }
+  }
+  completion_thread_.join();
+  munmap(sqes_, sqes_size_);
+  if (cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  munmap(sq_ring_, sq_ring_size_);
+  close(ring_fd_);
+}
+
+bool IOUring::Submit(bool write, int fd, char *buf, uint32_t len, off_t offset, Callback callback) {
+  return SubmitRequest(write ? IORING_OP_WRITE : IORING_OP_READ, fd, buf, len, offset, std::move(callback));
+}
+
+bool IOUring::SubmitVectored(bool write, int fd, const iovec *iov, uint32_t iovcnt, off_t offset, Callback callback) {
+  return SubmitRequest(write ? IORING_OP_WRITEV : IORING_OP_READV, fd, iov, iovcnt, offset, std::move(callback));
+}
+
+bool IOUring::SubmitRequest(uint8_t opcode, int fd, const void *addr, uint32_t len, off_t offset, Callback callback) {
+  if (!IsAvailable()) {
+    return false;
+  }
+  {
+    std::unique_lock<std::mutex> lock(latch_);
+    cv_.wait(lock, [&] { return in_flight_ < entries_; });
+    in_flight_++;
+  }
+  auto *request = new Callback(std::move(callback));
+  int error;
+  {
+    std::lock_guard<std::mutex> sq_lock(sq_latch_);
+    error = Enqueue(opcode, fd, addr, len, offset, reinterpret_cast<uint64_t>(request));
+  }
+  if (error == 0) {
+    return true;
+  }
+  // the kernel never saw the request, give back its slot and let the caller do the I/O itself
+  LOG_DEBUG("io_uring_enter failed: %s", strerror(error));
+  delete request;
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    in_flight_--;
+  }
+  cv_.notify_all();
+  return false;
+}
+
+int IOUring::Enqueue(uint8_t opcode, int fd, const void *addr, uint32_t len, off_t offset, uint64_t user_data) {
+  unsigned tail = *sq_tail_;
+  unsigned index = tail & *sq_mask_;
+  io_uring_sqe *sqe = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = opcode;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(addr);
+  sqe->len = len;
+  sqe->off = static_cast<uint64_t>(offset);
+  sqe->user_data = user_data;
+  sq_array_[index] = index;
+  // the kernel must see the filled sqe before the new tail
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  while (syscall(__NR_io_uring_enter, ring_fd_, 1, 0, 0, nullptr, 0) < 0) {
+    if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      // nothing was consumed, take the sqe back out of the ring
+      int error = errno;
+      __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+      return error;
+    }
+  }
+  return 0;
+}
+
+void IOUring::ReapCompletions() {
+  while (true) {
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+      syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+      continue;
+    }
+    bool stop = false;
+    uint32_t num_completed = 0;
+    for (; head != tail; head++) {
+      const io_uring_cqe &cqe = static_cast<io_uring_cqe *>(cqes_)[head & *cq_mask_];
+      if (cqe.user_data == 0) {
+        stop = true;
+        continue;
+      }
+      auto *request = reinterpret_cast<Callback *>(cqe.user_data);
+      (*request)(cqe.res);
+      delete request;
+      num_completed++;
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    if (num_completed > 0) {
+      std::lock_guard<std::mutex> lock(latch_);
+      in_flight_ -= num_completed;
+      cv_.notify_all();
+    }
+    if (stop) {
+      return;
+    }
+  }
+}
+
+#else
+
+IOUring::IOUring(uint32_t entries) : entries_(entries) {}
+
+IOUring::~IOUring() = default;
+
+bool IOUring::Submit(bool /*write*/, int /*fd*/, char * /*buf*/, uint32_t /*len*/, off_t /*offset*/,
+                     Callback /*callback*/) {
+  return false;
+}
+
+bool IOUring::SubmitVectored(bool /*write*/, int /*fd*/, const iovec * /*iov*/, uint32_t /*iovcnt*/, off_t /*offset*/,
+                             Callback /*callback*/) {
+  return false;
+}
+
+bool IOUring::SubmitRequest(uint8_t /*opcode*/, int /*fd*/, const void * /*addr*/, uint32_t /*len*/, off_t /*offset*/,
+                            Callback /*callback*/) {
+  return false;
+}
+
+int IOUring::Enqueue(uint8_t /*opcode*/, int /*fd*/, const void * /*addr*/, uint32_t /*len*/, off_t /*offset*/,
+                     uint64_t /*user_data*/) {
+  return ENOSYS;
+}
+
+void IOUring::ReapCompletions() {}
+
+#endif
+
+}  // namespace bustub
@@ -0,0 +1,217 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// latency_disk_manager.cpp
+//
+// Identification: src/storage/disk/latency_disk_manager.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/latency_disk_manager.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace bustub {
+
+namespace {
+
+/** The timer thread sleeps until this long before a deadline and spins from there on. */
+constexpr std::chrono::microseconds SPIN_THRESHOLD(100);
+
+constexpr uint64_t MB = 1000 * 1000;
+
+}  // namespace
+
+DeviceProfile DeviceProfile::Hdd() {
+  using std::chrono::microseconds;
+  return {microseconds(8000), microseconds(8000), microseconds(12000), 160 * MB, 1};
+}
+
+DeviceProfile DeviceProfile::SataSsd() {
+  using std::chrono::microseconds;
+  return {microseconds(100), microseconds(60), microseconds(1000), 530 * MB, 32};
+}
+
+DeviceProfile DeviceProfile::Nvme() {
+  using std::chrono::microseconds;
+  return {microseconds(80), microseconds(20), microseconds(200), 3000 * MB, 128};
+}
+
+LatencyDiskManager::LatencyDiskManager(std::unique_ptr<DiskManager> disk_manager, const DeviceProfile &profile)
+    : disk_manager_(std::move(disk_manager)),
+      profile_(profile),
+      slot_free_at_(std::max<uint32_t>(profile.queue_depth_, 1)),
+      timer_thread_(&LatencyDiskManager::DeliverCompletions, this) {}
+
+LatencyDiskManager::~LatencyDiskManager() {
+  {
+    std::scoped_lock lock(latch_);
+    shutdown_ = true;
+  }
+  cv_.notify_all();
+  timer_thread_.join();
+}
+
+void LatencyDiskManager::ShutDown() { disk_manager_->ShutDown(); }
+
+std::future<void> LatencyDiskManager::WritePageAsync(page_id_t page_id, const char *page_data) {
+  auto deadline = Schedule(PAGE_SIZE, profile_.write_latency_);
+  return Complete(disk_manager_->WritePageAsync(page_id, page_data), deadline);
+}
+
+/**
+ * A vectored write pays the latency once, and the transfer of all its pages
+ */
+std::future<void> LatencyDiskManager::WritePagesAsync(page_id_t first_page_id, const std::vector<const char *> &pages) {
+  auto deadline = Schedule(static_cast<uint64_t>(PAGE_SIZE) * pages.size(), profile_.write_latency_);
+  return Complete(disk_manager_->WritePagesAsync(first_page_id, pages), deadline);
+}
+
+std::future<void> LatencyDiskManager::ReadPageAsync(page_id_t page_id, char *page_data) {
+  auto deadline = Schedule(PAGE_SIZE, profile_.read_latency_);
+  return Complete(disk_manager_->ReadPageAsync(page_id, page_data), deadline);
+}
+
+std::future<void> LatencyDiskManager::ReadPagesAsync(page_id_t first_page_id, const std::vector<char *> &pages) {
+  auto deadline = Schedule(static_cast<uint64_t>(PAGE_SIZE) * pages.size(), profile_.read_latency_);
+  return Complete(disk_manager_->ReadPagesAsync(first_page_id, pages), deadline);
+}
+
+bool LatencyDiskManager::IsAdjacent(page_id_t page_id, page_id_t next) const {
+  return disk_manager_->IsAdjacent(page_id, next);
+}
+
+/**
+ * A sync waits for every request booked before it and keeps the whole device busy until it is done
+ */
+void LatencyDiskManager::SyncDB() {
+  Clock::time_point deadline;
+  {
+    std::scoped_lock lock(latch_);
+    deadline = std::max(Clock::now(), bus_free_at_);
+    for (const auto &free_at : slot_free_at_) {
+      deadline = std::max(deadline, free_at);
+    }
+    deadline += profile_.sync_latency_;
+    std::fill(slot_free_at_.begin(), slot_free_at_.end(), deadline);
+    bus_free_at_ = deadline;
+  }
+  disk_manager_->SyncDB();
+  std::promise<void> done;
+  std::future<void> io = done.get_future();
+  done.set_value();
+  Complete(std::move(io), deadline).wait();
+}
+
+void LatencyDiskManager::WriteLog(char *log_data, int size) {
+  auto deadline = Schedule(size, profile_.write_latency_);
+  disk_manager_->WriteLog(log_data, size);
+  std::promise<void> done;
+  std::future<void> io = done.get_future();
+  done.set_value();
+  Complete(std::move(io), deadline).wait();
+}
+
+bool LatencyDiskManager::ReadLog(char *log_data, int size, int offset) {
+  return disk_manager_->ReadLog(log_data, size, offset);
+}
+
+void LatencyDiskManager::WriteResidentPages(const std::vector<page_id_t> &page_ids) {
+  disk_manager_->WriteResidentPages(page_ids);
+}
+
+std::vector<page_id_t> LatencyDiskManager::ReadResidentPages() { return disk_manager_->ReadResidentPages(); }
+
+page_id_t LatencyDiskManager::AllocatePage(uint32_t num_instances, uint32_t instance_index) {
+  return disk_manager_->AllocatePage(num_instances, instance_index);
+}
+
+void LatencyDiskManager::DeallocatePage(page_id_t page_id) { disk_manager_->DeallocatePage(page_id); }
+
+bool LatencyDiskManager::IsPageAllocated(page_id_t page_id) { return disk_manager_->IsPageAllocated(page_id); }
+
+page_id_t LatencyDiskManager::ReserveExtent() { return disk_manager_->ReserveExtent(); }
+
+void LatencyDiskManager::AllocateReservedPage(page_id_t page_id) { disk_manager_->AllocateReservedPage(page_id); }
+
+int LatencyDiskManager::GetNumFreePages() { return disk_manager_->GetNumFreePages(); }
+
+int LatencyDiskManager::GetNumFlushes() const { return disk_manager_->GetNumFlushes(); }
+
+bool LatencyDiskManager::GetFlushState() const { return disk_manager_->GetFlushState(); }
+
+int LatencyDiskManager::GetNumWrites() const { return disk_manager_->GetNumWrites(); }
+
+int LatencyDiskManager::GetNumReads() const { return disk_manager_->GetNumReads(); }
+
+bool LatencyDiskManager::IsDirectIO() const { return disk_manager_->IsDirectIO(); }
+
+void LatencyDiskManager::SetFlushLogFuture(std::future<void> *f) { disk_manager_->SetFlushLogFuture(f); }
+
+bool LatencyDiskManager::HasFlushLogFuture() { return disk_manager_->HasFlushLogFuture(); }
+
+/**
+ * The request takes the queue slot that frees up first. Its latency runs from when it gets the slot, and it is done
+ * when both the latency has passed and its bytes went over the bus after everything booked before.
+ */
+LatencyDiskManager::Clock::time_point LatencyDiskManager::Schedule(uint64_t num_bytes,
+                                                                   std::chrono::microseconds latency) {
+  auto transfer = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(static_cast<double>(num_bytes) / static_cast<double>(profile_.bandwidth_)));
+  std::scoped_lock lock(latch_);
+  auto now = Clock::now();
+  auto slot = std::min_element(slot_free_at_.begin(), slot_free_at_.end());
+  auto start = std::max(now, *slot);
+  bus_free_at_ = std::max(start, bus_free_at_) + transfer;
+  auto deadline = std::max(start + std::chrono::duration_cast<Clock::duration>(latency), bus_free_at_);
+  *slot = deadline;
+  return deadline;
+}
+
+std::future<void> LatencyDiskManager::Complete(std::future<void> io, Clock::time_point deadline) {
+  auto done = std::make_shared<std::promise<void>>();
+  std::future<void> future = done->get_future();
+  {
+    std::scoped_lock lock(latch_);
+    pending_.emplace(deadline, Completion{std::move(io), std::move(done)});
+  }
+  cv_.notify_all();
+  return future;
+}
+
+void LatencyDiskManager::DeliverCompletions() {
+  std::unique_lock lock(latch_);
+  while (true) {
+    if (pending_.empty()) {
+      if (shutdown_) {
+        return;
+      }
+      cv_.wait(lock);
+      continue;
+    }
+    auto deadline = pending_.begin()->first;
+    auto remaining = deadline - Clock::now();
+    if (remaining > SPIN_THRESHOLD) {
+      cv_.wait_until(lock, deadline - SPIN_THRESHOLD);
+      continue;
+    }
+    if (remaining > Clock::duration::zero()) {
+      lock.unlock();
+      std::this_thread::yield();
+      lock.lock();
+      continue;
+    }
+    Completion completion = std::move(pending_.begin()->second);
+    pending_.erase(pending_.begin());
+    lock.unlock();
+    completion.io_.wait();
+    completion.done_->set_value();
+    lock.lock();
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,151 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// memory_disk_manager.cpp
+//
+// Identification: src/storage/disk/memory_disk_manager.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/memory_disk_manager.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace bustub {
+
+namespace {
+
+std::future<void> MakeReadyFuture() {
+  std::promise<void> done;
+  done.set_value();
+  return done.get_future();
+}
+
+}  // namespace
+
+std::future<void> MemoryDiskManager::WritePageAsync(page_id_t page_id, const char *page_data) {
+  num_writes_ += 1;
+  memcpy(GetPageData(page_id, true), page_data, PAGE_SIZE);
+  return MakeReadyFuture();
+}
+
+std::future<void> MemoryDiskManager::WritePagesAsync(page_id_t first_page_id, const std::vector<const char *> &pages) {
+  num_writes_ += static_cast<int>(pages.size());
+  for (size_t i = 0; i < pages.size(); i++) {
+    memcpy(GetPageData(first_page_id + static_cast<page_id_t>(i), true), pages[i], PAGE_SIZE);
+  }
+  return MakeReadyFuture();
+}
+
+/**
+ * Pages that were never written read as zeros, like the holes of a file
+ */
+std::future<void> MemoryDiskManager::ReadPageAsync(page_id_t page_id, char *page_data) {
+  num_reads_ += 1;
+  const char *data = GetPageData(page_id, false);
+  if (data != nullptr) {
+    memcpy(page_data, data, PAGE_SIZE);
+  } else {
+    memset(page_data, 0, PAGE_SIZE);
+  }
+  return MakeReadyFuture();
+}
+
+std::future<void> MemoryDiskManager::ReadPagesAsync(page_id_t first_page_id, const std::vector<char *> &pages) {
+  for (size_t i = 0; i < pages.size(); i++) {
+    ReadPageAsync(first_page_id + static_cast<page_id_t>(i), pages[i]);
+  }
+  return MakeReadyFuture();
+}
+
+void MemoryDiskManager::WriteLog(char *log_data, int size) {
+  if (size == 0) {  // no effect on num_flushes_ if log buffer is empty
+    return;
+  }
+  std::scoped_lock scoped_log_latch(log_latch_);
+  num_flushes_ += 1;
+  log_.append(log_data, size);
+}
+
+bool MemoryDiskManager::ReadLog(char *log_data, int size, int offset) {
+  std::scoped_lock scoped_log_latch(log_latch_);
+  if (offset < 0 || static_cast<size_t>(offset) >= log_.size()) {
+    return false;
+  }
+  size_t read_count = std::min(log_.size() - offset, static_cast<size_t>(size));
+  memcpy(log_data, log_.data() + offset, read_count);
+  memset(log_data + read_count, 0, size - read_count);
+  return true;
+}
+
+void MemoryDiskManager::WriteResidentPages(const std::vector<page_id_t> &page_ids) {
+  std::scoped_lock scoped_log_latch(log_latch_);
+  resident_pages_ = page_ids;
+}
+
+std::vector<page_id_t> MemoryDiskManager::ReadResidentPages() {
+  std::vector<page_id_t> page_ids;
+  {
+    std::scoped_lock scoped_log_latch(log_latch_);
+    page_ids = resident_pages_;
+  }
+  page_ids.erase(std::remove_if(page_ids.begin(), page_ids.end(),
+                                [&](page_id_t page_id) { return !fsm_.IsAllocated(page_id); }),
+                 page_ids.end());
+  return page_ids;
+}
+
+page_id_t MemoryDiskManager::AllocatePage(uint32_t num_instances, uint32_t instance_index) {
+  return fsm_.AllocatePage(num_instances, instance_index);
+}
+
+void MemoryDiskManager::DeallocatePage(page_id_t page_id) {
+  if (!fsm_.DeallocatePage(page_id)) {
+    return;
+  }
+  std::unique_lock lock(latch_);
+  if (page_id >= 0 && static_cast<size_t>(page_id) < pages_.size()) {
+    pages_[page_id].reset();
+  }
+}
+
+bool MemoryDiskManager::IsPageAllocated(page_id_t page_id) { return fsm_.IsAllocated(page_id); }
+
+page_id_t MemoryDiskManager::ReserveExtent() { return fsm_.ReserveExtent(); }
+
+void MemoryDiskManager::AllocateReservedPage(page_id_t page_id) { fsm_.AllocateReservedPage(page_id); }
+
+int MemoryDiskManager::GetNumFreePages() { return fsm_.GetNumFreePages(); }
+
+int MemoryDiskManager::GetNumFlushes() const { return num_flushes_; }
+
+int MemoryDiskManager::GetNumWrites() const { return num_writes_; }
+
+int MemoryDiskManager::GetNumReads() const { return num_reads_; }
+
+char *MemoryDiskManager::GetPageData(page_id_t page_id, bool create) {
+  auto index = static_cast<size_t>(page_id);
+  {
+    std::shared_lock lock(latch_);
+    if (index < pages_.size() && pages_[index] != nullptr) {
+      return pages_[index].get();
+    }
+  }
+  if (!create) {
+    return nullptr;
+  }
+  std::unique_lock lock(latch_);
+  if (index >= pages_.size()) {
+    pages_.resize(std::max(index + 1, pages_.size() * 2));
+  }
+  if (pages_[index] == nullptr) {
+    pages_[index] = std::make_unique<char[]>(PAGE_SIZE);
+  }
+  return pages_[index].get();
+}
+
+}  // namespace bustub
@@ -0,0 +1,28 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_segment.cpp
+//
+// Identification: src/storage/disk/page_segment.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/page_segment.h"
+
+namespace bustub {
+
+page_id_t PageSegment::AllocatePage(DiskManager *disk_manager) {
+  std::lock_guard<std::mutex> lock(latch_);
+  if (next_page_id_ == extent_end_) {
+    next_page_id_ = disk_manager->ReserveExtent();
+    extent_end_ = next_page_id_ + EXTENT_SIZE;
+  }
+  page_id_t page_id = next_page_id_++;
+  disk_manager->AllocateReservedPage(page_id);
+  return page_id;
+}
+
+}  // namespace bustub
@@ -10,6 +10,7 @@
 //===----------------------------------------------------------------------===//
 
 #include <string>
+#include <thread>  // NOLINT
 
 #include "common/exception.h"
 #include "common/rid.h"
@@ -209,10 +210,57 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::End() { return INDEXITERATOR_TYPE(); }
 /*
  * Find leaf page containing particular key, if leftMost flag == true, find
  * the left most leaf page
+ * Internal pages are read optimistically: the child id is only followed once
+ * the page version shows it was not changed in the meantime, and the parent is
+ * validated again once the child is pinned, so that a concurrent split or merge
+ * restarts the descent from the root. The leaf is returned pinned but not
+ * latched.
  */
 INDEX_TEMPLATE_ARGUMENTS
 Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) {
-  throw Exception(ExceptionType::NOT_IMPLEMENTED, "Implement this for test");
+  while (true) {
+    page_id_t root_page_id = root_page_id_;
+    if (root_page_id == INVALID_PAGE_ID) {
+      return nullptr;
+    }
+    Page *page = buffer_pool_manager_->FetchPage(root_page_id);
+    if (page == nullptr) {
+      return nullptr;
+    }
+    while (true) {
+      uint64_t version;
+      if (!page->TryOptimisticRead(&version)) {
+        break;
+      }
+      auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+      bool is_leaf = node->IsLeafPage();
+      page_id_t child_page_id = INVALID_PAGE_ID;
+      if (!is_leaf) {
+        auto internal = reinterpret_cast<InternalPage *>(node);
+        child_page_id = leftMost ? internal->ValueAt(0) : internal->Lookup(key, comparator_);
+      }
+      if (!page->ValidateRead(version)) {
+        break;
+      }
+      if (is_leaf) {
+        return page;
+      }
+      Page *child = buffer_pool_manager_->FetchPage(child_page_id);
+      bool valid = page->ValidateRead(version);
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      page = child;
+      if (!valid) {
+        break;
+      }
+      if (page == nullptr) {
+        return nullptr;
+      }
+    }
+    if (page != nullptr) {
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    }
+    std::this_thread::yield();
+  }
 }
 
 /*
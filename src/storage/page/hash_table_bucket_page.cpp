@@ -11,6 +11,13 @@
 //===----------------------------------------------------------------------===//
 
 #include "storage/page/hash_table_bucket_page.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 #include "common/logger.h"
 #include "common/util/hash_util.h"
 #include "storage/index/generic_key.h"
@@ -21,61 +28,62 @@ namespace bustub {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BUCKET_TYPE::GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result) {
-  for(size_t bucket_idx = 0; bucket_idx < BUCKET_ARRAY_SIZE; bucket_idx++){
-    if(!IsOccupied(bucket_idx)){
-      break;
-    }
-    if(IsReadable(bucket_idx) && cmp(key,KeyAt(bucket_idx))==0 ){
-      (*result).push_back(array_[bucket_idx].second);
+  uint8_t fingerprint = Fingerprint(key);
+  uint32_t size = GetOccupiedSize();
+  for (uint32_t first_idx = 0; first_idx < size; first_idx += 64) {
+    uint64_t candidates = MatchFingerprints(first_idx, fingerprint) & BitmapWord(readable_, first_idx / 64);
+    for (; candidates != 0; candidates &= candidates - 1) {
+      uint32_t bucket_idx = first_idx + __builtin_ctzll(candidates);
+      if (cmp(key, array_[bucket_idx].first) == 0) {
+        result->push_back(array_[bucket_idx].second);
+      }
     }
   }
-  return (*result).size()>0;
+  return !result->empty();
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BUCKET_TYPE::Insert(KeyType key, ValueType value, KeyComparator cmp) {
-  std::vector<uint32_t> available_bucket_idx;
-  uint32_t bucket_idx =0;
-  // if exist
-  for( ; bucket_idx< BUCKET_ARRAY_SIZE; bucket_idx++){
-    if(!IsOccupied(bucket_idx)){
-      break;
-    }
-    if(IsReadable(bucket_idx)){
-      if( cmp(key, KeyAt(bucket_idx))==0 && value == ValueAt(bucket_idx) ){
+  uint8_t fingerprint = Fingerprint(key);
+  uint32_t size = GetOccupiedSize();
+  // the first tombstone, or the first slot that was never occupied if there is none
+  uint32_t avail_idx = size;
+  for (uint32_t first_idx = 0; first_idx < size; first_idx += 64) {
+    uint64_t readable = BitmapWord(readable_, first_idx / 64);
+    uint64_t candidates = MatchFingerprints(first_idx, fingerprint) & readable;
+    for (; candidates != 0; candidates &= candidates - 1) {
+      uint32_t bucket_idx = first_idx + __builtin_ctzll(candidates);
+      if (cmp(key, array_[bucket_idx].first) == 0 && value == array_[bucket_idx].second) {
         return false;
       }
-    }else{
-      available_bucket_idx.push_back(bucket_idx);
     }
-  }
-
-  uint32_t avail_idx;
-  if(available_bucket_idx.size()>0){
-    avail_idx = available_bucket_idx[0];
-  }else{
-    if(bucket_idx >= BUCKET_ARRAY_SIZE){
-      // full
-      return false;
-    }else{
-      avail_idx = bucket_idx;
-      SetOccupied(avail_idx);
+    if (avail_idx == size && readable != ~uint64_t{0}) {
+      avail_idx = std::min(size, first_idx + __builtin_ctzll(~readable));
     }
   }
+  if (avail_idx >= BUCKET_ARRAY_SIZE) {
+    // full
+    return false;
+  }
+  if (avail_idx == size) {
+    SetOccupied(avail_idx);
+  }
   array_[avail_idx].first = key;
   array_[avail_idx].second = value;
+  fingerprints_[avail_idx] = fingerprint;
   SetReadable(avail_idx);
   return true;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BUCKET_TYPE::Remove(KeyType key, ValueType value, KeyComparator cmp) {
-  for(uint32_t bucket_idx = 0; bucket_idx < BUCKET_ARRAY_SIZE; bucket_idx++){
-    if(!IsOccupied(bucket_idx)){
-      break;
-    }
-    if(IsReadable(bucket_idx)){
-      if( cmp(key,KeyAt(bucket_idx))==0 && value==ValueAt(bucket_idx) ){
+  uint8_t fingerprint = Fingerprint(key);
+  uint32_t size = GetOccupiedSize();
+  for (uint32_t first_idx = 0; first_idx < size; first_idx += 64) {
+    uint64_t candidates = MatchFingerprints(first_idx, fingerprint) & BitmapWord(readable_, first_idx / 64);
+    for (; candidates != 0; candidates &= candidates - 1) {
+      uint32_t bucket_idx = first_idx + __builtin_ctzll(candidates);
+      if (cmp(key, array_[bucket_idx].first) == 0 && value == array_[bucket_idx].second) {
         RemoveAt(bucket_idx);
         return true;
       }
@@ -84,6 +92,56 @@ bool HASH_TABLE_BUCKET_TYPE::Remove(KeyType key, ValueType value, KeyComparator
   return false;
 }
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint8_t HASH_TABLE_BUCKET_TYPE::Fingerprint(const KeyType &key) {
+  hash_t hash = HashUtil::HashBytes(reinterpret_cast<const char *>(&key), sizeof(KeyType));
+  // HashBytes leaves the low bits of short keys poorly mixed, so multiply before taking the top byte
+  return static_cast<uint8_t>((hash * 0x9E3779B97F4A7C15ULL) >> 56);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint64_t HASH_TABLE_BUCKET_TYPE::MatchFingerprints(uint32_t first_idx, uint8_t fingerprint) const {
+  uint32_t end_idx = std::min<uint32_t>(first_idx + 64, BUCKET_ARRAY_SIZE);
+  uint64_t matches = 0;
+  uint32_t idx = first_idx;
+#if defined(__AVX2__)
+  const __m256i needle32 = _mm256_set1_epi8(static_cast<char>(fingerprint));
+  for (; idx + 32 <= end_idx; idx += 32) {
+    __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(fingerprints_ + idx));
+    auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle32)));
+    matches |= static_cast<uint64_t>(mask) << (idx - first_idx);
+  }
+#endif
+#if defined(__SSE2__)
+  const __m128i needle16 = _mm_set1_epi8(static_cast<char>(fingerprint));
+  for (; idx + 16 <= end_idx; idx += 16) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(fingerprints_ + idx));
+    auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle16)));
+    matches |= static_cast<uint64_t>(mask) << (idx - first_idx);
+  }
+#endif
+  // the tail of the bucket, or all of it without SIMD
+  for (; idx < end_idx; idx++) {
+    if (fingerprints_[idx] == fingerprint) {
+      matches |= uint64_t{1} << (idx - first_idx);
+    }
+  }
+  return matches;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+uint64_t HASH_TABLE_BUCKET_TYPE::BitmapWord(const char *bitmap, uint32_t word_idx) {
+  // bit i of byte j is slot 8 * j + i, so the bytes are assembled little-endian
+  constexpr uint32_t bitmap_size = (BUCKET_ARRAY_SIZE - 1) / 8 + 1;
+  uint32_t first_byte = word_idx * 8;
+  uint32_t num_bytes = std::min<uint32_t>(8, bitmap_size - first_byte);
+  uint64_t word = 0;
+  for (uint32_t i = 0; i < num_bytes; i++) {
+    word |= static_cast<uint64_t>(static_cast<uint8_t>(bitmap[first_byte + i])) << (8 * i);
+  }
+  return word;
+}
+
 template <typename KeyType, typename ValueType, typename KeyComparator>
 KeyType HASH_TABLE_BUCKET_TYPE::KeyAt(uint32_t bucket_idx) const {
   return array_[bucket_idx].first;
@@ -106,14 +164,14 @@ bool HASH_TABLE_BUCKET_TYPE::IsOccupied(uint32_t bucket_idx) const {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 uint32_t HASH_TABLE_BUCKET_TYPE::GetOccupiedSize() const{
-  uint32_t size = 0;
-  for (uint32_t bucket_idx = 0; bucket_idx < BUCKET_ARRAY_SIZE; bucket_idx++){
-    if(!IsOccupied(bucket_idx)){
-      break;
+  // slots are occupied in order, so this is the number of leading ones of occupied_
+  for (uint32_t first_idx = 0; first_idx < BUCKET_ARRAY_SIZE; first_idx += 64) {
+    uint64_t occupied = BitmapWord(occupied_, first_idx / 64);
+    if (occupied != ~uint64_t{0}) {
+      return std::min<uint32_t>(BUCKET_ARRAY_SIZE, first_idx + __builtin_ctzll(~occupied));
     }
-    size++;
   }
-  return size;
+  return BUCKET_ARRAY_SIZE;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
@@ -133,38 +191,22 @@ void HASH_TABLE_BUCKET_TYPE::SetReadable(uint32_t bucket_idx) {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BUCKET_TYPE::IsFull() {
-  for(uint32_t bucket_idx = 0; bucket_idx < BUCKET_ARRAY_SIZE; bucket_idx++){
-    if(!IsOccupied(bucket_idx)){
-      return false;
-    }
-    if(!IsReadable(bucket_idx)){
-      return false;
-    }
-  }
-  return true;
+  return NumReadable() == BUCKET_ARRAY_SIZE;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 uint32_t HASH_TABLE_BUCKET_TYPE::NumReadable() {
   uint32_t size = 0;
-  for (uint32_t bucket_idx = 0; bucket_idx < BUCKET_ARRAY_SIZE; bucket_idx++){
-    if(!IsOccupied(bucket_idx)){
-      break;
-    }
-    if(IsReadable(bucket_idx)){
-      size++;
-    }
+  for (uint32_t first_idx = 0; first_idx < BUCKET_ARRAY_SIZE; first_idx += 64) {
+    size += __builtin_popcountll(BitmapWord(readable_, first_idx / 64));
   }
   return size;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BUCKET_TYPE::IsEmpty() {
-  for (uint32_t bucket_idx = 0; bucket_idx < BUCKET_ARRAY_SIZE; bucket_idx++){
-    if(!IsOccupied(bucket_idx)){
-      break;
-    }
-    if(IsReadable(bucket_idx)){
+  for (uint32_t first_idx = 0; first_idx < BUCKET_ARRAY_SIZE; first_idx += 64) {
+    if (BitmapWord(readable_, first_idx / 64) != 0) {
       return false;
     }
   }
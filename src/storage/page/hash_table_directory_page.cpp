@@ -77,6 +77,16 @@ void HashTableDirectoryPage::DecrLocalDepth(uint32_t bucket_idx) {
   local_depths_[bucket_idx]--;
 }
 
+uint32_t HashTableDirectoryPage::GetHeaderDepth(uint32_t bucket_idx) { return header_depths_[bucket_idx]; }
+
+void HashTableDirectoryPage::SetHeaderDepth(uint32_t bucket_idx, uint8_t header_depth) {
+  header_depths_[bucket_idx] = header_depth;
+}
+
+void HashTableDirectoryPage::IncrHeaderDepth(uint32_t bucket_idx) { header_depths_[bucket_idx]++; }
+
+void HashTableDirectoryPage::DecrHeaderDepth(uint32_t bucket_idx) { header_depths_[bucket_idx]--; }
+
 uint32_t HashTableDirectoryPage::GetLocalHighBit(uint32_t bucket_idx) { 
   return bucket_idx & (0x1 << GetLocalDepth(bucket_idx)); 
 }
@@ -19,7 +19,12 @@ namespace bustub {
 TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
     : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
-    table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
+    UseRingIfLarge(table_heap_->GetNumPages());
+    ReadPageGuard guard = FetchPageRead(rid.GetPageId());
+    auto page = static_cast<TablePage *>(guard.GetPage());
+    page->GetTuple(tuple_->rid_, tuple_, txn_, table_heap_->lock_manager_);
+    pages_scanned_++;
+    Readahead(page);
   }
 }
 
@@ -35,19 +40,21 @@ Tuple *TableIterator::operator->() {
 
 TableIterator &TableIterator::operator++() {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
-  cur_page->RLatch();
+  ReadPageGuard cur_guard = FetchPageRead(tuple_->rid_.GetPageId());
+  auto cur_page = static_cast<TablePage *>(cur_guard.GetPage());
   assert(cur_page != nullptr);  // all pages are pinned
 
   RID next_tuple_rid;
   if (!cur_page->GetNextTupleRid(tuple_->rid_,
                                  &next_tuple_rid)) {  // end of this page
     while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
-      cur_page->RUnlatch();
-      buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
-      cur_page = next_page;
-      cur_page->RLatch();
+      UseRingIfLarge(++pages_scanned_);
+      Page *next_page = FetchPage(cur_page->GetNextPageId());
+      cur_guard.Drop();
+      next_page->RLatch();
+      cur_guard = ReadPageGuard(buffer_pool_manager, next_page);
+      cur_page = static_cast<TablePage *>(next_page);
+      Readahead(cur_page);
       if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
         break;
       }
@@ -55,15 +62,68 @@ TableIterator &TableIterator::operator++() {
   }
   tuple_->rid_ = next_tuple_rid;
 
+  // the tuple is on the page that is already latched, TableHeap::GetTuple() would latch it a second time
   if (*this != table_heap_->End()) {
-    table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
+    cur_page->GetTuple(tuple_->rid_, tuple_, txn_, table_heap_->lock_manager_);
   }
-  // release until copy the tuple
-  cur_page->RUnlatch();
-  buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
+  // cur_guard releases the page once the tuple is copied
   return *this;
 }
 
+void TableIterator::Readahead(TablePage *page) {
+  BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
+  if (readahead_pages_ > 0) {
+    readahead_pages_--;
+  } else {
+    readahead_page_id_ = page->GetTablePageId();
+  }
+  while (readahead_pages_ < TABLE_READAHEAD_PAGES) {
+    page_id_t next_page_id;
+    if (readahead_page_id_ == page->GetTablePageId()) {
+      next_page_id = page->GetNextPageId();
+    } else {
+      // The end of the window must be resident to learn its successor, fetching it then is a cheap hit.
+      if (!buffer_pool_manager->PrefetchPage(readahead_page_id_)) {
+        return;
+      }
+      ReadPageGuard frontier = FetchPageRead(readahead_page_id_);
+      if (!frontier) {
+        return;
+      }
+      next_page_id = static_cast<TablePage *>(frontier.GetPage())->GetNextPageId();
+    }
+    if (next_page_id == INVALID_PAGE_ID) {
+      return;
+    }
+    buffer_pool_manager->PrefetchPage(next_page_id);
+    readahead_page_id_ = next_page_id;
+    readahead_pages_++;
+  }
+}
+
+Page *TableIterator::FetchPage(page_id_t page_id) {
+  BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
+  if (ring_ == nullptr) {
+    return buffer_pool_manager->FetchPage(page_id);
+  }
+  return buffer_pool_manager->FetchPageInRing(page_id, ring_.get());
+}
+
+ReadPageGuard TableIterator::FetchPageRead(page_id_t page_id) {
+  Page *page = FetchPage(page_id);
+  if (page != nullptr) {
+    page->RLatch();
+  }
+  return {table_heap_->buffer_pool_manager_, page};
+}
+
+void TableIterator::UseRingIfLarge(uint32_t num_pages) {
+  if (ring_ == nullptr &&
+      num_pages > table_heap_->buffer_pool_manager_->GetPoolSize() * BUFFER_RING_THRESHOLD_PERCENT / 100) {
+    ring_ = std::make_shared<BufferRing>();
+  }
+}
+
 TableIterator TableIterator::operator++(int) {
   TableIterator clone(*this);
   ++(*this);
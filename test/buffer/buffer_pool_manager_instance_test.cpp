@@ -11,11 +11,17 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/buffer_pool_manager_instance.h"
+#include <algorithm>
+#include <chrono>  // NOLINT
 #include <cstdio>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
+#include "storage/disk/disk_backend.h"
+#include "storage/disk/file_disk_manager.h"
 
 namespace bustub {
 
@@ -29,7 +35,7 @@ TEST(BufferPoolManagerInstanceTest, BinaryDataTest) {
   std::default_random_engine rng(r());
   std::uniform_int_distribution<char> uniform_dist(0);
 
-  auto *disk_manager = new DiskManager(db_name);
+  auto *disk_manager = CreateDiskManager(db_name).release();
   auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
 
   page_id_t page_id_temp;
@@ -90,7 +96,7 @@ TEST(BufferPoolManagerInstanceTest, SampleTest) {
   const std::string db_name = "test.db";
   const size_t buffer_pool_size = 10;
 
-  auto *disk_manager = new DiskManager(db_name);
+  auto *disk_manager = CreateDiskManager(db_name).release();
   auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
 
   page_id_t page_id_temp;
@@ -141,4 +147,604 @@ TEST(BufferPoolManagerInstanceTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+// Threads fetching overlapping pages through a pool much smaller than the working set must always see the data that
+// was written to each page, even though loads and write-backs now happen outside the pool latch.
+TEST(BufferPoolManagerInstanceTest, ConcurrentFetchTest) {
+  const std::string db_name = "concurrent_fetch_test.db";
+  const size_t buffer_pool_size = 8;
+  const int num_pages = 32;
+  const int num_threads = 4;
+  const int rounds = 200;
+
+  auto *disk_manager = CreateDiskManager(db_name).release();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_pages; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, page_id_temp);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([bpm, tid] {
+      char expected[PAGE_SIZE];
+      for (int round = 0; round < rounds; ++round) {
+        page_id_t page_id = (round * 7 + tid * 3) % num_pages;
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        snprintf(expected, PAGE_SIZE, "page-%d", page_id);
+        page->RLatch();
+        EXPECT_EQ(0, strcmp(page->GetData(), expected));
+        page->RUnlatch();
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("concurrent_fetch_test.db");
+  remove("concurrent_fetch_test.log");
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PrefetchTest) {
+  const std::string db_name = "prefetch_test.db";
+  const size_t buffer_pool_size = 4;
+  const int num_pages = 8;
+
+  auto *disk_manager = CreateDiskManager(db_name).release();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Write more pages than fit in the pool, so the first ones are only on disk.
+  page_id_t page_id;
+  for (int i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  EXPECT_TRUE(bpm->PrefetchPage(num_pages - 1));
+
+  // A prefetch of an evicted page returns right away and the page shows up in the background.
+  EXPECT_FALSE(bpm->PrefetchPage(0));
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (!bpm->PrefetchPage(0) && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  int reads = disk_manager->GetNumReads();
+  ASSERT_EQ(1, reads);
+
+  // Fetching it afterwards is a hit with the right content, and the prefetch left it unpinned.
+  auto *page = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(reads, disk_manager->GetNumReads());
+  EXPECT_EQ(0, strcmp(page->GetData(), "page-0"));
+  EXPECT_EQ(1, page->GetPinCount());
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+  EXPECT_TRUE(bpm->DeletePage(0));
+
+  // A deleted page is not read back in, whether its prefetch was requested before or after the deletion.
+  bpm->PrefetchPage(2);
+  EXPECT_TRUE(bpm->DeletePage(2));
+  EXPECT_FALSE(bpm->PrefetchPage(2));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  auto resident = bpm->GetResidentPages();
+  EXPECT_EQ(resident.end(), std::find(resident.begin(), resident.end(), 2));
+
+  // Prefetches are dropped rather than stealing pinned frames.
+  std::vector<page_id_t> pinned;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    pinned.push_back(page_id);
+  }
+  EXPECT_FALSE(bpm->PrefetchPage(1));
+  EXPECT_EQ(nullptr, bpm->FetchPage(1));
+  for (auto pinned_page_id : pinned) {
+    EXPECT_TRUE(bpm->UnpinPage(pinned_page_id, false));
+  }
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("prefetch_test.db");
+  remove("prefetch_test.log");
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, BackgroundFlushTest) {
+  const std::string db_name = "background_flush_test.db";
+  const size_t buffer_pool_size = 10;
+
+  auto *disk_manager = CreateDiskManager(db_name).release();
+  enable_background_flush = true;
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  enable_background_flush = false;
+
+  // Plenty of free frames, the background writer leaves dirty pages alone.
+  page_id_t page_id;
+  for (size_t i = 0; i < buffer_pool_size / 2; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  std::this_thread::sleep_for(background_flush_interval * 5);
+  EXPECT_EQ(0, bpm->GetBackgroundWrites());
+
+  // Every frame holds a dirty unpinned page, the background writer cleans some of them.
+  for (size_t i = buffer_pool_size / 2; i < buffer_pool_size; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (bpm->GetBackgroundWrites() == 0 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_LT(0, bpm->GetBackgroundWrites());
+
+  // Evict everything. Every write is accounted to one side and no page is lost.
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  // the background writer may be in the middle of a write, give it time to count it
+  deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  auto num_writes = [&] { return static_cast<uint64_t>(disk_manager->GetNumWrites()); };
+  while (num_writes() != bpm->GetForegroundWrites() + bpm->GetBackgroundWrites() &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(num_writes(), bpm->GetForegroundWrites() + bpm->GetBackgroundWrites());
+  char expected[PAGE_SIZE];
+  for (page_id_t i = 0; i < static_cast<page_id_t>(2 * buffer_pool_size); i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page-%d", i);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("background_flush_test.db");
+  remove("background_flush_test.log");
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, BufferRingTest) {
+  const std::string db_name = "buffer_ring_test.db";
+  const size_t buffer_pool_size = 16;
+  const int num_hot_pages = 4;
+  const int num_scan_pages = 40;
+
+  auto *disk_manager = CreateDiskManager(db_name).release();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id;
+  for (int i = 0; i < num_hot_pages + num_scan_pages; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  // Start over with only the hot pages resident, so the ring is filled from free frames rather than from replacer
+  // victims.
+  bpm->FlushAllPages();
+  delete bpm;
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  for (page_id_t i = 0; i < num_hot_pages; i++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(i));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  // A scan through a ring reads every page but recycles its own frames.
+  char expected[PAGE_SIZE];
+  {
+    BufferRing ring;
+    for (page_id_t i = num_hot_pages; i < num_hot_pages + num_scan_pages; i++) {
+      auto *page = bpm->FetchPageInRing(i, &ring);
+      ASSERT_NE(nullptr, page);
+      snprintf(expected, PAGE_SIZE, "page-%d", i);
+      EXPECT_EQ(0, strcmp(page->GetData(), expected));
+      EXPECT_TRUE(bpm->UnpinPage(i, false));
+    }
+  }
+
+  // The hot pages are still resident after the scan.
+  int reads = disk_manager->GetNumReads();
+  for (page_id_t i = 0; i < num_hot_pages; i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page-%d", i);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  EXPECT_EQ(reads, disk_manager->GetNumReads());
+
+  // The ring gave its frames back, so the whole pool can be pinned again.
+  std::vector<page_id_t> pinned;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    pinned.push_back(page_id);
+  }
+  for (auto pinned_page_id : pinned) {
+    EXPECT_TRUE(bpm->UnpinPage(pinned_page_id, false));
+  }
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("buffer_ring_test.db");
+  remove("buffer_ring_test.log");
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, DirectIOTest) {
+  const std::string db_name = "direct_io_test.db";
+  const size_t buffer_pool_size = 8;
+  const int num_pages = 32;
+
+  enable_direct_io = true;
+  auto *disk_manager = new FileDiskManager(db_name);
+  enable_direct_io = false;
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Frames are page aligned, so O_DIRECT reads and writes go straight to them.
+  Page *pages = bpm->GetPages();
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(pages[i].GetData()) % PAGE_SIZE);
+  }
+
+  // Pages survive eviction and are read back intact, with or without O_DIRECT support underneath.
+  page_id_t page_id;
+  for (int i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  char expected[PAGE_SIZE];
+  for (page_id_t i = 0; i < num_pages; i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page-%d", i);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  // Unaligned buffers still work, through a copy.
+  std::vector<char> buffer(PAGE_SIZE + 1);
+  disk_manager->ReadPage(0, &buffer[1]);
+  EXPECT_EQ(0, strcmp(&buffer[1], "page-0"));
+  snprintf(&buffer[1], PAGE_SIZE, "rewritten");
+  disk_manager->WritePage(1, &buffer[1]);
+  disk_manager->ReadPage(1, &buffer[1]);
+  EXPECT_EQ(0, strcmp(&buffer[1], "rewritten"));
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("direct_io_test.db");
+  remove("direct_io_test.log");
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PageReuseTest) {
+  const std::string db_name = "page_reuse_test.db";
+  const size_t buffer_pool_size = 8;
+
+  auto *disk_manager = CreateDiskManager(db_name).release();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Under create/delete churn, page ids are reused and the file stops growing.
+  page_id_t page_id;
+  std::vector<page_id_t> live;
+  for (int round = 0; round < 50; round++) {
+    for (int i = 0; i < 4; i++) {
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+      EXPECT_LT(page_id, 16);
+      EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+      live.push_back(page_id);
+    }
+    bpm->FlushAllPages();
+    for (auto live_page_id : live) {
+      EXPECT_TRUE(bpm->DeletePage(live_page_id));
+    }
+    live.clear();
+  }
+
+  // A reused page id starts out zeroed, even once the page was evicted without being modified.
+  auto *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), PAGE_SIZE, "stale");
+  EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  bpm->FlushAllPages();
+  EXPECT_TRUE(bpm->DeletePage(page_id));
+  page_id_t reused_page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&reused_page_id));
+  EXPECT_EQ(page_id, reused_page_id);
+  EXPECT_TRUE(bpm->UnpinPage(reused_page_id, false));
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  page = bpm->FetchPage(reused_page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, page->GetData()[0]);
+  EXPECT_TRUE(bpm->UnpinPage(reused_page_id, false));
+
+  // A page id is reused while a copy from before its deallocation is still resident.
+  page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), PAGE_SIZE, "stale");
+  EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  disk_manager->DeallocatePage(page_id);
+  page = bpm->NewPage(&reused_page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(page_id, reused_page_id);
+  EXPECT_EQ(0, page->GetData()[0]);
+  EXPECT_TRUE(bpm->UnpinPage(reused_page_id, false));
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("page_reuse_test.db");
+  remove("page_reuse_test.log");
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, WarmUpTest) {
+  const std::string db_name = "warm_up_test.db";
+  const size_t buffer_pool_size = 8;
+
+  auto *disk_manager = new FileDiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, ReplacerType::LRU);
+  page_id_t page_id;
+  for (int i = 0; i < 16; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Resident pages are listed pinned ones first, then the most recently used ones.
+  ASSERT_NE(nullptr, bpm->FetchPage(3));
+  EXPECT_TRUE(bpm->UnpinPage(3, false));
+  ASSERT_NE(nullptr, bpm->FetchPage(5));
+  EXPECT_TRUE(bpm->UnpinPage(5, false));
+  ASSERT_NE(nullptr, bpm->FetchPage(7));
+  std::vector<page_id_t> resident = bpm->GetResidentPages();
+  ASSERT_EQ(buffer_pool_size, resident.size());
+  EXPECT_EQ(7, resident[0]);
+  EXPECT_EQ(5, resident[1]);
+  EXPECT_EQ(3, resident[2]);
+  EXPECT_TRUE(bpm->UnpinPage(7, false));
+  bpm->FlushAllPages();
+  disk_manager->WriteResidentPages(resident);
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+
+  // After a restart, the hottest pages that fit are read back before the pool is used. Pages deallocated in
+  // the meantime are skipped.
+  disk_manager = new FileDiskManager(db_name);
+  disk_manager->DeallocatePage(5);
+  std::vector<page_id_t> saved = disk_manager->ReadResidentPages();
+  ASSERT_EQ(buffer_pool_size - 1, saved.size());
+  EXPECT_EQ(3, saved[1]);
+  bpm = new BufferPoolManagerInstance(4, disk_manager);
+  EXPECT_EQ(4, bpm->WarmUp(saved));
+  int num_reads = disk_manager->GetNumReads();
+  char expected[PAGE_SIZE];
+  for (size_t i = 0; i < 4; i++) {
+    auto *page = bpm->FetchPage(saved[i]);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page-%d", saved[i]);
+    EXPECT_STREQ(expected, page->GetData());
+    EXPECT_TRUE(bpm->UnpinPage(saved[i], false));
+  }
+  EXPECT_EQ(num_reads, disk_manager->GetNumReads());
+  // the pool is full, so nothing more is read
+  EXPECT_EQ(0, bpm->WarmUp(saved));
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("warm_up_test.db");
+  remove("warm_up_test.log");
+  remove("warm_up_test.warmup");
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ResizeTest) {
+  const std::string db_name = "resize_test.db";
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = CreateDiskManager(db_name).release();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  EXPECT_EQ(buffer_pool_size * BUFFER_POOL_MAX_GROWTH, bpm->GetMaxPoolSize());
+
+  // After growing, the new frames take pages without evicting any.
+  std::vector<page_id_t> page_ids;
+  page_id_t page_id;
+  for (size_t i = 0; i < 2 * buffer_pool_size; i++) {
+    if (i == buffer_pool_size) {
+      EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+      EXPECT_TRUE(bpm->Resize(2 * buffer_pool_size));
+      EXPECT_EQ(2 * buffer_pool_size, bpm->GetPoolSize());
+    }
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+    page_ids.push_back(page_id);
+  }
+  EXPECT_EQ(0, disk_manager->GetNumWrites());
+  EXPECT_FALSE(bpm->Resize(bpm->GetMaxPoolSize() + 1));
+  EXPECT_FALSE(bpm->Resize(0));
+
+  // Shrinking evicts unpinned pages, writing back the dirty ones, but stops at pinned pages.
+  for (size_t i = 2; i < page_ids.size(); i++) {
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i], true));
+  }
+  EXPECT_FALSE(bpm->Resize(1));
+  EXPECT_EQ(2, bpm->GetPoolSize());
+  EXPECT_EQ(static_cast<int>(page_ids.size()) - 2, disk_manager->GetNumWrites());
+  EXPECT_EQ(nullptr, bpm->FetchPage(page_ids[2]));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[0], true));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[1], true));
+  EXPECT_TRUE(bpm->Resize(1));
+
+  // Pages read back correctly through the shrunk pool, and it can grow again.
+  char expected[PAGE_SIZE];
+  for (auto id : page_ids) {
+    auto *page = bpm->FetchPage(id);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page-%d", id);
+    EXPECT_STREQ(expected, page->GetData());
+    EXPECT_TRUE(bpm->UnpinPage(id, false));
+  }
+  EXPECT_TRUE(bpm->Resize(bpm->GetMaxPoolSize()));
+  for (size_t i = 0; i < bpm->GetMaxPoolSize(); i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("resize_test.db");
+  remove("resize_test.log");
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PageGuardTest) {
+  const std::string db_name = "page_guard_test.db";
+  const size_t buffer_pool_size = 2;
+
+  auto *disk_manager = CreateDiskManager(db_name).release();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  page_id_t page_id0;
+  page_id_t page_id1;
+  {
+    BasicPageGuard guard0 = bpm->NewPageGuarded(&page_id0);
+    BasicPageGuard guard1 = bpm->NewPageGuarded(&page_id1);
+    ASSERT_TRUE(guard0);
+    ASSERT_TRUE(guard1);
+    EXPECT_EQ(page_id0, guard0.PageId());
+    page_id_t page_id;
+    EXPECT_FALSE(bpm->NewPageGuarded(&page_id));
+  }
+
+  // A guard holds one pin, moves hand it over, and dropping the guard releases it.
+  Page *page0;
+  {
+    ReadPageGuard guard = bpm->FetchPageRead(page_id0);
+    ASSERT_TRUE(guard);
+    page0 = guard.GetPage();
+    EXPECT_EQ(1, page0->GetPinCount());
+    ReadPageGuard moved = std::move(guard);
+    EXPECT_FALSE(guard);  // NOLINT
+    EXPECT_EQ(1, page0->GetPinCount());
+    ReadPageGuard other = bpm->FetchPageRead(page_id0);
+    EXPECT_EQ(2, page0->GetPinCount());
+    other = std::move(moved);
+    EXPECT_EQ(1, page0->GetPinCount());
+    other.Drop();
+    EXPECT_EQ(0, page0->GetPinCount());
+  }
+
+  // The read latches were released, so the page can be write-latched; writing through the guard marks the
+  // page dirty, and it is written back when evicted.
+  {
+    WritePageGuard guard = bpm->FetchPageWrite(page_id0);
+    ASSERT_TRUE(guard);
+    snprintf(guard.GetDataMut(), PAGE_SIZE, "guarded");
+  }
+  EXPECT_TRUE(page0->IsDirty());
+  EXPECT_EQ(0, page0->GetPinCount());
+  int num_writes = disk_manager->GetNumWrites();
+  {
+    BasicPageGuard guard0 = bpm->FetchPageBasic(page_id1);
+    page_id_t page_id2;
+    BasicPageGuard guard1 = bpm->NewPageGuarded(&page_id2);
+    ASSERT_TRUE(guard1);
+  }
+  EXPECT_EQ(num_writes + 1, disk_manager->GetNumWrites());
+  {
+    ReadPageGuard guard = bpm->FetchPageRead(page_id0);
+    ASSERT_TRUE(guard);
+    EXPECT_STREQ("guarded", guard.GetData());
+  }
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("page_guard_test.db");
+  remove("page_guard_test.log");
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, StatsTest) {
+  const std::string db_name = "stats_test.db";
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = CreateDiskManager(db_name).release();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, nullptr, ReplacerType::LRU);
+
+  // New pages fill the free list, then evict the least recently used ones, which are written back.
+  std::vector<page_id_t> page_ids;
+  page_id_t page_id;
+  for (size_t i = 0; i < buffer_pool_size + 2; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(buffer_pool_size + 2, stats.new_pages_);
+  EXPECT_EQ(2, stats.evictions_);
+  // the background writer may have cleaned a victim before it was evicted
+  EXPECT_LE(2, stats.foreground_writes_ + stats.background_writes_);
+  EXPECT_EQ(2, stats.free_list_empty_);
+  EXPECT_EQ(0, stats.fetch_hits_ + stats.fetch_misses_);
+
+  // Fetches of resident pages are hits, the evicted ones are misses.
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids.back()));
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids.back()));
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[0]));
+  stats = bpm->GetStats();
+  EXPECT_EQ(2, stats.fetch_hits_);
+  EXPECT_EQ(1, stats.fetch_misses_);
+  EXPECT_EQ(3, stats.evictions_);
+  EXPECT_DOUBLE_EQ(2.0 / 3.0, stats.HitRatio());
+
+  // The histogram counts resident pages by pin count.
+  EXPECT_EQ(2, stats.pin_count_histogram_[0]);
+  EXPECT_EQ(1, stats.pin_count_histogram_[1]);
+  EXPECT_EQ(1, stats.pin_count_histogram_[2]);
+  EXPECT_EQ(5, BufferPoolStats::PinCountBucket(16));
+  EXPECT_EQ(5, BufferPoolStats::PinCountBucket(1000));
+
+  delete bpm;
+  disk_manager->ShutDown();
+  remove("stats_test.db");
+  remove("stats_test.log");
+  delete disk_manager;
+}
+
 }  // namespace bustub
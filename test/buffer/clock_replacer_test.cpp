@@ -19,7 +19,7 @@
 
 namespace bustub {
 
-TEST(ClockReplacerTest, DISABLED_SampleTest) {
+TEST(ClockReplacerTest, SampleTest) {
   ClockReplacer clock_replacer(7);
 
   // Scenario: unpin six elements, i.e. add them to the replacer.
@@ -59,4 +59,53 @@ TEST(ClockReplacerTest, DISABLED_SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+// NOLINTNEXTLINE
+TEST(ClockReplacerTest, ConcurrencyTest) {
+  const int num_threads = 4;
+  const int frames_per_thread = 64;
+  ClockReplacer clock_replacer(num_threads * frames_per_thread);
+
+  // Scenario: every thread unpins its own frames and pins every other one again.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid] {
+      for (int i = tid * frames_per_thread; i < (tid + 1) * frames_per_thread; i++) {
+        clock_replacer.Unpin(i);
+        if (i % 2 == 0) {
+          clock_replacer.Pin(i);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * frames_per_thread / 2, clock_replacer.Size());
+
+  // Scenario: concurrent victim searches hand out every unpinned frame exactly once.
+  std::vector<std::vector<int>> victims(num_threads);
+  threads.clear();
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid] {
+      int value;
+      while (clock_replacer.Victim(&value)) {
+        victims[tid].push_back(value);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::vector<int> seen(num_threads * frames_per_thread, 0);
+  for (const auto &thread_victims : victims) {
+    for (int value : thread_victims) {
+      seen[value]++;
+    }
+  }
+  for (int i = 0; i < num_threads * frames_per_thread; i++) {
+    EXPECT_EQ(i % 2 == 0 ? 0 : 1, seen[i]) << "frame " << i;
+  }
+  EXPECT_EQ(0, clock_replacer.Size());
+}
+
 }  // namespace bustub
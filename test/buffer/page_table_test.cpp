@@ -0,0 +1,183 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table_test.cpp
+//
+// Identification: test/buffer/page_table_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/page_table.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_backend.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(PageTableTest, SampleTest) {
+  PageTable page_table(8);
+  EXPECT_EQ(16, page_table.Capacity());
+
+  frame_id_t frame_id;
+  EXPECT_FALSE(page_table.Find(0, &frame_id));
+
+  // Page ids of one instance in a parallel pool share a residue, make sure they still work.
+  for (int i = 0; i < 8; i++) {
+    page_table.Insert(i * 5 + 3, i);
+  }
+  for (int i = 0; i < 8; i++) {
+    ASSERT_TRUE(page_table.Find(i * 5 + 3, &frame_id));
+    EXPECT_EQ(i, frame_id);
+  }
+
+  // Erasing from the middle of probe runs must keep every other entry reachable.
+  for (int i = 0; i < 8; i += 2) {
+    EXPECT_TRUE(page_table.Erase(i * 5 + 3));
+    EXPECT_FALSE(page_table.Erase(i * 5 + 3));
+  }
+  for (int i = 0; i < 8; i++) {
+    EXPECT_EQ(i % 2 == 1, page_table.Find(i * 5 + 3, &frame_id));
+    if (i % 2 == 1) {
+      EXPECT_EQ(i, frame_id);
+    }
+  }
+
+  // Reinsert at a different frame.
+  page_table.Insert(3, 7);
+  ASSERT_TRUE(page_table.Find(3, &frame_id));
+  EXPECT_EQ(7, frame_id);
+}
+
+// NOLINTNEXTLINE
+TEST(PageTableTest, ChurnTest) {
+  const size_t num_frames = 64;
+  PageTable page_table(num_frames);
+  std::unordered_map<page_id_t, frame_id_t> reference;
+
+  // A sliding window of live pages exercises wrap-around and backward shifting.
+  for (page_id_t page_id = 0; page_id < 10000; page_id++) {
+    if (reference.size() == num_frames) {
+      page_id_t oldest = page_id - static_cast<page_id_t>(num_frames);
+      EXPECT_TRUE(page_table.Erase(oldest));
+      reference.erase(oldest);
+    }
+    page_table.Insert(page_id, page_id % num_frames);
+    reference[page_id] = page_id % num_frames;
+  }
+  for (page_id_t page_id = 0; page_id < 10000; page_id++) {
+    frame_id_t frame_id;
+    bool found = page_table.Find(page_id, &frame_id);
+    ASSERT_EQ(reference.count(page_id) == 1, found);
+    if (found) {
+      EXPECT_EQ(reference[page_id], frame_id);
+    }
+  }
+}
+
+namespace {
+
+/** The hit path before the page table went lock-free: a pool-wide mutex around a node-based hash map. */
+class LatchedPageTable {
+ public:
+  explicit LatchedPageTable(size_t num_frames) : replacer_(num_frames), pin_counts_(num_frames) {
+    for (size_t i = 0; i < num_frames; i++) {
+      page_table_[static_cast<page_id_t>(i)] = static_cast<frame_id_t>(i);
+    }
+  }
+
+  void FetchAndUnpin(page_id_t page_id) {
+    frame_id_t frame_id;
+    {
+      std::lock_guard<std::mutex> lock(latch_);
+      frame_id = page_table_.find(page_id)->second;
+      pin_counts_[frame_id]++;
+      replacer_.Pin(frame_id);
+    }
+    std::lock_guard<std::mutex> lock(latch_);
+    if (--pin_counts_[frame_id] == 0) {
+      replacer_.Unpin(frame_id);
+    }
+  }
+
+ private:
+  std::mutex latch_;
+  std::unordered_map<page_id_t, frame_id_t> page_table_;
+  LRUReplacer replacer_;
+  std::vector<int> pin_counts_;
+};
+
+template <typename Op>
+double MeasureHitsPerSecond(size_t num_threads, Op op) {
+  const auto duration = std::chrono::milliseconds(200);
+  std::atomic<bool> stop{false};
+  std::vector<uint64_t> hits(num_threads, 0);
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid] {
+      uint64_t count = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        op(static_cast<page_id_t>((count * 7 + tid) % 64));
+        count++;
+      }
+      hits[tid] = count;
+    });
+  }
+  std::this_thread::sleep_for(duration);
+  stop = true;
+  uint64_t total = 0;
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads[tid].join();
+    total += hits[tid];
+  }
+  return static_cast<double>(total) / std::chrono::duration<double>(duration).count();
+}
+
+}  // namespace
+
+// Reports FetchPage + UnpinPage hit throughput from 1 to N threads, next to the old mutex + unordered_map hit path.
+// Run with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(PageTableTest, DISABLED_HitThroughputBenchmark) {
+  const size_t pool_size = 64;
+  auto *disk_manager = CreateDiskManager("test.db").release();
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    bpm->UnpinPage(page_id_temp, false);
+  }
+  LatchedPageTable latched(pool_size);
+
+  size_t max_threads = std::max(2U, std::thread::hardware_concurrency());
+  std::printf("%8s %20s %20s\n", "threads", "latched hits/s", "buffer pool hits/s");
+  for (size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+    double baseline = MeasureHitsPerSecond(num_threads, [&](page_id_t page_id) { latched.FetchAndUnpin(page_id); });
+    double current = MeasureHitsPerSecond(num_threads, [&](page_id_t page_id) {
+      bpm->FetchPage(page_id);
+      bpm->UnpinPage(page_id, false);
+    });
+    std::printf("%8zu %20.0f %20.0f\n", num_threads, baseline, current);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
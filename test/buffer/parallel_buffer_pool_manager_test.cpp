@@ -13,9 +13,12 @@
 #include "buffer/parallel_buffer_pool_manager.h"
 #include <cstdio>
 #include <random>
+#include <cstring>
 #include <string>
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
+#include "storage/disk/disk_backend.h"
 
 namespace bustub {
 
@@ -30,7 +33,7 @@ TEST(ParallelBufferPoolManagerTest, BinaryDataTest) {
   std::default_random_engine rng(r());
   std::uniform_int_distribution<char> uniform_dist(0);
 
-  auto *disk_manager = new DiskManager(db_name);
+  auto *disk_manager = CreateDiskManager(db_name).release();
   auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
 
   page_id_t page_id_temp;
@@ -93,7 +96,7 @@ TEST(ParallelBufferPoolManagerTest, SampleTest) {
   const size_t buffer_pool_size = 10;
   const size_t num_instances = 5;
 
-  auto *disk_manager = new DiskManager(db_name);
+  auto *disk_manager = CreateDiskManager(db_name).release();
   auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
 
   page_id_t page_id_temp;
@@ -152,4 +155,138 @@ TEST(ParallelBufferPoolManagerTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, SegmentTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 8;
+  const size_t num_instances = 3;
+  const int num_pages = EXTENT_SIZE + 8;
+
+  auto *disk_manager = CreateDiskManager(db_name).release();
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  // Scenario: pages created alternately for two segments are contiguous within each segment.
+  PageSegment segments[2];
+  std::vector<page_id_t> page_ids[2];
+  page_id_t page_id;
+  for (int i = 0; i < num_pages; i++) {
+    for (int s = 0; s < 2; s++) {
+      auto *page = bpm->NewPageInSegment(&page_id, &segments[s]);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+      EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+      page_ids[s].push_back(page_id);
+    }
+  }
+  for (auto &segment_page_ids : page_ids) {
+    EXPECT_EQ(0, segment_page_ids[0] % EXTENT_SIZE);
+    for (int i = 1; i < EXTENT_SIZE; i++) {
+      EXPECT_EQ(segment_page_ids[0] + i, segment_page_ids[i]);
+    }
+    // the next extent starts at an extent boundary as well
+    EXPECT_EQ(0, segment_page_ids[EXTENT_SIZE] % EXTENT_SIZE);
+  }
+
+  // Scenario: the page ids route to the instances that created them, so the pages read back intact.
+  char expected[PAGE_SIZE];
+  for (auto &segment_page_ids : page_ids) {
+    for (auto segment_page_id : segment_page_ids) {
+      auto *page = bpm->FetchPage(segment_page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(expected, PAGE_SIZE, "page-%d", segment_page_id);
+      EXPECT_EQ(0, strcmp(page->GetData(), expected));
+      EXPECT_TRUE(bpm->UnpinPage(segment_page_id, false));
+    }
+  }
+
+  // Scenario: regular allocations do not take pages reserved for a segment.
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  for (auto &segment_page_ids : page_ids) {
+    EXPECT_TRUE(page_id < segment_page_ids[0] || page_id >= segment_page_ids[EXTENT_SIZE] + EXTENT_SIZE);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ResizeTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+  const size_t num_instances = 3;
+
+  auto *disk_manager = CreateDiskManager(db_name).release();
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  // Scenario: the instances grow evenly and page ids keep mapping back to their instance.
+  EXPECT_TRUE(bpm->Resize(20));
+  EXPECT_EQ(20, bpm->GetPoolSize());
+  std::vector<page_id_t> page_ids(20);
+  for (auto &page_id : page_ids) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page-%d", page_id);
+  }
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+
+  // Scenario: shrinking hands the memory of every instance back, and the evicted pages read back correctly.
+  for (auto id : page_ids) {
+    EXPECT_TRUE(bpm->UnpinPage(id, true));
+  }
+  EXPECT_FALSE(bpm->Resize(num_instances - 1));
+  EXPECT_TRUE(bpm->Resize(num_instances));
+  EXPECT_EQ(num_instances, bpm->GetPoolSize());
+  char expected[PAGE_SIZE];
+  for (auto id : page_ids) {
+    auto *page = bpm->FetchPage(id);
+    ASSERT_NE(nullptr, page);
+    snprintf(expected, PAGE_SIZE, "page-%d", id);
+    EXPECT_STREQ(expected, page->GetData());
+    EXPECT_TRUE(bpm->UnpinPage(id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, StatsTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 2;
+  const size_t num_instances = 3;
+
+  auto *disk_manager = CreateDiskManager(db_name).release();
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  // Scenario: the stats of the instances are summed up.
+  std::vector<page_id_t> page_ids(num_instances * buffer_pool_size);
+  for (auto &page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+  for (auto id : page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(id));
+    EXPECT_TRUE(bpm->UnpinPage(id, false));
+    EXPECT_TRUE(bpm->UnpinPage(id, true));
+  }
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(page_ids.size(), stats.new_pages_);
+  EXPECT_EQ(page_ids.size(), stats.fetch_hits_);
+  EXPECT_EQ(0, stats.fetch_misses_);
+  EXPECT_EQ(page_ids.size(), stats.pin_count_histogram_[0]);
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
@@ -0,0 +1,105 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replacer_benchmark_test.cpp
+//
+// Identification: test/buffer/replacer_benchmark_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <cstdio>
+#include <random>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "container/hash/extendible_hash_table.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_backend.h"
+
+namespace bustub {
+
+// Point lookups through an extendible hash table compete for the pool with threads that repeatedly scan a table
+// several times its size. Reports the hit ratio of every replacement policy.
+// Run with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(ReplacerBenchmarkTest, DISABLED_ScanResistanceBenchmark) {
+  const size_t pool_size = 64;
+  const int num_keys = 4000;
+  const int num_scan_pages = 4 * pool_size;
+  const int num_lookup_threads = 2;
+  const int num_scan_threads = 2;
+  const int lookups_per_thread = 20000;
+  const std::vector<std::pair<ReplacerType, const char *>> policies = {
+      {ReplacerType::CLOCK, "CLOCK"},
+      {ReplacerType::LRU, "LRU"},
+      {ReplacerType::LRU_K, "LRU-K"},
+      {ReplacerType::TWO_Q, "2Q"}};
+
+  std::printf("%8s %12s %12s %12s\n", "policy", "fetches", "disk reads", "hit ratio");
+  for (const auto &[replacer_type, name] : policies) {
+    auto *disk_manager = CreateDiskManager("test.db").release();
+    auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager, nullptr, replacer_type);
+    ExtendibleHashTable<int, int, IntComparator> ht("index", bpm, IntComparator(), HashFunction<int>());
+    for (int i = 0; i < num_keys; i++) {
+      ht.Insert(nullptr, i, i);
+    }
+    std::vector<page_id_t> scan_pages(num_scan_pages);
+    for (auto &page_id : scan_pages) {
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+      bpm->UnpinPage(page_id, true);
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> fetches{0};
+    int reads_before = disk_manager->GetNumReads();
+    std::vector<std::thread> scanners;
+    for (int tid = 0; tid < num_scan_threads; tid++) {
+      scanners.emplace_back([&] {
+        while (!stop) {
+          for (page_id_t page_id : scan_pages) {
+            bpm->FetchPage(page_id);
+            bpm->UnpinPage(page_id, false);
+          }
+          fetches += scan_pages.size();
+        }
+      });
+    }
+    std::vector<std::thread> lookups;
+    for (int tid = 0; tid < num_lookup_threads; tid++) {
+      lookups.emplace_back([&, tid] {
+        std::mt19937 rng(tid);
+        std::uniform_int_distribution<int> key_dist(0, num_keys - 1);
+        for (int i = 0; i < lookups_per_thread; i++) {
+          std::vector<int> result;
+          ht.GetValue(nullptr, key_dist(rng), &result);
+        }
+        // every lookup fetches the directory page and one bucket page
+        fetches += 2 * lookups_per_thread;
+      });
+    }
+    for (auto &thread : lookups) {
+      thread.join();
+    }
+    stop = true;
+    for (auto &thread : scanners) {
+      thread.join();
+    }
+
+    int reads = disk_manager->GetNumReads() - reads_before;
+    std::printf("%8s %12lu %12d %12.3f\n", name, fetches.load(), reads,
+                1.0 - static_cast<double>(reads) / static_cast<double>(fetches.load()));
+
+    disk_manager->ShutDown();
+    remove("test.db");
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_q_replacer_test.cpp
+//
+// Identification: test/buffer/two_q_replacer_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/two_q_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(TwoQReplacerTest, SampleTest) {
+  TwoQReplacer two_q_replacer(7, 30, 0);
+  int value;
+
+  // Scenario: 1 and 2 are referenced twice and move to Am.
+  two_q_replacer.Pin(1);
+  two_q_replacer.Pin(2);
+  two_q_replacer.Pin(1);
+  two_q_replacer.Pin(2);
+  two_q_replacer.Unpin(1);
+  two_q_replacer.Unpin(2);
+
+  // Scenario: a scan over 3, 4, 5 and 6 goes through A1.
+  for (int i = 3; i <= 6; i++) {
+    two_q_replacer.Pin(i);
+    two_q_replacer.Unpin(i);
+  }
+  EXPECT_EQ(6, two_q_replacer.Size());
+
+  // Scenario: A1 is over its target size, so it gives up its oldest frames first.
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+
+  // Scenario: A1 is at its target size, Am gives up its least recently used frame.
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+
+  // Scenario: pinned frames are not evictable, whichever queue they are in.
+  two_q_replacer.Pin(2);
+  two_q_replacer.Pin(5);
+  EXPECT_EQ(1, two_q_replacer.Size());
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(6, value);
+  EXPECT_FALSE(two_q_replacer.Victim(&value));
+}
+
+// NOLINTNEXTLINE
+TEST(TwoQReplacerTest, CorrelatedReferenceTest) {
+  TwoQReplacer two_q_replacer(7, 15, 3);
+  int value;
+
+  // Scenario: 1 is re-referenced right away and stays in A1, 2 is re-referenced later and moves to Am.
+  two_q_replacer.Pin(1);
+  two_q_replacer.Pin(1);
+  two_q_replacer.Pin(2);
+  two_q_replacer.Pin(3);
+  two_q_replacer.Pin(4);
+  two_q_replacer.Pin(2);
+  for (int i = 1; i <= 4; i++) {
+    two_q_replacer.Unpin(i);
+  }
+
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+}
+
+// NOLINTNEXTLINE
+TEST(TwoQReplacerTest, PoolSizeTest) {
+  TwoQReplacer two_q_replacer(8, 25, 0);
+  int value;
+
+  // Scenario: 1 and 2 move to Am, a scan over 3 to 6 fills A1 beyond its 2 frames.
+  for (int i = 1; i <= 2; i++) {
+    two_q_replacer.Pin(i);
+    two_q_replacer.Pin(i);
+    two_q_replacer.Unpin(i);
+  }
+  for (int i = 3; i <= 6; i++) {
+    two_q_replacer.Pin(i);
+    two_q_replacer.Unpin(i);
+  }
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+
+  // Scenario: the pool grew, so A1 is now below its share and Am gives up a frame instead.
+  two_q_replacer.SetPoolSize(20);
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+
+  // Scenario: the pool shrank again, A1 is over its share.
+  two_q_replacer.SetPoolSize(4);
+  ASSERT_TRUE(two_q_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+}
+
+}  // namespace bustub
@@ -0,0 +1,113 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// rwlatch_benchmark_test.cpp
+//
+// Identification: test/common/rwlatch_benchmark_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <random>
+#include <shared_mutex>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/rwlatch.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+namespace {
+
+/** The standard library's reader-writer latch, as a baseline. */
+class StdSharedLatch {
+ public:
+  void WLock() { mutex_.lock(); }
+  void WUnlock() { mutex_.unlock(); }
+  void RLock() { mutex_.lock_shared(); }
+  void RUnlock() { mutex_.unlock_shared(); }
+
+ private:
+  std::shared_mutex mutex_;
+};
+
+/**
+ * Hammer a few latches, each guarding a counter, from num_threads threads. Every operation picks a latch at random
+ * and takes it exclusively with probability write_percent, shared otherwise.
+ * @return million operations per second
+ */
+template <typename Latch>
+double RunLatchBenchmark(int num_threads, int write_percent, int num_latches) {
+  const auto duration = std::chrono::milliseconds(200);
+  std::vector<Latch> latches(num_latches);
+  std::vector<uint64_t> counters(num_latches);
+  std::atomic<bool> start{false};
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> ops{0};
+  std::atomic<uint64_t> checksum{0};
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid] {
+      std::mt19937 rng(tid);
+      std::uniform_int_distribution<int> latch_dist(0, num_latches - 1);
+      std::uniform_int_distribution<int> percent_dist(0, 99);
+      uint64_t local_ops = 0;
+      uint64_t sum = 0;
+      while (!start) {
+        std::this_thread::yield();
+      }
+      while (!stop) {
+        int i = latch_dist(rng);
+        if (percent_dist(rng) < write_percent) {
+          latches[i].WLock();
+          counters[i]++;
+          latches[i].WUnlock();
+        } else {
+          latches[i].RLock();
+          sum += counters[i];
+          latches[i].RUnlock();
+        }
+        local_ops++;
+      }
+      ops += local_ops;
+      checksum += sum;
+    });
+  }
+  auto begin = std::chrono::steady_clock::now();
+  start = true;
+  std::this_thread::sleep_for(duration);
+  stop = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+  return static_cast<double>(ops.load()) / elapsed.count() / 1e6;
+}
+
+}  // namespace
+
+// Compares ReaderWriterLatch with std::shared_mutex for read-mostly and write-heavy mixes, on one hot latch and
+// spread over a few. Run with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(RWLatchBenchmarkTest, DISABLED_ContentionBenchmark) {
+  const int max_threads = std::max(2U, std::thread::hardware_concurrency());
+  std::printf("%8s %8s %8s %16s %16s\n", "threads", "write %", "latches", "rwlatch Mops/s", "shared_mutex");
+  for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+    for (int write_percent : {0, 5, 50}) {
+      for (int num_latches : {1, 16}) {
+        double ours = RunLatchBenchmark<ReaderWriterLatch>(num_threads, write_percent, num_latches);
+        double baseline = RunLatchBenchmark<StdSharedLatch>(num_threads, write_percent, num_latches);
+        std::printf("%8d %8d %8d %16.2f %16.2f\n", num_threads, write_percent, num_latches, ours, baseline);
+      }
+    }
+  }
+}
+
+}  // namespace bustub
@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
 #include <thread>  // NOLINT
 #include <vector>
 
@@ -57,4 +58,63 @@ TEST(RWLatchTest, BasicTest) {
   }
   EXPECT_EQ(counter.Read(), 55);
 }
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, OptimisticReadTest) {
+  ReaderWriterLatch latch;
+  uint64_t version;
+  ASSERT_TRUE(latch.TryOptimisticRead(&version));
+  EXPECT_TRUE(latch.Validate(version));
+
+  // Scenario: read latches leave the version alone, a write latch invalidates reads started before it and refuses
+  // new ones while it is held.
+  latch.RLock();
+  latch.RUnlock();
+  EXPECT_TRUE(latch.Validate(version));
+  latch.WLock();
+  uint64_t during_write;
+  EXPECT_FALSE(latch.TryOptimisticRead(&during_write));
+  EXPECT_FALSE(latch.Validate(version));
+  latch.WUnlock();
+  EXPECT_FALSE(latch.Validate(version));
+  ASSERT_TRUE(latch.TryOptimisticRead(&version));
+  EXPECT_TRUE(latch.Validate(version));
+
+  // Scenario: readers racing with a writer never accept a half-written pair.
+  std::atomic<int> first{0};
+  std::atomic<int> second{0};
+  std::atomic<bool> done{false};
+  std::thread writer([&]() {
+    for (int i = 1; i <= 10000; i++) {
+      latch.WLock();
+      first.store(i, std::memory_order_relaxed);
+      second.store(i, std::memory_order_relaxed);
+      latch.WUnlock();
+    }
+    done = true;
+  });
+  std::vector<std::thread> readers;
+  std::atomic<int> torn{0};
+  for (int tid = 0; tid < 2; tid++) {
+    readers.emplace_back([&]() {
+      while (!done) {
+        uint64_t read_version;
+        if (!latch.TryOptimisticRead(&read_version)) {
+          std::this_thread::yield();
+          continue;
+        }
+        int a = first.load(std::memory_order_relaxed);
+        int b = second.load(std::memory_order_relaxed);
+        if (latch.Validate(read_version) && a != b) {
+          torn++;
+        }
+      }
+    });
+  }
+  writer.join();
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(0, torn);
+}
 }  // namespace bustub
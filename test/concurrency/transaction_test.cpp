@@ -33,6 +33,7 @@
 #include "execution/plans/nested_index_join_plan.h"
 #include "execution/plans/seq_scan_plan.h"
 #include "gtest/gtest.h"
+#include "storage/disk/disk_backend.h"
 #include "test_util.h"  // NOLINT
 #include "type/value_factory.h"
 
@@ -54,7 +55,7 @@ class TransactionTest : public ::testing::Test {
   void SetUp() override {
     ::testing::Test::SetUp();
     // For each test, we create a new DiskManager, BufferPoolManager, TransactionManager, and Catalog.
-    disk_manager_ = std::make_unique<DiskManager>("executor_test.db");
+    disk_manager_ = CreateDiskManager("executor_test.db");
     bpm_ = std::make_unique<BufferPoolManagerInstance>(2560, disk_manager_.get());
     page_id_t page_id;
     bpm_->NewPage(&page_id);
@@ -0,0 +1,113 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_benchmark_test.cpp
+//
+// Identification: test/container/hash_table_benchmark_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "container/hash/extendible_hash_table.h"
+#include "gtest/gtest.h"
+#include "storage/disk/memory_disk_manager.h"
+
+namespace bustub {
+
+namespace {
+
+/**
+ * Insert keys_per_thread keys from each of num_threads threads into an empty table, then look them all up again
+ * from the same threads. Every thread owns a disjoint key range. The pool is large enough that nothing is evicted.
+ * @param[out] insert_mops million inserts per second
+ * @param[out] lookup_mops million lookups per second
+ */
+void RunHashTableBenchmark(int num_threads, int keys_per_thread, double *insert_mops, double *lookup_mops) {
+  MemoryDiskManager disk_manager;
+  BufferPoolManagerInstance bpm(4096, &disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("benchmark", &bpm, IntComparator(), HashFunction<int>());
+  std::atomic<int> failures{0};
+
+  auto run_phase = [&](bool insert) {
+    std::vector<std::thread> threads;
+    auto begin = std::chrono::steady_clock::now();
+    for (int tid = 0; tid < num_threads; tid++) {
+      threads.emplace_back([&, tid] {
+        std::vector<int> result;
+        for (int key = tid * keys_per_thread; key < (tid + 1) * keys_per_thread; key++) {
+          if (insert) {
+            failures += ht.Insert(nullptr, key, key) ? 0 : 1;
+          } else {
+            result.clear();
+            failures += ht.GetValue(nullptr, key, &result) && result[0] == key ? 0 : 1;
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+    return static_cast<double>(num_threads) * keys_per_thread / elapsed.count() / 1e6;
+  };
+
+  *insert_mops = run_phase(true);
+  *lookup_mops = run_phase(false);
+  EXPECT_EQ(0, failures.load());
+  ht.VerifyIntegrity();
+}
+
+}  // namespace
+
+// Measures insert and lookup throughput of the extendible hash table as threads are added. Inserts share the table
+// latch and only escalate to exclusive mode to split a bucket. Run with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(HashTableBenchmarkTest, DISABLED_ConcurrentInsertLookupBenchmark) {
+  const int max_threads = std::max(2U, std::thread::hardware_concurrency());
+  const int total_keys = 100000;
+  std::printf("%8s %16s %16s\n", "threads", "insert Mops/s", "lookup Mops/s");
+  for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+    double insert_mops;
+    double lookup_mops;
+    RunHashTableBenchmark(num_threads, total_keys / num_threads, &insert_mops, &lookup_mops);
+    std::printf("%8d %16.2f %16.2f\n", num_threads, insert_mops, lookup_mops);
+  }
+}
+
+// Compares building a table from scratch with BulkLoad against InsertBatch, which grows it by splitting buckets.
+// Run with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(HashTableBenchmarkTest, DISABLED_BulkLoadBenchmark) {
+  std::printf("%10s %16s %16s\n", "keys", "bulk load Mops/s", "batch Mops/s");
+  for (int num_keys : {100000, 1000000}) {
+    std::vector<int> keys(num_keys);
+    for (int i = 0; i < num_keys; i++) {
+      keys[i] = i;
+    }
+    double mops[2];
+    for (int bulk = 0; bulk < 2; bulk++) {
+      MemoryDiskManager disk_manager;
+      BufferPoolManagerInstance bpm(16384, &disk_manager);
+      ExtendibleHashTable<int, int, IntComparator> ht("benchmark", &bpm, IntComparator(), HashFunction<int>());
+      auto begin = std::chrono::steady_clock::now();
+      size_t inserted = bulk == 0 ? ht.BulkLoad(nullptr, keys, keys) : ht.InsertBatch(nullptr, keys, keys);
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+      EXPECT_EQ(static_cast<size_t>(num_keys), inserted);
+      mops[bulk] = num_keys / elapsed.count() / 1e6;
+    }
+    std::printf("%10d %16.2f %16.2f\n", num_keys, mops[0], mops[1]);
+  }
+}
+
+}  // namespace bustub
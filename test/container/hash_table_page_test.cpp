@@ -16,15 +16,17 @@
 #include "buffer/buffer_pool_manager_instance.h"
 #include "common/logger.h"
 #include "gtest/gtest.h"
-#include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_backend.h"
+#include "storage/index/generic_key.h"
 #include "storage/page/hash_table_bucket_page.h"
 #include "storage/page/hash_table_directory_page.h"
+#include "test_util.h"  // NOLINT
 
 namespace bustub {
 
 // NOLINTNEXTLINE
 TEST(HashTablePageTest, DirectoryPageSampleTest) {
-  DiskManager *disk_manager = new DiskManager("test.db");
+  DiskManager *disk_manager = CreateDiskManager("test.db").release();
   auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
 
   // get a directory page from the BufferPoolManager
@@ -58,7 +60,7 @@ TEST(HashTablePageTest, DirectoryPageSampleTest) {
 
 // NOLINTNEXTLINE
 TEST(HashTablePageTest, BucketPageSampleTest) {
-  DiskManager *disk_manager = new DiskManager("test.db");
+  DiskManager *disk_manager = CreateDiskManager("test.db").release();
   auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
 
   // get a bucket page from the BufferPoolManager
@@ -114,4 +116,67 @@ TEST(HashTablePageTest, BucketPageSampleTest) {
   delete bpm;
 }
 
+// Scenario: fill a bucket of wide keys, whose probes go through the fingerprints, then punch holes into it and
+// fill them again.
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, BucketPageFullTest) {
+  DiskManager *disk_manager = CreateDiskManager("test.db").release();
+  auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<64> comparator(key_schema.get());
+
+  page_id_t bucket_page_id = INVALID_PAGE_ID;
+  auto bucket_page = reinterpret_cast<HashTableBucketPage<GenericKey<64>, RID, GenericComparator<64>> *>(
+      bpm->NewPage(&bucket_page_id, nullptr)->GetData());
+  auto make_key = [](int64_t i) {
+    GenericKey<64> key;
+    key.SetFromInteger(i);
+    return key;
+  };
+
+  uint32_t capacity = 0;
+  while (bucket_page->Insert(make_key(capacity), RID(capacity, 0), comparator)) {
+    capacity++;
+  }
+  ASSERT_LT(0, capacity);
+  EXPECT_TRUE(bucket_page->IsFull());
+  EXPECT_EQ(capacity, bucket_page->NumReadable());
+  EXPECT_EQ(capacity, bucket_page->GetOccupiedSize());
+
+  for (uint32_t i = 0; i < capacity; i++) {
+    std::vector<RID> result;
+    ASSERT_TRUE(bucket_page->GetValue(make_key(i), comparator, &result));
+    ASSERT_EQ(1, result.size());
+    EXPECT_EQ(RID(i, 0), result[0]);
+  }
+  std::vector<RID> result;
+  EXPECT_FALSE(bucket_page->GetValue(make_key(capacity), comparator, &result));
+
+  // every third pair leaves a tombstone, which the next inserts reuse before the bucket is full again
+  for (uint32_t i = 0; i < capacity; i += 3) {
+    EXPECT_TRUE(bucket_page->Remove(make_key(i), RID(i, 0), comparator));
+    EXPECT_FALSE(bucket_page->Remove(make_key(i), RID(i, 0), comparator));
+  }
+  EXPECT_FALSE(bucket_page->IsFull());
+  EXPECT_EQ(capacity, bucket_page->GetOccupiedSize());
+  for (uint32_t i = 0; i < capacity; i += 3) {
+    EXPECT_TRUE(bucket_page->Insert(make_key(i), RID(i, 1), comparator));
+  }
+  EXPECT_TRUE(bucket_page->IsFull());
+
+  // a key may have several values
+  result.clear();
+  EXPECT_TRUE(bucket_page->Remove(make_key(1), RID(1, 0), comparator));
+  EXPECT_TRUE(bucket_page->Insert(make_key(0), RID(0, 2), comparator));
+  EXPECT_FALSE(bucket_page->Insert(make_key(0), RID(0, 2), comparator));
+  ASSERT_TRUE(bucket_page->GetValue(make_key(0), comparator, &result));
+  EXPECT_EQ(2, result.size());
+
+  bpm->UnpinPage(bucket_page_id, true, nullptr);
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
 }  // namespace bustub
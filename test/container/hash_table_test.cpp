@@ -10,6 +10,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <atomic>
 #include <thread>  // NOLINT
 #include <vector>
 
@@ -18,6 +20,10 @@
 #include "container/hash/extendible_hash_table.h"
 #include "gtest/gtest.h"
 #include "murmur3/MurmurHash3.h"
+#include "storage/disk/disk_backend.h"
+#include "storage/disk/memory_disk_manager.h"
+#include "storage/index/generic_key.h"
+#include "test_util.h"  // NOLINT
 
 namespace bustub {
 
@@ -25,7 +31,7 @@ namespace bustub {
 
 // NOLINTNEXTLINE
 TEST(HashTableTest, SampleTest) {
-  auto *disk_manager = new DiskManager("test.db");
+  auto *disk_manager = CreateDiskManager("test.db").release();
   auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
   ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
   std::cout<<"hah"<<std::endl;
@@ -118,4 +124,184 @@ TEST(HashTableTest, SampleTest) {
   delete bpm;
 }
 
+// Scenario: insert more wide keys than a single directory page can address, so that the directory is split under
+// the header, then remove half of them again.
+// NOLINTNEXTLINE
+TEST(HashTableTest, MultiPageDirectoryTest) {
+  auto *disk_manager = new MemoryDiskManager();
+  auto *bpm = new BufferPoolManagerInstance(256, disk_manager);
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<64> comparator(key_schema.get());
+  ExtendibleHashTable<GenericKey<64>, RID, GenericComparator<64>> ht("blah", bpm, comparator,
+                                                                      HashFunction<GenericKey<64>>());
+  auto make_key = [](int64_t i) {
+    GenericKey<64> key;
+    key.SetFromInteger(i);
+    return key;
+  };
+
+  const int num_keys = 50000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, make_key(i), RID(i, 0))) << "Failed to insert " << i;
+  }
+  EXPECT_LT(DIRECTORY_MAX_DEPTH, ht.GetGlobalDepth());
+  ht.VerifyIntegrity();
+
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<RID> res;
+    ASSERT_TRUE(ht.GetValue(nullptr, make_key(i), &res)) << "Failed to keep " << i;
+    ASSERT_EQ(1, res.size());
+    EXPECT_EQ(RID(i, 0), res[0]);
+  }
+
+  for (int i = 0; i < num_keys; i += 2) {
+    ASSERT_TRUE(ht.Remove(nullptr, make_key(i), RID(i, 0)));
+  }
+  ht.VerifyIntegrity();
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<RID> res;
+    EXPECT_EQ(i % 2 == 1, ht.GetValue(nullptr, make_key(i), &res));
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// Scenario: insert and look up keys in batches that span many buckets, with duplicates within a batch and keys
+// that are not in the table.
+// NOLINTNEXTLINE
+TEST(HashTableTest, BatchTest) {
+  auto *disk_manager = new MemoryDiskManager();
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  const int num_keys = 5000;
+  std::vector<int> keys;
+  std::vector<int> values;
+  for (int i = 0; i < num_keys; i++) {
+    keys.push_back(i);
+    values.push_back(i);
+  }
+  // the first batch fills the root bucket, most of it goes through SplitInsert
+  bool complete = false;
+  EXPECT_EQ(num_keys, ht.InsertBatch(nullptr, keys, values, &complete));
+  EXPECT_TRUE(complete);
+  EXPECT_EQ(0, ht.InsertBatch(nullptr, keys, values));
+  for (int i = 0; i < num_keys; i++) {
+    values[i] = -i;
+  }
+  EXPECT_EQ(num_keys - 1, ht.InsertBatch(nullptr, keys, values));
+  ht.VerifyIntegrity();
+
+  keys.push_back(num_keys);
+  std::vector<std::vector<int>> results;
+  EXPECT_TRUE(ht.GetValueBatch(nullptr, keys, &results));
+  ASSERT_EQ(keys.size(), results.size());
+  for (int i = 0; i < num_keys; i++) {
+    std::sort(results[i].begin(), results[i].end());
+    std::vector<int> expected = i == 0 ? std::vector<int>{0} : std::vector<int>{-i, i};
+    EXPECT_EQ(expected, results[i]) << "Wrong values for " << i;
+  }
+  EXPECT_TRUE(results[num_keys].empty());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// Readers look up keys that stay in the table while a writer keeps splitting and merging buckets around them.
+// NOLINTNEXTLINE
+TEST(HashTableTest, ConcurrentMergeTest) {
+  auto *disk_manager = new MemoryDiskManager();
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  const int num_keys = 200;
+  const int num_churn_keys = 2000;
+  for (int i = 0; i < num_keys; i++) {
+    ht.Insert(nullptr, i, i);
+  }
+  std::atomic<bool> done{false};
+  std::thread writer([&] {
+    for (int round = 0; round < 5; round++) {
+      for (int i = num_keys; i < num_keys + num_churn_keys; i++) {
+        ht.Insert(nullptr, i, i);
+      }
+      for (int i = num_keys; i < num_keys + num_churn_keys; i++) {
+        ht.Remove(nullptr, i, i);
+      }
+    }
+    done = true;
+  });
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < 2; tid++) {
+    readers.emplace_back([&, tid] {
+      for (int i = tid; !done; i = (i + 7) % num_keys) {
+        std::vector<int> res;
+        ht.GetValue(nullptr, i, &res);
+        ASSERT_EQ(1, res.size()) << "Lost " << i;
+        EXPECT_EQ(i, res[0]);
+      }
+    });
+  }
+  writer.join();
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  ht.VerifyIntegrity();
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// Scenario: build a table bottom-up from pairs spread over several directory pages, including a run of equal keys and a
+// duplicate pair, then keep inserting and removing one pair at a time.
+// NOLINTNEXTLINE
+TEST(HashTableTest, BulkLoadTest) {
+  auto *disk_manager = new MemoryDiskManager();
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  const int num_keys = 200000;
+  const int num_equal = 300;
+  std::vector<int> keys;
+  std::vector<int> values;
+  for (int i = 0; i < num_keys; i++) {
+    keys.push_back(i);
+    values.push_back(i);
+  }
+  for (int i = 0; i < num_equal; i++) {
+    keys.push_back(-1);
+    values.push_back(i);
+  }
+  keys.push_back(0);
+  values.push_back(0);
+  EXPECT_EQ(num_keys + num_equal, ht.BulkLoad(nullptr, keys, values));
+  ht.VerifyIntegrity();
+  EXPECT_LT(DIRECTORY_MAX_DEPTH, ht.GetGlobalDepth());
+
+  std::vector<std::vector<int>> results;
+  ht.GetValueBatch(nullptr, keys, &results);
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_EQ(std::vector<int>{i}, results[i]) << "Wrong values for " << i;
+  }
+  EXPECT_EQ(num_equal, results[num_keys].size());
+
+  // the table is no longer empty, so a second load is inserted like a batch
+  EXPECT_EQ(1, ht.BulkLoad(nullptr, {0, 1}, {-1, 1}));
+  for (int i = 0; i < num_keys; i += 10) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+    EXPECT_TRUE(ht.Insert(nullptr, num_keys + i, i));
+  }
+  ht.VerifyIntegrity();
+  std::vector<int> res;
+  for (int i = 0; i < num_keys; i += 10) {
+    res.clear();
+    EXPECT_TRUE(ht.GetValue(nullptr, num_keys + i, &res));
+    EXPECT_EQ(std::vector<int>{i}, res);
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
@@ -32,6 +32,7 @@
 #include "execution/plans/distinct_plan.h"
 #include "execution/plans/hash_join_plan.h"
 #include "execution/plans/limit_plan.h"
+#include "execution/plans/nested_index_join_plan.h"
 #include "execution/plans/seq_scan_plan.h"
 #include "execution/plans/update_plan.h"
 #include "executor_test_util.h"  // NOLINT
@@ -415,6 +416,50 @@ TEST_F(ExecutorTest, SimpleNestedLoopJoinTest) {
   ASSERT_EQ(result_set.size(), 100);
 }
 
+// SELECT t1.colA, t1.colB, t2.colA, t2.colB FROM test_1 t1 JOIN test_1 t2 ON t1.colA = t2.colA; with an index on
+// t2.colA. The outer table is larger than a batch of index probes.
+TEST_F(ExecutorTest, SimpleNestedIndexJoinTest) {
+  auto table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto &schema = table_info->schema_;
+  auto key_schema = ParseCreateStatement("a bigint");
+  GetExecutorContext()->GetCatalog()->CreateIndex<KeyType, ValueType, ComparatorType>(
+      GetTxn(), "index1", "test_1", schema, *key_schema, {0}, 8, HashFunctionType{});
+
+  const Schema *outer_schema;
+  std::unique_ptr<AbstractPlanNode> scan_plan;
+  {
+    auto col_a = MakeColumnValueExpression(schema, 0, "colA");
+    auto col_b = MakeColumnValueExpression(schema, 0, "colB");
+    outer_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+    scan_plan = std::make_unique<SeqScanPlanNode>(outer_schema, nullptr, table_info->oid_);
+  }
+
+  const Schema *out_final;
+  std::unique_ptr<NestedIndexJoinPlanNode> join_plan;
+  {
+    auto outer_col_a = MakeColumnValueExpression(*outer_schema, 0, "colA");
+    auto outer_col_b = MakeColumnValueExpression(*outer_schema, 0, "colB");
+    auto inner_col_a = MakeColumnValueExpression(schema, 1, "colA");
+    auto inner_col_b = MakeColumnValueExpression(schema, 1, "colB");
+    auto predicate = MakeComparisonExpression(outer_col_a, inner_col_a, ComparisonType::Equal);
+    out_final = MakeOutputSchema({{"outer_colA", outer_col_a},
+                                  {"outer_colB", outer_col_b},
+                                  {"inner_colA", inner_col_a},
+                                  {"inner_colB", inner_col_b}});
+    join_plan = std::make_unique<NestedIndexJoinPlanNode>(
+        out_final, std::vector<const AbstractPlanNode *>{scan_plan.get()}, predicate, table_info->oid_, "index1",
+        outer_schema, &schema);
+  }
+
+  std::vector<Tuple> result_set{};
+  GetExecutionEngine()->Execute(join_plan.get(), &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(result_set.size(), TEST1_SIZE);
+  for (const auto &tuple : result_set) {
+    ASSERT_EQ(tuple.GetValue(out_final, 0).GetAs<int32_t>(), tuple.GetValue(out_final, 2).GetAs<int32_t>());
+    ASSERT_EQ(tuple.GetValue(out_final, 1).GetAs<int32_t>(), tuple.GetValue(out_final, 3).GetAs<int32_t>());
+  }
+}
+
 // SELECT test_4.colA, test_4.colB, test_6.colA, test_6.colB FROM test_4 JOIN test_6 ON test_4.colA = test_6.colA;
 TEST_F(ExecutorTest, SimpleHashJoinTest) {
   // Construct sequential scan of table test_4
@@ -10,11 +10,22 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <chrono>  // NOLINT
+#include <cstdio>
 #include <cstring>
+#include <fstream>
+#include <future>  // NOLINT
+#include <memory>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
-#include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_backend.h"
+#include "storage/disk/file_disk_manager.h"
+#include "storage/disk/latency_disk_manager.h"
+#include "storage/disk/memory_disk_manager.h"
 
 namespace bustub {
 
@@ -38,7 +49,7 @@ TEST_F(DiskManagerTest, ReadWritePageTest) {
   char buf[PAGE_SIZE] = {0};
   char data[PAGE_SIZE] = {0};
   std::string db_file("test.db");
-  auto dm = DiskManager(db_file);
+  auto dm = FileDiskManager(db_file);
   std::strncpy(data, "A test string.", sizeof(data));
 
   dm.ReadPage(0, buf);  // tolerate empty read
@@ -55,12 +66,228 @@ TEST_F(DiskManagerTest, ReadWritePageTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ConcurrentReadWritePageTest) {
+  const int num_threads = 4;
+  const int pages_per_thread = 64;
+  FileDiskManager dm("test.db");
+
+  // Each thread owns an interleaved set of pages, writes them, then reads them back while the others still write.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&dm, tid] {
+      char data[PAGE_SIZE];
+      char buf[PAGE_SIZE];
+      for (int i = 0; i < pages_per_thread; i++) {
+        page_id_t page_id = i * num_threads + tid;
+        std::memset(data, page_id % 128, sizeof(data));
+        dm.WritePage(page_id, data);
+      }
+      for (int i = 0; i < pages_per_thread; i++) {
+        page_id_t page_id = i * num_threads + tid;
+        std::memset(data, page_id % 128, sizeof(data));
+        dm.ReadPage(page_id, buf);
+        EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * pages_per_thread, dm.GetNumWrites());
+  EXPECT_EQ(num_threads * pages_per_thread, dm.GetNumReads());
+
+  // Synced pages survive reopening the file.
+  dm.SyncDB();
+  dm.ShutDown();
+  FileDiskManager reopened("test.db");
+  char buf[PAGE_SIZE];
+  char data[PAGE_SIZE];
+  page_id_t last_page_id = num_threads * pages_per_thread - 1;
+  std::memset(data, last_page_id % 128, sizeof(data));
+  reopened.ReadPage(last_page_id, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+  // Reads past the end of the file come back zeroed.
+  std::memset(data, 0, sizeof(data));
+  reopened.ReadPage(last_page_id + 1, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  reopened.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, AsyncReadWritePageTest) {
+  // more requests than the queue depth, so submitters also wait for completions
+  const int num_pages = 4 * IO_URING_QUEUE_DEPTH;
+  FileDiskManager dm("test.db");
+  std::vector<char> data(num_pages * PAGE_SIZE);
+  std::vector<char> buf(num_pages * PAGE_SIZE);
+  for (int i = 0; i < num_pages * PAGE_SIZE; i++) {
+    data[i] = static_cast<char>(i / PAGE_SIZE + i % 7);
+  }
+
+  std::vector<std::future<void>> requests;
+  for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+    requests.push_back(dm.WritePageAsync(page_id, &data[page_id * PAGE_SIZE]));
+  }
+  for (auto &request : requests) {
+    request.wait();
+  }
+  requests.clear();
+  for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+    requests.push_back(dm.ReadPageAsync(page_id, &buf[page_id * PAGE_SIZE]));
+  }
+  for (auto &request : requests) {
+    request.wait();
+  }
+  EXPECT_EQ(data, buf);
+
+  // an async read past the end of the file completes with a zeroed page
+  char page[PAGE_SIZE];
+  char zeros[PAGE_SIZE] = {0};
+  std::memset(page, 1, sizeof(page));
+  dm.ReadPageAsync(num_pages + 1, page).wait();
+  EXPECT_EQ(std::memcmp(page, zeros, sizeof(page)), 0);
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, AllocateDeallocatePageTest) {
+  auto *dm = new FileDiskManager("test.db");
+  for (page_id_t i = 0; i < 10; i++) {
+    EXPECT_EQ(i, dm->AllocatePage());
+  }
+
+  // Freed pages are reused lowest first, before the file is extended.
+  dm->DeallocatePage(7);
+  dm->DeallocatePage(3);
+  dm->DeallocatePage(3);
+  EXPECT_EQ(2, dm->GetNumFreePages());
+  EXPECT_EQ(3, dm->AllocatePage());
+  EXPECT_EQ(7, dm->AllocatePage());
+  EXPECT_EQ(10, dm->AllocatePage());
+
+  // Page ids of a parallel pool instance keep their residue, skipped ids are left for the other instances.
+  dm->DeallocatePage(4);
+  EXPECT_EQ(13, dm->AllocatePage(4, 1));
+  EXPECT_EQ(3, dm->GetNumFreePages());
+  EXPECT_EQ(4, dm->AllocatePage(4, 0));
+  EXPECT_EQ(11, dm->AllocatePage(4, 3));
+  EXPECT_EQ(12, dm->AllocatePage(4, 0));
+  EXPECT_EQ(0, dm->GetNumFreePages());
+
+  // The free space map is persistent.
+  dm->DeallocatePage(5);
+  char data[PAGE_SIZE] = {0};
+  dm->WritePage(13, data);
+  dm->ShutDown();
+  delete dm;
+  dm = new FileDiskManager("test.db");
+  EXPECT_EQ(1, dm->GetNumFreePages());
+  EXPECT_EQ(5, dm->AllocatePage());
+  EXPECT_EQ(14, dm->AllocatePage());
+  dm->ShutDown();
+  delete dm;
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, FileFormatTest) {
+  char data[PAGE_SIZE] = {0};
+  char buf[PAGE_SIZE] = {0};
+  std::strncpy(data, "A test string.", sizeof(data));
+  auto *dm = new FileDiskManager("test.db");
+  page_id_t page_id = dm->AllocatePage();
+  dm->WritePage(page_id, data);
+  dm->ShutDown();
+  delete dm;
+
+  // A file written by this version opens again, even when it was not shut down: SyncDB() persists allocations too.
+  dm = new FileDiskManager("test.db");
+  dm->ReadPage(page_id, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  EXPECT_EQ(page_id + 1, dm->AllocatePage());
+  dm->SyncDB();
+  std::ifstream copy_in("test.db", std::ios::binary);
+  std::ofstream copy_out("test_copy.db", std::ios::binary | std::ios::trunc);
+  copy_out << copy_in.rdbuf();
+  copy_out.close();
+  dm->ShutDown();
+  delete dm;
+  dm = new FileDiskManager("test_copy.db");
+  EXPECT_EQ(0, dm->GetNumFreePages());
+  EXPECT_EQ(page_id + 2, dm->AllocatePage());
+  dm->ShutDown();
+  delete dm;
+  remove("test_copy.db");
+  remove("test_copy.log");
+
+  // A file of another format is refused rather than misread.
+  std::fstream file("test.db", std::ios::binary | std::ios::in | std::ios::out);
+  file.seekp(0);
+  file.write(data, sizeof(data));
+  file.close();
+  EXPECT_THROW(FileDiskManager("test.db"), Exception);
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ShutDownWithIOInFlightTest) {
+  const int num_pages = 256;
+  FileDiskManager dm("test.db");
+  std::vector<char> data(num_pages * PAGE_SIZE, 'x');
+  std::vector<std::future<void>> writes;
+  std::thread writer([&] {
+    for (int i = 0; i < num_pages; i++) {
+      writes.push_back(dm.WritePageAsync(i, &data[i * PAGE_SIZE]));
+    }
+  });
+  dm.ShutDown();
+  writer.join();
+  // the writes before the shutdown completed, the ones after it were dropped
+  for (auto &write : writes) {
+    EXPECT_EQ(std::future_status::ready, write.wait_for(std::chrono::seconds(10)));
+  }
+  char buf[PAGE_SIZE];
+  std::memset(buf, 'y', sizeof(buf));
+  dm.ReadPage(0, buf);
+  EXPECT_EQ(0, buf[0]);
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, WritePagesTest) {
+  FileDiskManager dm("test.db");
+  // two adjacent runs, a lone page and a run that crosses into the range of the next free space map page
+  const page_id_t boundary = PAGE_SIZE * 8;
+  std::vector<page_id_t> page_ids{9, 3, 4, 5, 20, 6, 10, boundary - 2, boundary - 1, boundary, boundary + 1};
+  std::vector<char> data(page_ids.size() * PAGE_SIZE);
+  std::vector<std::pair<page_id_t, const char *>> pages;
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    snprintf(&data[i * PAGE_SIZE], PAGE_SIZE, "page-%d", page_ids[i]);
+    pages.emplace_back(page_ids[i], &data[i * PAGE_SIZE]);
+  }
+  EXPECT_FALSE(dm.IsAdjacent(boundary - 1, boundary));
+  EXPECT_TRUE(dm.IsAdjacent(boundary, boundary + 1));
+
+  dm.WritePages(pages);
+  EXPECT_EQ(static_cast<int>(page_ids.size()), dm.GetNumWrites());
+  char buf[PAGE_SIZE];
+  char expected[PAGE_SIZE];
+  for (auto page_id : page_ids) {
+    dm.ReadPage(page_id, buf);
+    snprintf(expected, PAGE_SIZE, "page-%d", page_id);
+    EXPECT_STREQ(expected, buf);
+  }
+  // pages in the gaps were not touched
+  dm.ReadPage(7, buf);
+  EXPECT_EQ(0, buf[0]);
+  dm.ShutDown();
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ReadWriteLogTest) {
   char buf[16] = {0};
   char data[16] = {0};
   std::string db_file("test.db");
-  auto dm = DiskManager(db_file);
+  auto dm = FileDiskManager(db_file);
   std::strncpy(data, "A test string.", sizeof(data));
 
   dm.ReadLog(buf, sizeof(buf), 0);  // tolerate empty read
@@ -73,6 +300,91 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
 }
 
 // NOLINTNEXTLINE
-TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
+TEST_F(DiskManagerTest, MemoryBackendTest) {
+  std::unique_ptr<DiskManager> dm = CreateDiskManager("test.db", DiskBackend::MEMORY);
+  char buf[PAGE_SIZE];
+  char data[PAGE_SIZE] = {0};
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  page_id_t page_id = dm->AllocatePage();
+  dm->WritePage(page_id, data);
+  dm->ReadPage(page_id, buf);
+  EXPECT_EQ(0, std::memcmp(buf, data, sizeof(buf)));
+  std::vector<const char *> run{data, data};
+  dm->WritePagesAsync(7, run).wait();
+  dm->ReadPage(8, buf);
+  EXPECT_EQ(0, std::memcmp(buf, data, sizeof(buf)));
+  EXPECT_EQ(3, dm->GetNumWrites());
+
+  // deallocated pages are dropped and read as zeros, like pages that were never written
+  dm->DeallocatePage(page_id);
+  dm->ReadPage(page_id, buf);
+  EXPECT_EQ(0, buf[0]);
+  dm->ReadPage(100, buf);
+  EXPECT_EQ(0, buf[0]);
+  EXPECT_EQ(page_id, dm->AllocatePage());
+
+  char log[16] = {0};
+  EXPECT_FALSE(dm->ReadLog(log, sizeof(log), 0));
+  dm->WriteLog(data, sizeof(log));
+  EXPECT_TRUE(dm->ReadLog(log, sizeof(log), 0));
+  EXPECT_EQ(0, std::memcmp(log, data, sizeof(log)));
+  EXPECT_FALSE(std::ifstream("test.db").good());
+  dm->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, LatencyBackendTest) {
+  using std::chrono::milliseconds;
+  using std::chrono::microseconds;
+  const DeviceProfile profile{milliseconds(10), milliseconds(5), milliseconds(20), 4 * PAGE_SIZE * 1000, 2};
+  LatencyDiskManager dm(std::make_unique<MemoryDiskManager>(), profile);
+  char data[PAGE_SIZE] = {0};
+  char buf[PAGE_SIZE];
+  std::strncpy(data, "A test string.", sizeof(data));
+  auto elapsed_since = [](std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<microseconds>(std::chrono::steady_clock::now() - start);
+  };
+
+  // a single request pays its latency
+  auto start = std::chrono::steady_clock::now();
+  dm.WritePage(0, data);
+  EXPECT_GE(elapsed_since(start), milliseconds(5));
+  start = std::chrono::steady_clock::now();
+  dm.ReadPage(0, buf);
+  EXPECT_GE(elapsed_since(start), milliseconds(10));
+  EXPECT_EQ(0, std::memcmp(buf, data, sizeof(buf)));
+
+  // four reads on two queue slots take two rounds
+  std::vector<std::vector<char>> bufs(4, std::vector<char>(PAGE_SIZE));
+  std::vector<std::future<void>> reads;
+  start = std::chrono::steady_clock::now();
+  for (auto &read_buf : bufs) {
+    reads.push_back(dm.ReadPageAsync(0, read_buf.data()));
+  }
+  for (auto &read : reads) {
+    read.wait();
+  }
+  EXPECT_GE(elapsed_since(start), milliseconds(20));
+  EXPECT_LT(elapsed_since(start), milliseconds(40));
+
+  // 64 pages at 4 pages per millisecond are limited by the bandwidth, not the latency
+  std::vector<const char *> run(64, data);
+  start = std::chrono::steady_clock::now();
+  dm.WritePagesAsync(1, run).wait();
+  EXPECT_GE(elapsed_since(start), milliseconds(16));
+
+  start = std::chrono::steady_clock::now();
+  dm.SyncDB();
+  EXPECT_GE(elapsed_since(start), milliseconds(20));
+  EXPECT_EQ(65, dm.GetNumWrites());
+  EXPECT_EQ(5, dm.GetNumReads());
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ThrowBadFileTest) {
+  EXPECT_THROW(FileDiskManager("dev/null\\/foo/bar/baz/test.db"), Exception);
+}
 
 }  // namespace bustub
@@ -11,16 +11,20 @@
 //===----------------------------------------------------------------------===//
 
 #include <algorithm>
+#include <atomic>
 #include <cstdio>
 #include <iostream>
 #include <string>
+#include <thread>  // NOLINT
 #include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "gtest/gtest.h"
 #include "logging/common.h"
+#include "storage/disk/disk_backend.h"
 #include "storage/table/table_heap.h"
 #include "storage/table/tuple.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 // NOLINTNEXTLINE
@@ -38,7 +42,7 @@ TEST(TupleTest, DISABLED_TableHeapTest) {
 
   // create transaction
   auto *transaction = new Transaction(0);
-  auto *disk_manager = new DiskManager("test.db");
+  auto *disk_manager = CreateDiskManager("test.db").release();
   auto *buffer_pool_manager = new BufferPoolManagerInstance(50, disk_manager);
   auto *lock_manager = new LockManager();
   auto *log_manager = new LogManager(disk_manager);
@@ -71,4 +75,107 @@ TEST(TupleTest, DISABLED_TableHeapTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(TupleTest, TableIteratorReadaheadTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 1000};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = CreateDiskManager("test.db").release();
+  // The table is several times the pool, so the scan runs on prefetched and evicted pages.
+  auto *buffer_pool_manager = new BufferPoolManagerInstance(10, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction);
+
+  const int num_tuples = 200;
+  for (int i = 0; i < num_tuples; ++i) {
+    std::vector<Value> values{ValueFactory::GetIntegerValue(i),
+                              ValueFactory::GetVarcharValue(std::string(900, static_cast<char>('a' + i % 26)))};
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(Tuple(values, &schema), &rid, transaction));
+  }
+
+  for (int round = 0; round < 2; round++) {
+    int i = 0;
+    for (auto itr = table->Begin(transaction); itr != table->End(); ++itr, ++i) {
+      ASSERT_EQ(i, itr->GetValue(&schema, 0).GetAs<int32_t>());
+      EXPECT_EQ(static_cast<char>('a' + i % 26), itr->GetValue(&schema, 1).ToString()[0]);
+    }
+    EXPECT_EQ(num_tuples, i);
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  delete table;
+  delete buffer_pool_manager;
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
+// NOLINTNEXTLINE
+TEST(TupleTest, TableIteratorConcurrentWriterTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 1000};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = CreateDiskManager("table_iterator_test.db").release();
+  auto *buffer_pool_manager = new BufferPoolManagerInstance(10, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *table = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction);
+
+  const int num_tuples = 50;
+  const int num_appended = 300;
+  auto make_tuple = [&schema](int i) {
+    std::vector<Value> values{ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(std::string(300, 'x'))};
+    return Tuple(values, &schema);
+  };
+  for (int i = 0; i < num_tuples; ++i) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(make_tuple(i), &rid, transaction));
+  }
+
+  // The writer keeps write-latching the last page while the scan reads it.
+  std::atomic<bool> done{false};
+  std::thread writer([&] {
+    Transaction writer_txn(1);
+    for (int i = num_tuples; i < num_tuples + num_appended; ++i) {
+      RID rid;
+      EXPECT_TRUE(table->InsertTuple(make_tuple(i), &rid, &writer_txn));
+    }
+    done = true;
+  });
+  while (!done) {
+    int i = 0;
+    for (auto itr = table->Begin(transaction); itr != table->End(); ++itr, ++i) {
+      ASSERT_EQ(i, itr->GetValue(&schema, 0).GetAs<int32_t>());
+    }
+    EXPECT_LE(num_tuples, i);
+  }
+  writer.join();
+  int i = 0;
+  for (auto itr = table->Begin(transaction); itr != table->End(); ++itr) {
+    i++;
+  }
+  EXPECT_EQ(num_tuples + num_appended, i);
+
+  disk_manager->ShutDown();
+  remove("table_iterator_test.db");
+  remove("table_iterator_test.log");
+  delete table;
+  delete buffer_pool_manager;
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
 }  // namespace bustub